@@ -25,7 +25,59 @@
     #error WORD_BIT_SIZE must be one of: 8, 16, 32, 64
 #endif
 
-// override these with calls to your memory management scheme
+// redefine these macros to tune when multiplication switches algorithms.
+// both operands must be at least this many words long for the algorithm
+// to be used.
+#ifndef YABI_KARATSUBA_THRESHOLD
+#define YABI_KARATSUBA_THRESHOLD 32
+#endif
+// squaring computes each cross product once, so its basecase stays faster
+// for longer
+#ifndef YABI_SQR_KARATSUBA_THRESHOLD
+#define YABI_SQR_KARATSUBA_THRESHOLD 64
+#endif
+#ifndef YABI_TOOM3_THRESHOLD
+#define YABI_TOOM3_THRESHOLD 96
+#endif
+#ifndef YABI_NTT_THRESHOLD
+#define YABI_NTT_THRESHOLD 2048
+#endif
+// divisors and quotients of at least this many words are divided
+// recursively, which pays off once multiplication is subquadratic
+#ifndef YABI_DC_DIV_THRESHOLD
+#define YABI_DC_DIV_THRESHOLD 64
+#endif
+// numbers of at least this many words are converted to and from decimal
+// by recursively splitting them at powers of ten
+#ifndef YABI_DC_STR_THRESHOLD
+#define YABI_DC_STR_THRESHOLD 16
+#endif
+// once yabi_set_threads or yabi_set_executor has provided threads, work on
+// operands of at least this many words is split into tasks for them
+#ifndef YABI_PARALLEL_THRESHOLD
+#define YABI_PARALLEL_THRESHOLD 1024
+#endif
+// the widest vector instructions the linear passes may use on x86: 0 for
+// none, 1 for SSE2, 2 for AVX2 and 3 for AVX-512. Up to this, the widest
+// the processor supports is picked at runtime
+#ifndef YABI_SIMD_LEVEL
+#define YABI_SIMD_LEVEL 3
+#endif
+#if YABI_KARATSUBA_THRESHOLD < 8
+    #error YABI_KARATSUBA_THRESHOLD must be at least 8
+#endif
+#if YABI_SQR_KARATSUBA_THRESHOLD < 8
+    #error YABI_SQR_KARATSUBA_THRESHOLD must be at least 8
+#endif
+#if YABI_DC_DIV_THRESHOLD < 8
+    #error YABI_DC_DIV_THRESHOLD must be at least 8
+#endif
+
+// override these with calls to your memory management scheme. The BigInt
+// macros work in words: YABI_NEW_BIGINT returns room for `siz` of them, and
+// YABI_RESIZE_BIGINT moves `p` to room for `siz`, keeping the words both
+// sizes share, and sets its len to `siz`. The library sets refCount and cap
+// itself after every call, so an override need not know about them
 #ifndef YABI_MALLOC
 #define YABI_MALLOC(siz) (malloc(siz))
 #endif
@@ -38,16 +90,46 @@
 #ifndef YABI_FREE
 #define YABI_FREE(p) (free(p))
 #endif
+// define YABI_POOL to take BigInts from the built-in pool allocator, see
+// yabi_pool_reset
+#ifdef YABI_POOL
+#ifndef YABI_NEW_BIGINT
+#define YABI_NEW_BIGINT(siz) (yabi_pool_new(siz))
+#endif
+#ifndef YABI_RESIZE_BIGINT
+#define YABI_RESIZE_BIGINT(p, siz) do { (p) = yabi_pool_resize(p, siz); } while(0)
+#endif
+#ifndef YABI_FREE_BIGINT
+#define YABI_FREE_BIGINT(p) (yabi_pool_free(p))
+#endif
+#endif
 #ifndef YABI_NEW_BIGINT
 #define YABI_NEW_BIGINT(siz) (YABI_MALLOC(sizeof(BigInt) + (siz) * sizeof(WordType)))
 #endif
 #ifndef YABI_RESIZE_BIGINT
 #define YABI_RESIZE_BIGINT(p, siz) do { (p) = YABI_REALLOC(p, sizeof(BigInt) + (siz) * sizeof(WordType)); (p)->len = (siz); } while(0)
 #endif
+#ifndef YABI_FREE_BIGINT
+#define YABI_FREE_BIGINT(p) (YABI_FREE(p))
+#endif
+
+// C++ has no restrict, but its compilers know it by this name
+#ifdef __cplusplus
+#define YABI_RESTRICT __restrict
+#else
+#define YABI_RESTRICT restrict
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef struct BigInt {
+   // number of owners besides the first, see yabi_retain
    size_t refCount;
    size_t len;
+   // number of words allocated for data, at least len
+   size_t cap;
    WordType data[];
 } BigInt;
 
@@ -62,9 +144,69 @@ typedef union ydiv {
     };
 } ydiv_t;
 
+/**
+ * Reference counting. Every BigInt starts out with a single owner.
+ * yabi_retain adds an owner and returns `a`, and yabi_release drops one,
+ * freeing `a` when none are left; it ignores NULL. The _into functions
+ * below only write into a BigInt that has a single owner, and otherwise
+ * release theirs and store a fresh one, so a shared value is never changed
+ * under its other owners. Define YABI_ATOMIC_REFCOUNT to share BigInts
+ * between threads.
+ */
+BigInt* yabi_retain(BigInt* a);
+void yabi_release(BigInt* a);
+
+/**
+ * The pool allocator, which YABI_POOL plugs into YABI_NEW_BIGINT and
+ * friends. BigInts come in power of two size classes carved from chunks
+ * that belong to the allocating thread, and freed ones are kept on that
+ * thread's free lists for reuse. Resizing within a size class, such as the
+ * shrink after every operation, does not move the BigInt. BigInts from the
+ * pool must be freed with yabi_release or yabi_pool_free, on any thread.
+ *
+ * yabi_pool_reset frees everything the calling thread has taken from the
+ * pool at once, for arena style lifetimes such as one request. None of
+ * those BigInts may be used afterwards. BigInts stay valid after the
+ * thread that took them exits and may still be freed anywhere. Its cache,
+ * with all of its memory, is handed to the next thread that uses the pool,
+ * whose yabi_pool_reset then covers it as well.
+ */
+BigInt* yabi_pool_new(size_t len);
+BigInt* yabi_pool_resize(BigInt* a, size_t len);
+void yabi_pool_free(BigInt* a);
+void yabi_pool_reset(void);
+
+/**
+ * Threads for large operations. Multiplications, divisions and radix
+ * conversions of at least YABI_PARALLEL_THRESHOLD words split their
+ * independent sub-products and halves into tasks, which spread over the
+ * threads by work stealing. Smaller operations stay on the calling thread
+ * and never synchronize. Tasks allocate their own scratch, so a call that
+ * splits may allocate even with a long enough workspace.
+ *
+ * yabi_set_threads(n) starts a pool of n - 1 worker threads, which any
+ * thread calling into the library joins while it waits for its tasks. An
+ * n of 1 or less stops it, which is the default. It returns 0, or -1 when
+ * the threads could not be started, leaving no pool.
+ *
+ * yabi_set_executor hands tasks to `submit` instead, which must see to it
+ * that `task(arg)` is called exactly once, on any thread and at any time.
+ * A thread that needs a task that has not started yet runs it itself, so
+ * the executor never holds anything up. NULL turns it off.
+ *
+ * Each of the two replaces the other, and neither may be called while
+ * another thread is in the library. Define YABI_NO_THREADS to build
+ * without a thread library, which leaves only the executor.
+ */
+typedef void (*yabi_task_fn)(void* arg);
+typedef void (*yabi_executor_fn)(yabi_task_fn task, void* arg, void* ctx);
+int yabi_set_threads(int n);
+void yabi_set_executor(yabi_executor_fn submit, void* ctx);
+
 BigInt* yabi_add(const BigInt* a, const BigInt* b);
 BigInt* yabi_sub(const BigInt* a, const BigInt* b);
 BigInt* yabi_mul(const BigInt* a, const BigInt* b);
+BigInt* yabi_sqr(const BigInt* a);
 ydiv_t yabi_div(const BigInt* a, const BigInt* b);
 BigInt* yabi_negate(const BigInt* a);
 
@@ -79,6 +221,19 @@ BigInt* yabi_or(const BigInt* a, const BigInt* b);
 BigInt* yabi_xor(const BigInt* a, const BigInt* b);
 BigInt* yabi_compl(const BigInt* a);
 
+/**
+ * Operations with a native integer as the second operand, which saves
+ * building a BigInt for it. Their ToBuf forms below work like the others.
+ */
+BigInt* yabi_add_si(const BigInt* a, int64_t b);
+BigInt* yabi_add_ui(const BigInt* a, uint64_t b);
+BigInt* yabi_sub_si(const BigInt* a, int64_t b);
+BigInt* yabi_sub_ui(const BigInt* a, uint64_t b);
+BigInt* yabi_mul_si(const BigInt* a, int64_t b);
+BigInt* yabi_mul_ui(const BigInt* a, uint64_t b);
+int yabi_cmp_si(const BigInt* a, int64_t b);
+int yabi_cmp_ui(const BigInt* a, uint64_t b);
+
 /*
  * The following functions let you provide your own buffer (that need not
  * even be a BigInt). These functions behave as if the given operation
@@ -97,6 +252,7 @@ BigInt* yabi_compl(const BigInt* a);
 size_t yabi_addToBuf(const BigInt* a, const BigInt* b, size_t len, WordType* buffer);
 size_t yabi_subToBuf(const BigInt* a, const BigInt* b, size_t len, WordType* buffer);
 size_t yabi_mulToBuf(const BigInt* a, const BigInt* b, size_t len, WordType* buffer);
+size_t yabi_sqrToBuf(const BigInt* a, size_t len, WordType* buffer);
 ydiv_t yabi_divToBuf(const BigInt* a, const BigInt* b, size_t qlen, WordType* qbuffer, size_t rlen, WordType* rbuffer);
 size_t yabi_negateToBuf(const BigInt* a, size_t len, WordType* buffer);
 
@@ -108,6 +264,100 @@ size_t yabi_orToBuf(const BigInt* a, const BigInt* b, size_t len, WordType* buff
 size_t yabi_xorToBuf(const BigInt* a, const BigInt* b, size_t len, WordType* buffer);
 size_t yabi_complToBuf(const BigInt* a, size_t len, WordType* buffer);
 
+size_t yabi_add_siToBuf(const BigInt* a, int64_t b, size_t len, WordType* buffer);
+size_t yabi_add_uiToBuf(const BigInt* a, uint64_t b, size_t len, WordType* buffer);
+size_t yabi_sub_siToBuf(const BigInt* a, int64_t b, size_t len, WordType* buffer);
+size_t yabi_sub_uiToBuf(const BigInt* a, uint64_t b, size_t len, WordType* buffer);
+size_t yabi_mul_siToBuf(const BigInt* a, int64_t b, size_t len, WordType* buffer);
+size_t yabi_mul_uiToBuf(const BigInt* a, uint64_t b, size_t len, WordType* buffer);
+
+/**
+ * Scratch space for the ToBuf functions that need temporaries, which they
+ * otherwise allocate. The _scratch functions give the number of words a
+ * call needs at most, given the `len` of its operands, or for
+ * yabi_fromStr_scratch the number of digits. With a workspace at least
+ * that long the Ws form of the call does not allocate at all; a shorter
+ * one, or NULL, makes it allocate as usual. A workspace keeps nothing
+ * between calls, so one can serve every call on a thread.
+ */
+typedef struct yabi_workspace {
+    size_t len;
+    WordType* data;
+} yabi_workspace_t;
+
+size_t yabi_mul_scratch(size_t alen, size_t blen);
+size_t yabi_sqr_scratch(size_t alen);
+size_t yabi_div_scratch(size_t alen, size_t blen);
+size_t yabi_fromStr_scratch(size_t digits, int base);
+size_t yabi_toStr_scratch(size_t alen, int base);
+
+size_t yabi_mulToBufWs(const BigInt* a, const BigInt* b, size_t len, WordType* buffer, yabi_workspace_t* ws);
+size_t yabi_sqrToBufWs(const BigInt* a, size_t len, WordType* buffer, yabi_workspace_t* ws);
+ydiv_t yabi_divToBufWs(const BigInt* a, const BigInt* b, size_t qlen, WordType* qbuffer, size_t rlen, WordType* rbuffer, yabi_workspace_t* ws);
+size_t yabi_fromStrRadixToBufWs(const char* YABI_RESTRICT str, int base, size_t len, WordType* buffer, yabi_workspace_t* ws);
+size_t yabi_toBufRadixWs(const BigInt* a, int base, size_t len, char* YABI_RESTRICT buffer, yabi_workspace_t* ws);
+
+/**
+ * Batches of fixed size integers, for columns of many values of the same
+ * `len` words. Each value is a two's complement number, minimal or not.
+ * Word j of value i is data[i * lane + j * word], so an array of values
+ * has lane = len and word = 1, and an array of columns, one for each word
+ * position, has lane = 1 and word = the column length. Each result goes
+ * into rlen words of `r`, truncated or sign extended as with the ToBuf
+ * functions, and yabi_batch_cmp stores -1, 0 or 1 for each value. `r` may
+ * be `a` or `b` when rlen is len.
+ *
+ * When every batch is in columns, additions, subtractions and comparisons
+ * go across the values in vector registers, each lane with a carry of its
+ * own, and the bitwise operations go a column at a time. Nothing is
+ * allocated, except by yabi_batch_mul for values long enough for
+ * subquadratic multiplication.
+ */
+typedef struct yabi_batch {
+    WordType* data;
+    size_t lane;
+    size_t word;
+} yabi_batch_t;
+
+void yabi_batch_add(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r);
+void yabi_batch_sub(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r);
+void yabi_batch_mul(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r);
+void yabi_batch_and(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r);
+void yabi_batch_or(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r);
+void yabi_batch_xor(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r);
+void yabi_batch_compl(size_t count, size_t len, const yabi_batch_t* a, size_t rlen, const yabi_batch_t* r);
+void yabi_batch_cmp(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, int8_t* r);
+
+/*
+ * The following functions store their result in `*dst`, which they reuse
+ * when it has room for the result and grow otherwise. They never shrink
+ * it, so a variable that is updated over and over stops allocating once it
+ * has reached its working size. `*dst` may be NULL, in which case a new
+ * BigInt is allocated, and it may be one of the operands. They return the
+ * new `*dst`.
+ */
+BigInt* yabi_add_into(BigInt** dst, const BigInt* a, const BigInt* b);
+BigInt* yabi_sub_into(BigInt** dst, const BigInt* a, const BigInt* b);
+BigInt* yabi_mul_into(BigInt** dst, const BigInt* a, const BigInt* b);
+BigInt* yabi_sqr_into(BigInt** dst, const BigInt* a);
+BigInt* yabi_negate_into(BigInt** dst, const BigInt* a);
+BigInt* yabi_lshift_into(BigInt** dst, const BigInt* a, size_t amt);
+BigInt* yabi_rshift_into(BigInt** dst, const BigInt* a, size_t amt);
+BigInt* yabi_and_into(BigInt** dst, const BigInt* a, const BigInt* b);
+BigInt* yabi_or_into(BigInt** dst, const BigInt* a, const BigInt* b);
+BigInt* yabi_xor_into(BigInt** dst, const BigInt* a, const BigInt* b);
+BigInt* yabi_compl_into(BigInt** dst, const BigInt* a);
+BigInt* yabi_add_si_into(BigInt** dst, const BigInt* a, int64_t b);
+BigInt* yabi_add_ui_into(BigInt** dst, const BigInt* a, uint64_t b);
+BigInt* yabi_sub_si_into(BigInt** dst, const BigInt* a, int64_t b);
+BigInt* yabi_sub_ui_into(BigInt** dst, const BigInt* a, uint64_t b);
+BigInt* yabi_mul_si_into(BigInt** dst, const BigInt* a, int64_t b);
+BigInt* yabi_mul_ui_into(BigInt** dst, const BigInt* a, uint64_t b);
+// *dst += a * b and *dst -= a * b, without a temporary for the product
+// unless the operands are large enough for subquadratic multiplication
+BigInt* yabi_addmul(BigInt** dst, const BigInt* a, const BigInt* b);
+BigInt* yabi_submul(BigInt** dst, const BigInt* a, const BigInt* b);
+
 WordType yabi_toUnsigned(const BigInt* a);
 SWordType yabi_toSigned(const BigInt* a);
 size_t yabi_toSize(const BigInt* a);
@@ -117,9 +367,154 @@ size_t yabi_toSize(const BigInt* a);
  * numeric (base 10), optionally starting with an ASCII minus sign.
  */
 BigInt* yabi_fromStr(const char* str);
-size_t yabi_fromStrToBuf(const char* restrict str, size_t len, WordType* buffer);
+size_t yabi_fromStrToBuf(const char* YABI_RESTRICT str, size_t len, WordType* buffer);
 
 char* yabi_toStr(const BigInt* a);
-size_t yabi_toBuf(const BigInt* a, size_t len, char* restrict buffer);
+size_t yabi_toBuf(const BigInt* a, size_t len, char* YABI_RESTRICT buffer);
+
+/**
+ * Same as the decimal functions above, in any base from 2 to 36. Digits
+ * past 9 are the letters a-z, in either case. Output is lowercase.
+ * Power of two bases are converted by packing bits, in linear time.
+ * An invalid base makes them return NULL or 0.
+ */
+BigInt* yabi_fromStrRadix(const char* str, int base);
+size_t yabi_fromStrRadixToBuf(const char* YABI_RESTRICT str, int base, size_t len, WordType* buffer);
+
+char* yabi_toStrRadix(const BigInt* a, int base);
+size_t yabi_toBufRadix(const BigInt* a, int base, size_t len, char* YABI_RESTRICT buffer);
+
+/**
+ * Division by an unsigned 64 bit d. When d fits in a word it is done in one
+ * pass that multiplies by the reciprocal of d, wider divisors go through the
+ * general division. Unlike yabi_div, the quotient is rounded toward negative
+ * infinity, so the remainder is in [0, d). It is stored in `rem` unless that
+ * is NULL. Dividing by 0 returns NULL or 0.
+ */
+BigInt* yabi_divmod_ui(const BigInt* a, uint64_t d, uint64_t* rem);
+size_t yabi_divmod_uiToBuf(const BigInt* a, uint64_t d, uint64_t* rem, size_t len, WordType* buffer);
+uint64_t yabi_mod_ui(const BigInt* a, uint64_t d);
+
+/**
+ * A divisor prepared for dividing many numbers by it. It keeps its magnitude
+ * normalized, and a reciprocal of its top word so that one word divisors
+ * divide by multiplying. The ToBuf functions do not allocate, since the
+ * divisor owns the scratch space they work in, so it must not be shared
+ * between threads. Results are the same as yabi_div and yabi_divToBuf give.
+ */
+typedef struct yabi_divisor {
+    size_t n;
+    int negative;
+    int shift;
+    // the magnitude of the divisor, n words
+    WordType* mag;
+    // the magnitude shifted up by `shift` until its top bit is set
+    WordType* norm;
+    // reciprocal of the top word of norm, see wordInverse
+    WordType inv;
+    WordType* scratch;
+} yabi_divisor_t;
+
+// returns NULL for a divisor of 0
+yabi_divisor_t* yabi_divisor_init(const BigInt* d);
+void yabi_divisor_free(yabi_divisor_t* d);
+ydiv_t yabi_divPre(const BigInt* a, yabi_divisor_t* d);
+ydiv_t yabi_divPreToBuf(const BigInt* a, yabi_divisor_t* d, size_t qlen, WordType* qbuffer, size_t rlen, WordType* rbuffer);
+// the remainder of yabi_divPre, which takes the sign of a
+BigInt* yabi_modPre(const BigInt* a, yabi_divisor_t* d);
+size_t yabi_modPreToBuf(const BigInt* a, yabi_divisor_t* d, size_t len, WordType* buffer);
+
+/**
+ * Montgomery context for arithmetic modulo an odd modulus m > 0 of n words.
+ * Numbers in Montgomery form are unsigned buffers of n words holding
+ * x * R mod m, where R = 2^(n * YABI_WORD_BIT_SIZE). The context owns the
+ * scratch space every operation works in, so it must not be shared between
+ * threads. Buffers passed to mulmod and sqrmod must hold values below m, and
+ * may be the same as the result buffer.
+ */
+typedef struct yabi_mont {
+    size_t n;
+    // -m^-1 mod 2^YABI_WORD_BIT_SIZE
+    WordType minv;
+    WordType* mod;
+    // the modulus shifted up until its top bit is set
+    WordType* norm;
+    // R mod m, which is 1 in Montgomery form
+    WordType* one;
+    // R^2 mod m, for converting into Montgomery form
+    WordType* r2;
+    WordType* scratch;
+} yabi_mont_t;
+
+// returns NULL unless the modulus is odd and positive
+yabi_mont_t* yabi_mont_init(const BigInt* modulus);
+void yabi_mont_free(yabi_mont_t* ctx);
+// converts any a into its Montgomery form of ctx->n words
+void yabi_mont_to(yabi_mont_t* ctx, const BigInt* a, WordType* buffer);
+size_t yabi_mont_fromToBuf(yabi_mont_t* ctx, const WordType* a, size_t len, WordType* buffer);
+BigInt* yabi_mont_from(yabi_mont_t* ctx, const WordType* a);
+void yabi_mont_mulmod(yabi_mont_t* ctx, const WordType* a, const WordType* b, WordType* buffer);
+void yabi_mont_sqrmod(yabi_mont_t* ctx, const WordType* a, WordType* buffer);
+/**
+ * Computes base^exp mod m by sliding window exponentiation, entirely in the
+ * context's scratch space, and stores it like the ToBuf functions. The
+ * exponent must not be negative, or 0 is returned. yabi_powmod sets up a
+ * context for a single call, and returns NULL if it could not.
+ */
+size_t yabi_mont_powmod(yabi_mont_t* ctx, const BigInt* base, const BigInt* exp, size_t len, WordType* buffer);
+BigInt* yabi_powmod(const BigInt* base, const BigInt* exp, const BigInt* mod);
+
+/**
+ * The greatest common divisor of a and b, which is never negative, and 0
+ * only if both are. yabi_gcdext also stores cofactors s and t such that
+ * gcd = a * s + b * t in `s` and `t`, unless they are NULL. yabi_invert
+ * finds the inverse of a modulo m, in [0, |m|), and returns NULL or 0 if
+ * there is none or m is 0. The ToBuf and Ws forms work like the others.
+ */
+BigInt* yabi_gcd(const BigInt* a, const BigInt* b);
+size_t yabi_gcdToBuf(const BigInt* a, const BigInt* b, size_t len, WordType* buffer);
+size_t yabi_gcd_scratch(size_t alen, size_t blen);
+size_t yabi_gcdToBufWs(const BigInt* a, const BigInt* b, size_t len, WordType* buffer, yabi_workspace_t* ws);
+BigInt* yabi_gcdext(const BigInt* a, const BigInt* b, BigInt** s, BigInt** t);
+BigInt* yabi_invert(const BigInt* a, const BigInt* m);
+size_t yabi_invertToBuf(const BigInt* a, const BigInt* m, size_t len, WordType* buffer);
+size_t yabi_invert_scratch(size_t alen, size_t mlen);
+size_t yabi_invertToBufWs(const BigInt* a, const BigInt* m, size_t len, WordType* buffer, yabi_workspace_t* ws);
+
+/**
+ * A one word handle for integers that are usually small. Values that fit
+ * in a machine word less one bit are stored in the handle itself and never
+ * touch the heap; larger ones are held in a BigInt. Arithmetic on two
+ * inline values runs on native integers and only promotes to a BigInt on
+ * overflow, and results that fit are demoted again. Every function returns
+ * a new handle, which the caller releases with yabi_int_release.
+ */
+typedef struct yabi_int {
+    // an odd value holds the integer shifted left by one, an even one
+    // points at a BigInt
+    uintptr_t bits;
+} yabi_int_t;
+
+yabi_int_t yabi_int_from_si(int64_t v);
+// takes over the caller's reference to `a`
+yabi_int_t yabi_int_from_big(BigInt* a);
+// returns a reference to a BigInt with the value of x, which the caller
+// releases
+BigInt* yabi_int_to_big(yabi_int_t x);
+// returns 1 and stores the value if it fits in an int64_t
+int yabi_int_get_si(yabi_int_t x, int64_t* v);
+int yabi_int_is_small(yabi_int_t x);
+yabi_int_t yabi_int_retain(yabi_int_t x);
+void yabi_int_release(yabi_int_t x);
+
+yabi_int_t yabi_int_add(yabi_int_t a, yabi_int_t b);
+yabi_int_t yabi_int_sub(yabi_int_t a, yabi_int_t b);
+yabi_int_t yabi_int_mul(yabi_int_t a, yabi_int_t b);
+yabi_int_t yabi_int_negate(yabi_int_t a);
+int yabi_int_cmp(yabi_int_t a, yabi_int_t b);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
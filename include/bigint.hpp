@@ -0,0 +1,812 @@
+#ifndef YET_ANOTHER_BIGINT_HPP
+#define YET_ANOTHER_BIGINT_HPP
+#include "bigint.h"
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+#if defined(YABI_ATOMIC_REFCOUNT) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+/*
+ * yabi::Integer owns a BigInt and frees it when it goes away. Values of up
+ * to YABI_INTEGER_INLINE_WORDS words are kept inside the Integer itself and
+ * never touch the heap. Larger ones live in a BigInt that grows
+ * geometrically and is never shrunk, so a variable that is assigned over
+ * and over stops allocating once it has reached its working size.
+ *
+ * The arithmetic operators build expressions, which are evaluated when
+ * they are assigned to an Integer. The result length of the whole
+ * expression is worked out first and reserved in the destination once.
+ * Each operation then writes into the destination with its ToBuf function.
+ * A product that is added or subtracted goes through yabi_addmul or
+ * yabi_submul, and a product of an Integer with itself goes through
+ * yabi_sqrToBuf, so a * b + c * d - e needs no temporaries at all. Only
+ * operands that are expressions themselves, such as both sides of
+ * (a + b) * (c + d), are evaluated into temporaries, and so is the half
+ * of a division that is not wanted. An expression that reads the Integer
+ * it is assigned to is evaluated into a temporary first. Expressions refer
+ * to their Integer operands, so keep them only within the statement that
+ * builds them. Scratch space for products and divisions comes from a
+ * workspace that each thread keeps until it exits.
+ *
+ * Division rounds toward zero like yabi_div, and dividing by 0 gives 0.
+ * Requires C++17.
+ */
+
+// Integers of at most this many words are stored inline
+#ifndef YABI_INTEGER_INLINE_WORDS
+#define YABI_INTEGER_INLINE_WORDS (256 / YABI_WORD_BIT_SIZE)
+#endif
+
+namespace yabi {
+
+class Integer;
+
+enum class ExprOp {
+    add,
+    sub,
+    mul,
+    div,
+    mod,
+    bitAnd,
+    bitOr,
+    bitXor,
+    negate,
+    complement,
+    lshift,
+    rshift
+};
+
+template<ExprOp Op, class L, class R>
+struct IntegerExpr;
+template<ExprOp Op, class E>
+struct IntegerUnary;
+
+template<class T>
+struct isExpr : std::false_type {};
+template<ExprOp Op, class L, class R>
+struct isExpr<IntegerExpr<Op, L, R>> : std::true_type {};
+template<ExprOp Op, class E>
+struct isExpr<IntegerUnary<Op, E>> : std::true_type {};
+
+template<class T>
+struct isProduct : std::false_type {};
+template<class L, class R>
+struct isProduct<IntegerExpr<ExprOp::mul, L, R>> : std::true_type {};
+
+class Integer {
+public:
+    static constexpr size_t inline_words = YABI_INTEGER_INLINE_WORDS;
+    static_assert(inline_words * YABI_WORD_BIT_SIZE > 64, "an Integer must hold any native integer inline");
+
+    Integer() {
+        clear();
+    }
+
+    // any native integer
+    template<class T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    Integer(T v) {
+        clear();
+        bool negative = false;
+        if constexpr(std::is_signed<T>::value) {
+            negative = v < 0;
+        }
+        setNative((uint64_t)v, negative);
+    }
+
+    // the number in `str`, or 0 if it is not one
+    explicit Integer(const char* str, int base = 10) {
+        clear();
+        BigInt* a = yabi_fromStrRadix(str, base);
+        if(a) {
+            adopt(a);
+        }
+    }
+
+    // a copy of `a`
+    explicit Integer(const BigInt* a) {
+        clear();
+        copyFrom(a);
+    }
+
+    Integer(const Integer& a) {
+        clear();
+        copyFrom(a.p);
+    }
+
+    Integer(Integer&& a) noexcept {
+        clear();
+        take(a);
+    }
+
+    template<class E, typename std::enable_if<isExpr<E>::value, int>::type = 0>
+    Integer(const E& e) {
+        clear();
+        assign(e);
+    }
+
+    ~Integer() {
+        if(p != local()) {
+            yabi_release(p);
+        }
+    }
+
+    // takes over the caller's reference to `a`
+    static Integer from_big(BigInt* a) {
+        Integer res;
+        res.adopt(a);
+        return res;
+    }
+
+    Integer& operator=(const Integer& a) {
+        if(this != &a) {
+            copyFrom(a.p);
+        }
+        return *this;
+    }
+
+    Integer& operator=(Integer&& a) noexcept {
+        if(this != &a) {
+            take(a);
+        }
+        return *this;
+    }
+
+    template<class T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    Integer& operator=(T v) {
+        return *this = Integer(v);
+    }
+
+    template<class E, typename std::enable_if<isExpr<E>::value, int>::type = 0>
+    Integer& operator=(const E& e) {
+        assign(e);
+        return *this;
+    }
+
+    // the value, for passing to the C functions. It stays valid until the
+    // Integer changes
+    const BigInt* get() const {
+        return p;
+    }
+
+    // a reference to a BigInt with the same value, which the caller
+    // releases. A value on the heap is shared rather than copied, until
+    // the Integer next changes
+    BigInt* to_big() const {
+        if(p != local()) {
+            return yabi_retain(p);
+        }
+        BigInt* res = static_cast<BigInt*>(YABI_NEW_BIGINT(p->len));
+        res->refCount = 0;
+        res->len = p->len;
+        res->cap = p->len;
+        memcpy(res->data, p->data, p->len * sizeof(WordType));
+        return res;
+    }
+
+    std::string to_string(int base = 10) const {
+        char* str = yabi_toStrRadix(p, base);
+        if(!str) {
+            return std::string();
+        }
+        std::string res(str);
+        YABI_FREE(str);
+        return res;
+    }
+
+    // -1, 0 or 1
+    int sign() const {
+        return yabi_cmp_si(p, 0);
+    }
+
+    // makes room for values of up to len words, keeping the current one
+    void reserve(size_t len) {
+        grow(len, true);
+    }
+
+    void swap(Integer& a) noexcept {
+        Integer tmp(std::move(a));
+        a = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    template<class B>
+    Integer& operator+=(const B& b);
+    template<class B>
+    Integer& operator-=(const B& b);
+    template<class B>
+    Integer& operator*=(const B& b);
+    template<class B>
+    Integer& operator/=(const B& b);
+    template<class B>
+    Integer& operator%=(const B& b);
+    template<class B>
+    Integer& operator&=(const B& b);
+    template<class B>
+    Integer& operator|=(const B& b);
+    template<class B>
+    Integer& operator^=(const B& b);
+
+    Integer& operator<<=(size_t amt);
+    Integer& operator>>=(size_t amt);
+
+private:
+    template<ExprOp Op, class L, class R>
+    friend struct IntegerExpr;
+    template<ExprOp Op, class E>
+    friend struct IntegerUnary;
+    friend struct IntegerRef;
+
+    // points at `storage` or at a BigInt on the heap
+    BigInt* p;
+    alignas(BigInt) unsigned char storage[sizeof(BigInt) + inline_words * sizeof(WordType)];
+
+    BigInt* local() {
+        return reinterpret_cast<BigInt*>(storage);
+    }
+
+    const BigInt* local() const {
+        return reinterpret_cast<const BigInt*>(storage);
+    }
+
+    // 0, in the inline storage
+    void clear() {
+        p = local();
+        p->refCount = 0;
+        p->len = 1;
+        p->cap = inline_words;
+        p->data[0] = 0;
+    }
+
+    static bool unique(const BigInt* a) {
+#if defined(YABI_ATOMIC_REFCOUNT) && (defined(__GNUC__) || defined(__clang__))
+        return __atomic_load_n(&a->refCount, __ATOMIC_ACQUIRE) == 0;
+#elif defined(YABI_ATOMIC_REFCOUNT) && defined(_MSC_VER)
+        return _InterlockedOr64((volatile __int64*)&a->refCount, 0) == 0;
+#else
+        return a->refCount == 0;
+#endif
+    }
+
+    /**
+     * Makes sure p has room for len words and may be written, the same way
+     * reserveInto does. The value survives only if `keep` is set. A BigInt
+     * shared with the caller of to_big is left to them.
+     */
+    void grow(size_t len, bool keep) {
+        bool inlined = p == local();
+        if((inlined || unique(p)) && p->cap >= len) {
+            return;
+        }
+        size_t cap = len;
+        if(!inlined) {
+            cap = len > p->cap + p->cap / 2 ? len : p->cap + p->cap / 2;
+        }
+        // YABI_RESIZE_BIGINT is C, so growing copies
+        BigInt* res = static_cast<BigInt*>(YABI_NEW_BIGINT(cap));
+        res->refCount = 0;
+        res->cap = cap;
+        res->len = 1;
+        res->data[0] = 0;
+        if(keep) {
+            memcpy(res->data, p->data, p->len * sizeof(WordType));
+            res->len = p->len;
+        }
+        if(!inlined) {
+            yabi_release(p);
+        }
+        p = res;
+    }
+
+    // room for len words, whose contents are about to be overwritten
+    BigInt* reserveFor(size_t len) {
+        grow(len, false);
+        return p;
+    }
+
+    void copyFrom(const BigInt* a) {
+        if(a == p) {
+            return;
+        }
+        reserveFor(a->len);
+        memcpy(p->data, a->data, a->len * sizeof(WordType));
+        p->len = a->len;
+    }
+
+    void adopt(BigInt* a) {
+        if(p != local()) {
+            yabi_release(p);
+        }
+        p = a;
+    }
+
+    void take(Integer& a) {
+        if(a.p == a.local()) {
+            copyFrom(a.p);
+        } else {
+            adopt(a.p);
+            a.clear();
+        }
+    }
+
+    void setNative(uint64_t x, bool negative) {
+        const size_t n = 64 / YABI_WORD_BIT_SIZE;
+        for(size_t i = 0; i < n; i++) {
+            p->data[i] = (WordType)(x >> (i * YABI_WORD_BIT_SIZE % 64));
+        }
+        // a zero word keeps large unsigned values positive
+        p->data[n] = negative ? (WordType)~(WordType)0 : 0;
+        p->len = n + 1;
+        trim();
+    }
+
+    // drops redundant sign words
+    void trim() {
+        while(p->len > 1) {
+            WordType top = p->data[p->len - 1];
+            WordType sign = (WordType)-(WordType)(p->data[p->len - 2] >> (YABI_WORD_BIT_SIZE - 1));
+            if(top != sign) {
+                break;
+            }
+            p->len--;
+        }
+    }
+
+    template<class E>
+    void assign(const E& e) {
+        if(e.refers(this)) {
+            Integer tmp;
+            tmp.assign(e);
+            *this = std::move(tmp);
+            return;
+        }
+        reserveFor(e.need());
+        e.evalInto(*this);
+    }
+
+    // *this = *this op b, where the left operand is evaluated in place
+    template<class E>
+    Integer& update(const E& e) {
+        if(e.r.refers(this)) {
+            Integer tmp;
+            tmp.assign(e);
+            *this = std::move(tmp);
+        } else {
+            grow(e.need(), true);
+            e.evalInto(*this);
+        }
+        return *this;
+    }
+};
+
+inline void swap(Integer& a, Integer& b) noexcept {
+    a.swap(b);
+}
+
+// a workspace for the ToBuf functions of each thread, kept until the
+// thread exits, so that their scratch is only allocated as it grows
+inline yabi_workspace_t* scratchFor(size_t len) {
+    struct Scratch {
+        yabi_workspace_t ws = {0, NULL};
+        ~Scratch() {
+            YABI_FREE(ws.data);
+        }
+    };
+    thread_local Scratch s;
+    if(s.ws.len < len) {
+        YABI_FREE(s.ws.data);
+        s.ws.len = len > s.ws.len + s.ws.len / 2 ? len : s.ws.len + s.ws.len / 2;
+        s.ws.data = static_cast<WordType*>(YABI_MALLOC(s.ws.len * sizeof(WordType)));
+    }
+    return &s.ws;
+}
+
+/*
+ * Expressions. Each part knows a bound on the words its value needs, how
+ * many words the destination needs while it is evaluated, whether it reads
+ * a given Integer, and how to evaluate itself into an Integer that it does
+ * not read, except as its leftmost operand. Integers and native integers
+ * are leaves, which give their value as a BigInt.
+ */
+
+struct IntegerRef {
+    static constexpr bool leaf = true;
+    const Integer* a;
+
+    const BigInt* big() const {
+        return a->p;
+    }
+    size_t bound() const {
+        return a->p->len;
+    }
+    size_t need() const {
+        return bound();
+    }
+    bool refers(const Integer* x) const {
+        return a == x;
+    }
+    void evalInto(Integer& dst) const {
+        dst.copyFrom(a->p);
+    }
+};
+
+struct IntegerValue {
+    static constexpr bool leaf = true;
+    Integer a;
+
+    const BigInt* big() const {
+        return a.get();
+    }
+    size_t bound() const {
+        return a.get()->len;
+    }
+    size_t need() const {
+        return bound();
+    }
+    bool refers(const Integer*) const {
+        return false;
+    }
+    void evalInto(Integer& dst) const {
+        dst = a;
+    }
+};
+
+// an operand as a BigInt, evaluated into a temporary unless it is a leaf
+template<class E, bool Leaf = E::leaf>
+struct Operand {
+    Integer tmp;
+
+    explicit Operand(const E& e) : tmp(e) {}
+    const BigInt* get() const {
+        return tmp.get();
+    }
+};
+
+template<class E>
+struct Operand<E, true> {
+    const BigInt* a;
+
+    explicit Operand(const E& e) : a(e.big()) {}
+    const BigInt* get() const {
+        return a;
+    }
+};
+
+template<ExprOp Op, class L, class R>
+struct IntegerExpr {
+    static constexpr bool leaf = false;
+    L l;
+    R r;
+
+    size_t bound() const {
+        size_t lb = l.bound();
+        size_t rb = r.bound();
+        switch(Op) {
+        case ExprOp::add:
+        case ExprOp::sub:
+            return (lb > rb ? lb : rb) + 1;
+        case ExprOp::mul:
+            return lb + rb;
+        case ExprOp::div:
+            return lb + 1;
+        case ExprOp::mod:
+            return rb + 1;
+        default:
+            return lb > rb ? lb : rb;
+        }
+    }
+
+    size_t need() const {
+        size_t n = bound();
+        size_t ln = l.need();
+        size_t rn = r.need();
+        n = n > ln ? n : ln;
+        return n > rn ? n : rn;
+    }
+
+    bool refers(const Integer* x) const {
+        return l.refers(x) || r.refers(x);
+    }
+
+    void evalInto(Integer& dst) const {
+        if constexpr((Op == ExprOp::add || Op == ExprOp::sub) && isProduct<R>::value) {
+            l.evalInto(dst);
+            addProduct(dst, r, Op == ExprOp::sub);
+        } else if constexpr(Op == ExprOp::add && isProduct<L>::value) {
+            r.evalInto(dst);
+            addProduct(dst, l, false);
+        } else if constexpr(L::leaf) {
+            Operand<R> b(r);
+            apply(dst, l.big(), b.get());
+        } else {
+            l.evalInto(dst);
+            Operand<R> b(r);
+            apply(dst, dst.p, b.get());
+        }
+    }
+
+    // dst += x * y or dst -= x * y, fused unless the product is large
+    // enough for subquadratic multiplication, as in yabi_addmul
+    template<class P>
+    static void addProduct(Integer& dst, const P& prod, bool subtract) {
+        Operand<decltype(prod.l)> x(prod.l);
+        Operand<decltype(prod.r)> y(prod.r);
+        size_t xlen = x.get()->len;
+        size_t ylen = y.get()->len;
+        if(xlen >= YABI_KARATSUBA_THRESHOLD && ylen >= YABI_KARATSUBA_THRESHOLD) {
+            // yabi_addmul would allocate the product, so keep one around
+            thread_local Integer product;
+            P::apply(product, x.get(), y.get());
+            if(subtract) {
+                IntegerExpr<ExprOp::sub, IntegerRef, IntegerRef>::apply(dst, dst.p, product.p);
+            } else {
+                IntegerExpr<ExprOp::add, IntegerRef, IntegerRef>::apply(dst, dst.p, product.p);
+            }
+            return;
+        }
+        dst.grow((dst.p->len > xlen + ylen ? dst.p->len : xlen + ylen) + 1, true);
+        // dst has room and no other owners, so it stays where it is
+        BigInt* res = dst.p;
+        if(subtract) {
+            yabi_submul(&res, x.get(), y.get());
+        } else {
+            yabi_addmul(&res, x.get(), y.get());
+        }
+    }
+
+    // dst = a op b, where a may be dst
+    static void apply(Integer& dst, const BigInt* a, const BigInt* b) {
+        bool inPlace = a == dst.p;
+        size_t alen = a->len;
+        size_t blen = b->len;
+        size_t len;
+        switch(Op) {
+        case ExprOp::add:
+        case ExprOp::sub:
+            len = (alen > blen ? alen : blen) + 1;
+            break;
+        case ExprOp::mul:
+            len = alen + blen;
+            break;
+        case ExprOp::div:
+            len = alen + 1;
+            break;
+        case ExprOp::mod:
+            len = blen + 1;
+            break;
+        default:
+            len = alen > blen ? alen : blen;
+            break;
+        }
+        if(inPlace) {
+            dst.grow(len, true);
+            a = dst.p;
+        } else {
+            dst.reserveFor(len);
+        }
+        BigInt* res = dst.p;
+        switch(Op) {
+        case ExprOp::add:
+            res->len = yabi_addToBuf(a, b, len, res->data);
+            break;
+        case ExprOp::sub:
+            res->len = yabi_subToBuf(a, b, len, res->data);
+            break;
+        case ExprOp::mul:
+            if(a == b) {
+                res->len = yabi_sqrToBufWs(a, len, res->data, scratchFor(yabi_sqr_scratch(alen)));
+            } else {
+                res->len = yabi_mulToBufWs(a, b, len, res->data, scratchFor(yabi_mul_scratch(alen, blen)));
+            }
+            break;
+        case ExprOp::div:
+        case ExprOp::mod: {
+            // the other half of the result
+            Integer rest;
+            size_t restLen = Op == ExprOp::div ? blen + 1 : alen + 1;
+            BigInt* other = rest.reserveFor(restLen);
+            yabi_workspace_t* ws = scratchFor(yabi_div_scratch(alen, blen));
+            ydiv_t d = Op == ExprOp::div
+                ? yabi_divToBufWs(a, b, len, res->data, restLen, other->data, ws)
+                : yabi_divToBufWs(a, b, restLen, other->data, len, res->data, ws);
+            size_t n = Op == ExprOp::div ? d.qlen : d.rlen;
+            if(n == 0) {
+                res->data[0] = 0;
+                n = 1;
+            }
+            res->len = n;
+            break;
+        }
+        case ExprOp::bitAnd:
+            res->len = yabi_andToBuf(a, b, len, res->data);
+            break;
+        case ExprOp::bitOr:
+            res->len = yabi_orToBuf(a, b, len, res->data);
+            break;
+        default:
+            res->len = yabi_xorToBuf(a, b, len, res->data);
+            break;
+        }
+    }
+};
+
+template<ExprOp Op, class E>
+struct IntegerUnary {
+    static constexpr bool leaf = false;
+    E e;
+    size_t amt;
+
+    size_t bound() const {
+        size_t b = e.bound();
+        switch(Op) {
+        case ExprOp::negate:
+            return b + 1;
+        case ExprOp::lshift:
+            return b + amt / YABI_WORD_BIT_SIZE + 1;
+        default:
+            return b;
+        }
+    }
+
+    size_t need() const {
+        size_t b = bound();
+        size_t n = e.need();
+        return b > n ? b : n;
+    }
+
+    bool refers(const Integer* x) const {
+        return e.refers(x);
+    }
+
+    void evalInto(Integer& dst) const {
+        const BigInt* a;
+        if constexpr(E::leaf) {
+            a = e.big();
+        } else {
+            e.evalInto(dst);
+            a = dst.p;
+        }
+        bool inPlace = a == dst.p;
+        size_t len = a->len;
+        if(Op == ExprOp::negate) {
+            len += 1;
+        } else if(Op == ExprOp::lshift) {
+            len += amt / YABI_WORD_BIT_SIZE + 1;
+        }
+        if(inPlace) {
+            dst.grow(len, true);
+            a = dst.p;
+        } else {
+            dst.reserveFor(len);
+        }
+        BigInt* res = dst.p;
+        switch(Op) {
+        case ExprOp::negate:
+            res->len = yabi_negateToBuf(a, len, res->data);
+            break;
+        case ExprOp::complement:
+            res->len = yabi_complToBuf(a, len, res->data);
+            break;
+        case ExprOp::lshift:
+            res->len = yabi_lshiftToBuf(a, amt, len, res->data);
+            break;
+        default:
+            res->len = yabi_rshiftToBuf(a, amt, len, res->data);
+            break;
+        }
+    }
+};
+
+inline Integer& Integer::operator<<=(size_t amt) {
+    IntegerUnary<ExprOp::lshift, IntegerRef> e{IntegerRef{this}, amt};
+    grow(e.need(), true);
+    e.evalInto(*this);
+    return *this;
+}
+
+inline Integer& Integer::operator>>=(size_t amt) {
+    IntegerUnary<ExprOp::rshift, IntegerRef> e{IntegerRef{this}, amt};
+    e.evalInto(*this);
+    return *this;
+}
+
+template<class T>
+constexpr bool isTerm = std::is_same<T, Integer>::value || isExpr<T>::value;
+
+template<class A, class B>
+constexpr bool isOperands = (isTerm<A> && (isTerm<B> || std::is_integral<B>::value))
+    || (std::is_integral<A>::value && isTerm<B>);
+
+inline IntegerRef operandOf(const Integer& a) {
+    return IntegerRef{&a};
+}
+
+template<class T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+inline IntegerValue operandOf(T a) {
+    return IntegerValue{Integer(a)};
+}
+
+template<class E, typename std::enable_if<isExpr<E>::value, int>::type = 0>
+inline E operandOf(const E& e) {
+    return e;
+}
+
+template<class T>
+using OperandOf = decltype(operandOf(std::declval<const T&>()));
+
+#define YABI_INTEGER_OPERATOR(sym, op) \
+    template<class A, class B, typename std::enable_if<isOperands<A, B>, int>::type = 0> \
+    inline IntegerExpr<op, OperandOf<A>, OperandOf<B>> operator sym(const A& a, const B& b) { \
+        return {operandOf(a), operandOf(b)}; \
+    } \
+    template<class B> \
+    inline Integer& Integer::operator sym##=(const B& b) { \
+        return update(IntegerExpr<op, IntegerRef, OperandOf<B>>{IntegerRef{this}, operandOf(b)}); \
+    }
+
+YABI_INTEGER_OPERATOR(+, ExprOp::add)
+YABI_INTEGER_OPERATOR(-, ExprOp::sub)
+YABI_INTEGER_OPERATOR(*, ExprOp::mul)
+YABI_INTEGER_OPERATOR(/, ExprOp::div)
+YABI_INTEGER_OPERATOR(%, ExprOp::mod)
+YABI_INTEGER_OPERATOR(&, ExprOp::bitAnd)
+YABI_INTEGER_OPERATOR(|, ExprOp::bitOr)
+YABI_INTEGER_OPERATOR(^, ExprOp::bitXor)
+
+#undef YABI_INTEGER_OPERATOR
+
+template<class A, typename std::enable_if<isTerm<A>, int>::type = 0>
+inline IntegerUnary<ExprOp::negate, OperandOf<A>> operator-(const A& a) {
+    return {operandOf(a), 0};
+}
+
+template<class A, typename std::enable_if<isTerm<A>, int>::type = 0>
+inline IntegerUnary<ExprOp::complement, OperandOf<A>> operator~(const A& a) {
+    return {operandOf(a), 0};
+}
+
+template<class A, typename std::enable_if<isTerm<A>, int>::type = 0>
+inline IntegerUnary<ExprOp::lshift, OperandOf<A>> operator<<(const A& a, size_t amt) {
+    return {operandOf(a), amt};
+}
+
+template<class A, typename std::enable_if<isTerm<A>, int>::type = 0>
+inline IntegerUnary<ExprOp::rshift, OperandOf<A>> operator>>(const A& a, size_t amt) {
+    return {operandOf(a), amt};
+}
+
+// expressions compare by converting to Integer, native integers directly
+inline int cmp(const Integer& a, const Integer& b) {
+    return yabi_cmp(a.get(), b.get());
+}
+
+inline bool operator==(const Integer& a, const Integer& b) {
+    return yabi_equal(a.get(), b.get());
+}
+
+inline bool operator!=(const Integer& a, const Integer& b) {
+    return !yabi_equal(a.get(), b.get());
+}
+
+inline bool operator<(const Integer& a, const Integer& b) {
+    return cmp(a, b) < 0;
+}
+
+inline bool operator>(const Integer& a, const Integer& b) {
+    return cmp(a, b) > 0;
+}
+
+inline bool operator<=(const Integer& a, const Integer& b) {
+    return cmp(a, b) <= 0;
+}
+
+inline bool operator>=(const Integer& a, const Integer& b) {
+    return cmp(a, b) >= 0;
+}
+
+} // namespace yabi
+
+#endif
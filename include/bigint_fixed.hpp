@@ -0,0 +1,676 @@
+#ifndef YET_ANOTHER_BIGINT_FIXED_HPP
+#define YET_ANOTHER_BIGINT_FIXED_HPP
+#include "bigint.h"
+#include <stdlib.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+/*
+ * yabi::fixed<Bits, Signed> is an integer of exactly Bits bits, held in
+ * Bits / YABI_WORD_BIT_SIZE words with no header, so it can live on the
+ * stack or inside other objects and is never allocated. Arithmetic wraps
+ * around the way the ToBuf functions truncate, so a signed fixed holds the
+ * same two's complement words that a ToBuf call with that many words
+ * would store. An unsigned one holds the same words as well, and differs
+ * only in how it compares, divides, shifts right and widens. Division
+ * rounds toward zero like yabi_div, and dividing by 0 gives 0.
+ *
+ * Everything but the conversions to and from BigInt is constexpr. The
+ * carry chains of short values are unrolled completely, and go through
+ * compile time capable versions of the word primitives of
+ * bigint_internal.h. Requires C++17.
+ */
+
+// fixed integers of at most this many words have their loops over words
+// unrolled completely
+#ifndef YABI_FIXED_UNROLL_WORDS
+#define YABI_FIXED_UNROLL_WORDS 16
+#endif
+
+namespace yabi {
+
+namespace detail {
+
+constexpr int wordBits = YABI_WORD_BIT_SIZE;
+constexpr WordType wordMax = (WordType)~(WordType)0;
+
+#ifndef YABI_PORTABLE_PRIMITIVES
+#if YABI_WORD_BIT_SIZE == 8
+    typedef uint16_t DWordType;
+    #define YABI_FIXED_HAS_DWORD
+#elif YABI_WORD_BIT_SIZE == 16
+    typedef uint32_t DWordType;
+    #define YABI_FIXED_HAS_DWORD
+#elif YABI_WORD_BIT_SIZE == 32
+    typedef uint64_t DWordType;
+    #define YABI_FIXED_HAS_DWORD
+#elif defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 DWordType;
+    #define YABI_FIXED_HAS_DWORD
+#endif
+// 128 bit division is a library call, so divide by the hardware instead
+// whenever the division does not happen at compile time
+#if YABI_WORD_BIT_SIZE == 64 && defined(__GNUC__) && defined(__x86_64__) && defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+    #define YABI_FIXED_DIVQ
+#endif
+#endif
+#endif
+
+// adds three words and returns the carry out, like addAndCarry
+constexpr WordType addAndCarry(WordType a, WordType b, WordType c, WordType& d) {
+#if defined(YABI_FIXED_HAS_DWORD)
+    DWordType s = (DWordType)a + b + c;
+    d = (WordType)s;
+    return (WordType)(s >> wordBits);
+#else
+    WordType ab = (WordType)(a + b);
+    WordType abc = (WordType)(ab + c);
+    d = abc;
+    return (WordType)((ab < a) + (abc < ab));
+#endif
+}
+
+// adds a * b to c, returning the high word of the sum, like mulAndCarry
+constexpr WordType mulAndCarry(WordType a, WordType b, WordType& c) {
+#if defined(YABI_FIXED_HAS_DWORD)
+    DWordType p = (DWordType)a * b + c;
+    c = (WordType)p;
+    return (WordType)(p >> wordBits);
+#else
+    const int half = wordBits >> 1;
+    const WordType mask = ((WordType)1 << half) - 1;
+    WordType ahi = a >> half;
+    WordType bhi = b >> half;
+    WordType alo = a & mask;
+    WordType blo = b & mask;
+    WordType carry = (WordType)(ahi * bhi);
+    WordType tmp = (WordType)(ahi * blo);
+    carry += tmp >> half;
+    carry += addAndCarry(c, (WordType)(tmp << half), 0, c);
+    tmp = (WordType)(alo * bhi);
+    carry += tmp >> half;
+    carry += addAndCarry(c, (WordType)(tmp << half), 0, c);
+    carry += addAndCarry(c, (WordType)(alo * blo), 0, c);
+    return carry;
+#endif
+}
+
+// stores the low word of a * b + c + d in `lo` and returns the high one,
+// which cannot overflow
+constexpr WordType mulAdd(WordType a, WordType b, WordType c, WordType d, WordType& lo) {
+#if defined(YABI_FIXED_HAS_DWORD)
+    DWordType p = (DWordType)a * b + c + d;
+    lo = (WordType)p;
+    return (WordType)(p >> wordBits);
+#else
+    WordType hi = mulAndCarry(a, b, c);
+    hi += addAndCarry(c, d, 0, lo);
+    return hi;
+#endif
+}
+
+// counts the leading zero bits of a nonzero word
+constexpr int leadingZeros(WordType a) {
+#if defined(__GNUC__) && !defined(YABI_PORTABLE_PRIMITIVES)
+    return __builtin_clzll(a) - (64 - wordBits);
+#else
+    int n = 0;
+    for(int shf = wordBits >> 1; shf > 0; shf >>= 1) {
+        if(!(a >> (wordBits - shf))) {
+            a = (WordType)(a << shf);
+            n += shf;
+        }
+    }
+    return n;
+#endif
+}
+
+#if defined(YABI_FIXED_DIVQ)
+inline WordType divWideNative(WordType hi, WordType lo, WordType d, WordType& r) {
+    WordType q;
+    __asm__("divq %4" : "=a"(q), "=d"(r) : "a"(lo), "d"(hi), "rm"(d));
+    return q;
+}
+#endif
+
+// divides hi:lo by d, like divWide. Requires hi < d and d normalized
+constexpr WordType divWide(WordType hi, WordType lo, WordType d, WordType& r) {
+#if defined(YABI_FIXED_DIVQ)
+    if(!__builtin_is_constant_evaluated()) {
+        return divWideNative(hi, lo, d, r);
+    }
+#endif
+#if defined(YABI_FIXED_HAS_DWORD)
+    DWordType n = (DWordType)hi << wordBits | lo;
+    r = (WordType)(n % d);
+    return (WordType)(n / d);
+#else
+    const int half = wordBits >> 1;
+    const WordType b = (WordType)1 << half;
+    const WordType mask = b - 1;
+    WordType dhi = d >> half;
+    WordType dlo = d & mask;
+    WordType lohi = lo >> half;
+    WordType lolo = lo & mask;
+    WordType q1 = hi / dhi;
+    WordType rhat = (WordType)(hi - q1 * dhi);
+    while(q1 >= b || (WordType)(q1 * dlo) > (WordType)(b * rhat + lohi)) {
+        q1--;
+        rhat += dhi;
+        if(rhat >= b) {
+            break;
+        }
+    }
+    WordType mid = (WordType)(hi * b + lohi - q1 * d);
+    WordType q0 = mid / dhi;
+    rhat = (WordType)(mid - q0 * dhi);
+    while(q0 >= b || (WordType)(q0 * dlo) > (WordType)(b * rhat + lolo)) {
+        q0--;
+        rhat += dhi;
+        if(rhat >= b) {
+            break;
+        }
+    }
+    r = (WordType)(mid * b + lolo - q0 * d);
+    return (WordType)(q1 * b + q0);
+#endif
+}
+
+template<class F, size_t... I>
+constexpr void unrolled(F& f, std::index_sequence<I...>) {
+    (f(I), ...);
+}
+
+// calls f(0) through f(N - 1) in order, unrolled unless N is large
+template<size_t N, class F>
+constexpr void each(F f) {
+    if constexpr(N <= YABI_FIXED_UNROLL_WORDS) {
+        unrolled(f, std::make_index_sequence<N>{});
+    } else {
+        for(size_t i = 0; i < N; i++) {
+            f(i);
+        }
+    }
+}
+
+// the same for f(0) through f(n - 1), where n <= N
+template<size_t N, class F>
+constexpr void eachBelow(size_t n, F f) {
+    if constexpr(N <= YABI_FIXED_UNROLL_WORDS) {
+        auto g = [&](size_t i) {
+            if(i < n) {
+                f(i);
+            }
+        };
+        unrolled(g, std::make_index_sequence<N>{});
+    } else {
+        for(size_t i = 0; i < n; i++) {
+            f(i);
+        }
+    }
+}
+
+/**
+ * Divides the N-word magnitude a by the N-word magnitude b by Knuth's
+ * algorithm D, like divremSchoolbook, storing N words of quotient and
+ * remainder. Both are 0 if b is.
+ */
+template<size_t N>
+constexpr void divrem(const WordType* a, const WordType* b, WordType* q, WordType* r) {
+    for(size_t i = 0; i < N; i++) {
+        q[i] = 0;
+        r[i] = 0;
+    }
+    size_t n = N;
+    while(n > 0 && b[n - 1] == 0) {
+        n--;
+    }
+    size_t m = N;
+    while(m > 0 && a[m - 1] == 0) {
+        m--;
+    }
+    if(n == 0) {
+        return;
+    }
+    if(m < n) {
+        for(size_t i = 0; i < m; i++) {
+            r[i] = a[i];
+        }
+        return;
+    }
+    // normalize, so that v has its top bit set. u gains a word, which is
+    // smaller than the top word of v
+    int s = leadingZeros(b[n - 1]);
+    WordType v[N] = {};
+    WordType u[N + 1] = {};
+    for(size_t i = 0; i < n; i++) {
+        v[i] = (WordType)(b[i] << s);
+        if(s && i > 0) {
+            v[i] |= b[i - 1] >> (wordBits - s);
+        }
+    }
+    for(size_t i = 0; i <= m; i++) {
+        u[i] = i < m ? (WordType)(a[i] << s) : 0;
+        if(s && i > 0) {
+            u[i] |= a[i - 1] >> (wordBits - s);
+        }
+    }
+    WordType v1 = v[n - 1];
+    WordType v0 = n > 1 ? v[n - 2] : 0;
+    for(size_t j = m - n + 1; j-- > 0;) {
+        // divide the n + 1 words at w by v
+        WordType* w = u + j;
+        WordType u2 = w[n];
+        WordType u1 = w[n - 1];
+        WordType qhat = 0;
+        WordType rhat = 0;
+        bool overflow = false;
+        if(u2 >= v1) {
+            qhat = wordMax;
+            rhat = (WordType)(u1 + v1);
+            overflow = rhat < v1;
+        } else {
+            qhat = divWide(u2, u1, v1, rhat);
+        }
+        while(n > 1 && !overflow) {
+            WordType lo = 0;
+            WordType hi = mulAndCarry(qhat, v0, lo);
+            if(hi < rhat || (hi == rhat && lo <= w[n - 2])) {
+                break;
+            }
+            qhat--;
+            rhat += v1;
+            overflow = rhat < v1;
+        }
+        // w -= qhat * v, adding v back if that went below zero
+        WordType borrow = 0;
+        for(size_t i = 0; i < n; i++) {
+            WordType lo = 0;
+            WordType hi = mulAdd(qhat, v[i], borrow, 0, lo);
+            hi += w[i] < lo;
+            w[i] = (WordType)(w[i] - lo);
+            borrow = hi;
+        }
+        if(u2 < borrow) {
+            qhat--;
+            WordType carry = 0;
+            for(size_t i = 0; i < n; i++) {
+                carry = addAndCarry(w[i], v[i], carry, w[i]);
+            }
+        }
+        w[n] = 0;
+        q[j] = qhat;
+    }
+    // unnormalize the remainder
+    for(size_t i = 0; i < n; i++) {
+        r[i] = (WordType)(u[i] >> s);
+        if(s && i + 1 < n) {
+            r[i] |= (WordType)(u[i + 1] << (wordBits - s));
+        }
+    }
+}
+
+} // namespace detail
+
+template<size_t Bits, bool Signed = true>
+class fixed {
+    static_assert(Bits > 0 && Bits % YABI_WORD_BIT_SIZE == 0,
+            "the width of a fixed must be a whole number of words");
+
+public:
+    static constexpr size_t bits = Bits;
+    static constexpr size_t words = Bits / YABI_WORD_BIT_SIZE;
+    static constexpr bool is_signed = Signed;
+
+    // least significant word first
+    WordType data[words];
+
+    constexpr fixed() : data{} {}
+
+    // any native integer, sign extended if its type is signed
+    template<class T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    constexpr fixed(T v) : data{} {
+        bool negative = false;
+        if constexpr(std::is_signed<T>::value) {
+            negative = v < 0;
+        }
+        uint64_t x = (uint64_t)v;
+        WordType fill = negative ? detail::wordMax : 0;
+        detail::each<words>([&](size_t i) {
+            data[i] = i * YABI_WORD_BIT_SIZE < 64 ? (WordType)(x >> (i * YABI_WORD_BIT_SIZE % 64)) : fill;
+        });
+    }
+
+    // another fixed, truncated or extended as its signedness says
+    template<size_t OtherBits, bool OtherSigned>
+    explicit constexpr fixed(const fixed<OtherBits, OtherSigned>& a) : data{} {
+        WordType fill = a.negative() ? detail::wordMax : 0;
+        detail::each<words>([&](size_t i) {
+            data[i] = i < a.words ? a.data[i] : fill;
+        });
+    }
+
+    explicit fixed(const BigInt* a) : fixed(from_buf(a->len, a->data)) {}
+
+    // the len words of two's complement at `buffer`, truncated or sign
+    // extended
+    static constexpr fixed from_buf(size_t len, const WordType* buffer) {
+        fixed res;
+        WordType fill = len > 0 && buffer[len - 1] >> (YABI_WORD_BIT_SIZE - 1) ? detail::wordMax : 0;
+        detail::each<words>([&](size_t i) {
+            res.data[i] = i < len ? buffer[i] : fill;
+        });
+        return res;
+    }
+
+    // stores the value like the ToBuf functions, returning its minimal
+    // length up to len
+    constexpr size_t to_buf(size_t len, WordType* buffer) const {
+        WordType fill = negative() ? detail::wordMax : 0;
+        for(size_t i = 0; i < len; i++) {
+            buffer[i] = i < words ? data[i] : fill;
+        }
+        size_t n = min_len();
+        return n < len ? n : len;
+    }
+
+    // a new BigInt with the same value, which the caller releases
+    BigInt* to_big() const {
+        size_t len = min_len();
+        BigInt* res = static_cast<BigInt*>(YABI_NEW_BIGINT(len));
+        res->refCount = 0;
+        res->len = len;
+        res->cap = len;
+        to_buf(len, res->data);
+        return res;
+    }
+
+    // the number of words a BigInt needs for the value
+    constexpr size_t min_len() const {
+        if(!Signed && negativeWords()) {
+            // the top bit is a digit, so a zero word above it holds the sign
+            return words + 1;
+        }
+        WordType sign = negativeWords() ? detail::wordMax : 0;
+        size_t len = words;
+        while(len > 1 && data[len - 1] == sign && (data[len - 2] ^ sign) >> (YABI_WORD_BIT_SIZE - 1) == 0) {
+            len--;
+        }
+        return len;
+    }
+
+    constexpr bool negative() const {
+        return Signed && negativeWords();
+    }
+
+    // the low bits of the value, like a conversion between native integers
+    template<class T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    explicit constexpr operator T() const {
+        uint64_t x = 0;
+        detail::each<words>([&](size_t i) {
+            if(i * YABI_WORD_BIT_SIZE < 64) {
+                x |= (uint64_t)data[i] << (i * YABI_WORD_BIT_SIZE % 64);
+            }
+        });
+        if(words * YABI_WORD_BIT_SIZE < 64 && negative()) {
+            x |= ~(uint64_t)0 << (words * YABI_WORD_BIT_SIZE % 64);
+        }
+        return (T)x;
+    }
+
+    explicit constexpr operator bool() const {
+        WordType any = 0;
+        detail::each<words>([&](size_t i) {
+            any |= data[i];
+        });
+        return any != 0;
+    }
+
+    friend constexpr fixed operator+(const fixed& a, const fixed& b) {
+        fixed res;
+        WordType carry = 0;
+        detail::each<words>([&](size_t i) {
+            carry = detail::addAndCarry(a.data[i], b.data[i], carry, res.data[i]);
+        });
+        return res;
+    }
+
+    friend constexpr fixed operator-(const fixed& a, const fixed& b) {
+        // a + ~b + 1
+        fixed res;
+        WordType carry = 1;
+        detail::each<words>([&](size_t i) {
+            carry = detail::addAndCarry(a.data[i], (WordType)~b.data[i], carry, res.data[i]);
+        });
+        return res;
+    }
+
+    friend constexpr fixed operator-(const fixed& a) {
+        return fixed() - a;
+    }
+
+    // the low words of the product only, which is the same whether the
+    // operands are signed or not
+    friend constexpr fixed operator*(const fixed& a, const fixed& b) {
+        fixed res;
+        detail::each<words>([&](size_t i) {
+            WordType carry = 0;
+            detail::eachBelow<words>(words - i, [&](size_t j) {
+                carry = detail::mulAdd(a.data[i], b.data[j], res.data[i + j], carry, res.data[i + j]);
+            });
+        });
+        return res;
+    }
+
+    friend constexpr fixed operator/(const fixed& a, const fixed& b) {
+        fixed q;
+        fixed r;
+        divmod(a, b, q, r);
+        return q;
+    }
+
+    // takes the sign of a
+    friend constexpr fixed operator%(const fixed& a, const fixed& b) {
+        fixed q;
+        fixed r;
+        divmod(a, b, q, r);
+        return r;
+    }
+
+    static constexpr void divmod(const fixed& a, const fixed& b, fixed& q, fixed& r) {
+        bool anegative = a.negative();
+        bool bnegative = b.negative();
+        fixed amag = anegative ? -a : a;
+        fixed bmag = bnegative ? -b : b;
+        detail::divrem<words>(amag.data, bmag.data, q.data, r.data);
+        if(anegative != bnegative) {
+            q = -q;
+        }
+        if(anegative) {
+            r = -r;
+        }
+    }
+
+    friend constexpr fixed operator&(const fixed& a, const fixed& b) {
+        fixed res;
+        detail::each<words>([&](size_t i) {
+            res.data[i] = a.data[i] & b.data[i];
+        });
+        return res;
+    }
+
+    friend constexpr fixed operator|(const fixed& a, const fixed& b) {
+        fixed res;
+        detail::each<words>([&](size_t i) {
+            res.data[i] = a.data[i] | b.data[i];
+        });
+        return res;
+    }
+
+    friend constexpr fixed operator^(const fixed& a, const fixed& b) {
+        fixed res;
+        detail::each<words>([&](size_t i) {
+            res.data[i] = a.data[i] ^ b.data[i];
+        });
+        return res;
+    }
+
+    friend constexpr fixed operator~(const fixed& a) {
+        fixed res;
+        detail::each<words>([&](size_t i) {
+            res.data[i] = (WordType)~a.data[i];
+        });
+        return res;
+    }
+
+    friend constexpr fixed operator<<(const fixed& a, size_t amt) {
+        fixed res;
+        if(amt >= Bits) {
+            return res;
+        }
+        size_t ws = amt / YABI_WORD_BIT_SIZE;
+        int bs = (int)(amt % YABI_WORD_BIT_SIZE);
+        for(size_t i = ws; i < words; i++) {
+            res.data[i] = (WordType)(a.data[i - ws] << bs);
+            if(bs && i > ws) {
+                res.data[i] |= a.data[i - ws - 1] >> (YABI_WORD_BIT_SIZE - bs);
+            }
+        }
+        return res;
+    }
+
+    // arithmetic for signed values, logical for unsigned ones
+    friend constexpr fixed operator>>(const fixed& a, size_t amt) {
+        WordType fill = a.negative() ? detail::wordMax : 0;
+        fixed res;
+        if(amt >= Bits) {
+            return a.negative() ? ~res : res;
+        }
+        size_t ws = amt / YABI_WORD_BIT_SIZE;
+        int bs = (int)(amt % YABI_WORD_BIT_SIZE);
+        for(size_t i = 0; i < words; i++) {
+            WordType lo = i + ws < words ? a.data[i + ws] : fill;
+            WordType hi = i + ws + 1 < words ? a.data[i + ws + 1] : fill;
+            res.data[i] = lo >> bs;
+            if(bs) {
+                res.data[i] |= (WordType)(hi << (YABI_WORD_BIT_SIZE - bs));
+            }
+        }
+        return res;
+    }
+
+    friend constexpr bool operator==(const fixed& a, const fixed& b) {
+        WordType diff = 0;
+        detail::each<words>([&](size_t i) {
+            diff |= a.data[i] ^ b.data[i];
+        });
+        return diff == 0;
+    }
+
+    // the borrow out of a - b, with the sign bits flipped for signed values
+    friend constexpr bool operator<(const fixed& a, const fixed& b) {
+        const WordType flip = Signed ? (WordType)1 << (YABI_WORD_BIT_SIZE - 1) : 0;
+        WordType carry = 1;
+        WordType scratch = 0;
+        detail::each<words>([&](size_t i) {
+            WordType x = i == words - 1 ? a.data[i] ^ flip : a.data[i];
+            WordType y = i == words - 1 ? b.data[i] ^ flip : b.data[i];
+            carry = detail::addAndCarry(x, (WordType)~y, carry, scratch);
+        });
+        return !carry;
+    }
+
+    friend constexpr bool operator!=(const fixed& a, const fixed& b) {
+        return !(a == b);
+    }
+
+    friend constexpr bool operator>(const fixed& a, const fixed& b) {
+        return b < a;
+    }
+
+    friend constexpr bool operator<=(const fixed& a, const fixed& b) {
+        return !(b < a);
+    }
+
+    friend constexpr bool operator>=(const fixed& a, const fixed& b) {
+        return !(a < b);
+    }
+
+    constexpr fixed& operator+=(const fixed& a) {
+        return *this = *this + a;
+    }
+
+    constexpr fixed& operator-=(const fixed& a) {
+        return *this = *this - a;
+    }
+
+    constexpr fixed& operator*=(const fixed& a) {
+        return *this = *this * a;
+    }
+
+    constexpr fixed& operator/=(const fixed& a) {
+        return *this = *this / a;
+    }
+
+    constexpr fixed& operator%=(const fixed& a) {
+        return *this = *this % a;
+    }
+
+    constexpr fixed& operator&=(const fixed& a) {
+        return *this = *this & a;
+    }
+
+    constexpr fixed& operator|=(const fixed& a) {
+        return *this = *this | a;
+    }
+
+    constexpr fixed& operator^=(const fixed& a) {
+        return *this = *this ^ a;
+    }
+
+    constexpr fixed& operator<<=(size_t amt) {
+        return *this = *this << amt;
+    }
+
+    constexpr fixed& operator>>=(size_t amt) {
+        return *this = *this >> amt;
+    }
+
+    constexpr fixed& operator++() {
+        return *this += 1;
+    }
+
+    constexpr fixed& operator--() {
+        return *this -= 1;
+    }
+
+    constexpr fixed operator++(int) {
+        fixed old = *this;
+        ++*this;
+        return old;
+    }
+
+    constexpr fixed operator--(int) {
+        fixed old = *this;
+        --*this;
+        return old;
+    }
+
+private:
+    constexpr bool negativeWords() const {
+        return data[words - 1] >> (YABI_WORD_BIT_SIZE - 1);
+    }
+};
+
+typedef fixed<128, true> int128;
+typedef fixed<128, false> uint128;
+typedef fixed<256, true> int256;
+typedef fixed<256, false> uint256;
+typedef fixed<512, true> int512;
+typedef fixed<512, false> uint512;
+
+} // namespace yabi
+
+#endif
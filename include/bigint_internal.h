@@ -1,20 +1,489 @@
 #ifndef YET_ANOTHER_BIGINT_INTERNAL_H
 #define YET_ANOTHER_BIGINT_INTERNAL_H
 #include "bigint.h"
+#include <stdlib.h>
+#include <string.h>
 
 #define max(a, b) ((a) > (b) ? (a) : (b))
 #define min(a, b) ((a) < (b) ? (a) : (b))
 
 // get the most significant n bits. evals to 0 if `bits` is 0
-#define HI_N_BITS(n, bits) ((bits) && ((n) >> (YABI_WORD_BIT_SIZE - (bits))))
+#define HI_N_BITS(n, bits) ((bits) ? (n) >> (YABI_WORD_BIT_SIZE - (bits)) : 0)
 // get the most significant bit (sign bit)
 #define HI_BIT(n) ((n) >> (YABI_WORD_BIT_SIZE - 1))
 // get the three most significant bits (for carry)
 #define HI_3_BITS(n) ((n) >> (YABI_WORD_BIT_SIZE - 3))
 
+// YABI_RESIZE_BIGINT, which is only required to set len, followed by
+// setting the capacity the rest of the library relies on
+#define RESIZE_BIGINT(p, siz) do { YABI_RESIZE_BIGINT(p, siz); (p)->cap = (siz); } while(0)
+
+// Word primitives. Every arithmetic kernel funnels through these, so they
+// are defined here where they can be inlined. When the compiler has an
+// integer type twice the width of a word they use it directly, otherwise
+// they fall back to portable half-word code. Define
+// YABI_PORTABLE_PRIMITIVES to always use the portable code.
+#ifndef YABI_PORTABLE_PRIMITIVES
+#if YABI_WORD_BIT_SIZE == 8
+    typedef uint16_t DWordType;
+    #define YABI_HAS_DWORD
+#elif YABI_WORD_BIT_SIZE == 16
+    typedef uint32_t DWordType;
+    #define YABI_HAS_DWORD
+#elif YABI_WORD_BIT_SIZE == 32
+    typedef uint64_t DWordType;
+    #define YABI_HAS_DWORD
+#elif defined(__SIZEOF_INT128__)
+    typedef unsigned __int128 DWordType;
+    #define YABI_HAS_DWORD
+#elif defined(_MSC_VER) && defined(_M_X64)
+    #include <intrin.h>
+    #define YABI_HAS_MSVC_X64
+#endif
+#endif
+
+/** Adds three unsigned ints and returns the carry out. */
+static inline int addAndCarry(WordType a, WordType b, WordType c, WordType* d) {
+#if defined(YABI_HAS_DWORD)
+    DWordType s = (DWordType)a + b + c;
+    *d = (WordType)s;
+    return (int)(s >> YABI_WORD_BIT_SIZE);
+#elif defined(YABI_HAS_MSVC_X64)
+    unsigned long long ab;
+    unsigned char carry = _addcarry_u64(0, a, b, &ab);
+    return carry + _addcarry_u64(0, ab, c, (unsigned long long*)d);
+#else
+    WordType ab = a + b;
+    WordType abc = ab + c;
+    *d = abc;
+    return (ab < a) + (abc < ab);
+#endif
+}
+
+/** Adds a * b to c, returning the high word of the sum. */
+static inline WordType mulAndCarry(WordType a, WordType b, WordType* c) {
+#if defined(YABI_HAS_DWORD)
+    DWordType p = (DWordType)a * b + *c;
+    *c = (WordType)p;
+    return (WordType)(p >> YABI_WORD_BIT_SIZE);
+#elif defined(YABI_HAS_MSVC_X64)
+    unsigned long long hi;
+    unsigned long long lo = _umul128(a, b, &hi);
+    return hi + _addcarry_u64(0, lo, *c, (unsigned long long*)c);
+#else
+    //we use the FOIL method for half-words so as not to
+    //lose overflow bits.
+    // (ahi + alo)(bhi + blo)
+    // = ahi*bhi + ahi*blo + alo*bhi + alo*blo
+    WordType ahi = HI_N_BITS(a, YABI_WORD_BIT_SIZE >> 1);
+    WordType bhi = HI_N_BITS(b, YABI_WORD_BIT_SIZE >> 1);
+    WordType alo = a & (((WordType)1 << (YABI_WORD_BIT_SIZE >> 1)) - 1);
+    WordType blo = b & (((WordType)1 << (YABI_WORD_BIT_SIZE >> 1)) - 1);
+    WordType tmp; //scratch space
+    WordType carry;
+    carry = ahi * bhi;
+    tmp = ahi * blo;
+    carry += HI_N_BITS(tmp, YABI_WORD_BIT_SIZE >> 1);
+    carry += addAndCarry(*c, tmp << (YABI_WORD_BIT_SIZE >> 1), 0, c);
+    tmp = alo * bhi;
+    carry += HI_N_BITS(tmp, YABI_WORD_BIT_SIZE >> 1);
+    carry += addAndCarry(*c, tmp << (YABI_WORD_BIT_SIZE >> 1), 0, c);
+    carry += addAndCarry(*c, alo * blo, 0, c);
+    return carry;
+#endif
+}
+
+/** Counts the leading zero bits of a nonzero word. */
+static inline int leadingZeros(WordType a) {
+#if defined(__GNUC__) && !defined(YABI_PORTABLE_PRIMITIVES)
+    return __builtin_clzll(a) - (64 - YABI_WORD_BIT_SIZE);
+#else
+    int n = 0;
+    for(int shf = YABI_WORD_BIT_SIZE >> 1; shf > 0; shf >>= 1) {
+        if(!(a >> (YABI_WORD_BIT_SIZE - shf))) {
+            a <<= shf;
+            n += shf;
+        }
+    }
+    return n;
+#endif
+}
+
+/** Counts the trailing zero bits of a nonzero native integer. */
+static inline int trailingZeros(uint64_t a) {
+#if defined(__GNUC__) && !defined(YABI_PORTABLE_PRIMITIVES)
+    return __builtin_ctzll(a);
+#else
+    int n = 0;
+    for(int shf = 32; shf > 0; shf >>= 1) {
+        if(!(a & (((uint64_t)1 << shf) - 1))) {
+            a >>= shf;
+            n += shf;
+        }
+    }
+    return n;
+#endif
+}
+
+/**
+ * Divides the double word hi:lo by d, returning the quotient and storing
+ * the remainder in r. Requires hi < d and d normalized (top bit set).
+ */
+static inline WordType divWide(WordType hi, WordType lo, WordType d, WordType* r) {
+#if defined(YABI_HAS_DWORD) && YABI_WORD_BIT_SIZE <= 32
+    DWordType n = (DWordType)hi << YABI_WORD_BIT_SIZE | lo;
+    *r = (WordType)(n % d);
+    return (WordType)(n / d);
+#elif YABI_WORD_BIT_SIZE == 64 && defined(__GNUC__) && defined(__x86_64__) \
+        && !defined(YABI_PORTABLE_PRIMITIVES)
+    // 128 bit division is a library call, but the hardware divides a
+    // double word by a word directly when the quotient fits
+    WordType q;
+    __asm__("divq %4" : "=a"(q), "=d"(*r) : "a"(lo), "d"(hi), "rm"(d));
+    return q;
+#elif defined(YABI_HAS_MSVC_X64) && _MSC_VER >= 1920
+    unsigned long long rem;
+    WordType q = _udiv128(hi, lo, d, &rem);
+    *r = rem;
+    return q;
+#else
+    //long division in half-words, estimating each quotient digit from the
+    //top half of d and correcting it at most twice (Hacker's Delight divlu)
+    const WordType b = (WordType)1 << (YABI_WORD_BIT_SIZE >> 1);
+    const WordType mask = b - 1;
+    WordType dhi = d >> (YABI_WORD_BIT_SIZE >> 1);
+    WordType dlo = d & mask;
+    WordType lohi = lo >> (YABI_WORD_BIT_SIZE >> 1);
+    WordType lolo = lo & mask;
+    WordType q1 = hi / dhi;
+    WordType rhat = hi - q1 * dhi;
+    while(q1 >= b || (WordType)(q1 * dlo) > (WordType)(b * rhat + lohi)) {
+        q1--;
+        rhat += dhi;
+        if(rhat >= b) {
+            break;
+        }
+    }
+    WordType mid = (WordType)(hi * b + lohi - q1 * d);
+    WordType q0 = mid / dhi;
+    rhat = mid - q0 * dhi;
+    while(q0 >= b || (WordType)(q0 * dlo) > (WordType)(b * rhat + lolo)) {
+        q0--;
+        rhat += dhi;
+        if(rhat >= b) {
+            break;
+        }
+    }
+    *r = (WordType)(mid * b + lolo - q0 * d);
+    return (WordType)(q1 * b + q0);
+#endif
+}
+
+/**
+ * The reciprocal floor((B^2 - 1) / d) - B of a normalized word d, where B is
+ * 2^YABI_WORD_BIT_SIZE. With it divWidePre divides by d without a divide.
+ */
+static inline WordType wordInverse(WordType d) {
+    WordType r;
+    return divWide((WordType)~d, (WordType)~(WordType)0, d, &r);
+}
+
+/**
+ * Same as divWide, given the reciprocal v of d. The quotient is estimated
+ * from the high word of v * hi and corrected at most twice (Moller and
+ * Granlund, "Improved division by invariant integers").
+ */
+static inline WordType divWidePre(WordType hi, WordType lo, WordType d, WordType v, WordType* r) {
+    // (q1, q0) = v * hi + (hi, lo)
+    WordType q0 = lo;
+    WordType q1 = (WordType)(mulAndCarry(v, hi, &q0) + hi + 1);
+    WordType rem = (WordType)(lo - q1 * d);
+    // this one goes either way, so avoid a branch
+    WordType mask = (WordType)-(WordType)(rem > q0);
+    q1 += mask;
+    rem += mask & d;
+    // and this one is rare
+    if(rem >= d) {
+        q1++;
+        rem -= d;
+    }
+    *r = rem;
+    return q1;
+}
+
+// number of words in a 64 bit native integer
+#define NATIVE_WORDS (64 / YABI_WORD_BIT_SIZE)
+
+/** Splits a native integer into NATIVE_WORDS words, low word first. */
+static inline void nativeWords(uint64_t x, WordType* w) {
+    for(int i = 0; i < NATIVE_WORDS; i++) {
+        w[i] = (WordType)x;
+        // two shifts, since one by the full width is undefined for 64 bit words
+        x = (x >> (YABI_WORD_BIT_SIZE - 1)) >> 1;
+    }
+}
+
+// Reference count updates. They are atomic when YABI_ATOMIC_REFCOUNT is
+// defined, so that BigInts can be shared between threads
+#if defined(YABI_ATOMIC_REFCOUNT) && (defined(__GNUC__) || defined(__clang__))
+static inline size_t refCountLoad(const BigInt* a) {
+    return __atomic_load_n(&a->refCount, __ATOMIC_ACQUIRE);
+}
+static inline void refCountInc(BigInt* a) {
+    __atomic_fetch_add(&a->refCount, 1, __ATOMIC_RELAXED);
+}
+// returns the count before the decrement
+static inline size_t refCountDec(BigInt* a) {
+    return __atomic_fetch_sub(&a->refCount, 1, __ATOMIC_ACQ_REL);
+}
+#elif defined(YABI_ATOMIC_REFCOUNT) && defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+static inline size_t refCountLoad(const BigInt* a) {
+    // a locked add of zero, which is also a full barrier
+    return (size_t)_InterlockedOr64((volatile __int64*)&a->refCount, 0);
+}
+static inline void refCountInc(BigInt* a) {
+    _InterlockedIncrement64((volatile __int64*)&a->refCount);
+}
+static inline size_t refCountDec(BigInt* a) {
+    return (size_t)_InterlockedDecrement64((volatile __int64*)&a->refCount) + 1;
+}
+#elif defined(YABI_ATOMIC_REFCOUNT)
+    #error YABI_ATOMIC_REFCOUNT needs GCC, Clang or 64 bit MSVC
+#else
+static inline size_t refCountLoad(const BigInt* a) {
+    return a->refCount;
+}
+static inline void refCountInc(BigInt* a) {
+    a->refCount++;
+}
+static inline size_t refCountDec(BigInt* a) {
+    return a->refCount--;
+}
+#endif
+
+#if defined(_MSC_VER)
+    #define YABI_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+    #define YABI_THREAD_LOCAL _Thread_local
+#else
+    #define YABI_THREAD_LOCAL __thread
+#endif
+
+// Fork and join, see threads.c. A forked task may run on any thread until
+// joinTask returns, which runs it on the calling thread when no other has
+// started it. Work only splits into tasks when PARALLEL_WORTH its n words,
+// so that smaller operands never get as far as reading whether there is a
+// pool at all.
+typedef struct parTask {
+    void (*run)(void* arg);
+    void* arg;
+    long state;
+    struct taskClaim* claim;
+    // the queue the task went onto, and whether it is still there, which
+    // only changes under the queue's lock
+    struct taskQueue* home;
+    int queued;
+} parTask;
+
+#define PARALLEL_WORTH(n) ((n) >= YABI_PARALLEL_THRESHOLD && parallelOn())
+
+int parallelOn(void);
+void forkTask(parTask* t, void (*run)(void* arg), void* arg);
+void joinTask(parTask* t);
+
+// Scratch space from a workspace, see yabi_workspace_t. takeScratch falls
+// back to allocating when the workspace is too short, and dropScratch only
+// frees what was allocated
+static inline WordType* takeScratch(yabi_workspace_t* ws, size_t n) {
+    if(n == 0) {
+        return NULL;
+    }
+    if(ws && ws->len >= n) {
+        return ws->data;
+    }
+    return YABI_MALLOC(n * sizeof(WordType));
+}
+static inline void dropScratch(yabi_workspace_t* ws, WordType* scratch) {
+    if(scratch && !(ws && scratch == ws->data)) {
+        YABI_FREE(scratch);
+    }
+}
+
+/*
+ * Passes over rows of words that do the same to every word. Rows of at
+ * least ROW_KERNEL_BYTES go to the kernels in kernels.c, which use the
+ * widest vector instructions the processor has, and shorter ones are done
+ * here by the portable loops, which the kernels also finish with. Each
+ * row is n words long, and `buffer` may be the same as any of the row
+ * arguments.
+ */
+#define ROW_KERNEL_BYTES 32
+#define WIDE_ROW(n) ((n) * sizeof(WordType) >= ROW_KERNEL_BYTES)
+
+void andRowsWide(size_t n, const WordType* a, const WordType* b, WordType* buffer);
+void orRowsWide(size_t n, const WordType* a, const WordType* b, WordType* buffer);
+void xorRowsWide(size_t n, const WordType* a, const WordType* b, WordType* buffer);
+void notRowWide(size_t n, const WordType* a, WordType* buffer);
+void shlRowWide(size_t n, const WordType* a, int s, WordType* buffer);
+void shrRowWide(size_t n, const WordType* a, int s, WordType* buffer);
+size_t diffRowsWide(size_t n, const WordType* a, const WordType* b);
+size_t spanRowWide(size_t n, const WordType* a, WordType fill);
+// for tests: switches every kernel to the widest the processor supports up
+// to the YABI_SIMD_LEVEL `level`, and returns the level switched to
+int useKernelLevel(int level);
+
+static inline void andRowsPortable(size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    for(size_t i = 0; i < n; i++) {
+        buffer[i] = a[i] & b[i];
+    }
+}
+
+static inline void orRowsPortable(size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    for(size_t i = 0; i < n; i++) {
+        buffer[i] = a[i] | b[i];
+    }
+}
+
+static inline void xorRowsPortable(size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    for(size_t i = 0; i < n; i++) {
+        buffer[i] = a[i] ^ b[i];
+    }
+}
+
+static inline void notRowPortable(size_t n, const WordType* a, WordType* buffer) {
+    for(size_t i = 0; i < n; i++) {
+        buffer[i] = ~a[i];
+    }
+}
+
+// hi to lo, so that `buffer` may also be above `a`
+static inline void shlRowPortable(size_t n, const WordType* a, int s, WordType* buffer) {
+    for(size_t i = n - 1; i > 0; i--) {
+        buffer[i] = (WordType)(a[i] << s) | (WordType)(a[i - 1] >> (YABI_WORD_BIT_SIZE - s));
+    }
+    buffer[0] = (WordType)(a[0] << s);
+}
+
+// lo to hi, so that `buffer` may also be below `a`
+static inline void shrRowPortable(size_t n, const WordType* a, int s, WordType* buffer) {
+    for(size_t i = 0; i < n - 1; i++) {
+        buffer[i] = (WordType)(a[i] >> s) | (WordType)(a[i + 1] << (YABI_WORD_BIT_SIZE - s));
+    }
+    buffer[n - 1] = a[n - 1] >> s;
+}
+
+static inline size_t diffRowsPortable(size_t n, const WordType* a, const WordType* b) {
+    while(n > 0 && a[n - 1] == b[n - 1]) {
+        n--;
+    }
+    return n;
+}
+
+static inline size_t spanRowPortable(size_t n, const WordType* a, WordType fill) {
+    while(n > 0 && a[n - 1] == fill) {
+        n--;
+    }
+    return n;
+}
+
+// buffer = a & b, a | b and a ^ b
+static inline void andRows(size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    if(WIDE_ROW(n)) {
+        andRowsWide(n, a, b, buffer);
+    } else {
+        andRowsPortable(n, a, b, buffer);
+    }
+}
+
+static inline void orRows(size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    if(WIDE_ROW(n)) {
+        orRowsWide(n, a, b, buffer);
+    } else {
+        orRowsPortable(n, a, b, buffer);
+    }
+}
+
+static inline void xorRows(size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    if(WIDE_ROW(n)) {
+        xorRowsWide(n, a, b, buffer);
+    } else {
+        xorRowsPortable(n, a, b, buffer);
+    }
+}
+
+// buffer = ~a
+static inline void notRow(size_t n, const WordType* a, WordType* buffer) {
+    if(WIDE_ROW(n)) {
+        notRowWide(n, a, buffer);
+    } else {
+        notRowPortable(n, a, buffer);
+    }
+}
+
+// shifts the unsigned `a` left by s < w bits into `buffer`, and returns the
+// bits shifted out. `buffer` may also be above `a`
+static inline WordType shiftLeftRow(size_t n, const WordType* a, int s, WordType* buffer) {
+    if(s == 0) {
+        memmove(buffer, a, n * sizeof(WordType));
+        return 0;
+    }
+    WordType out = a[n - 1] >> (YABI_WORD_BIT_SIZE - s);
+    if(WIDE_ROW(n)) {
+        shlRowWide(n, a, s, buffer);
+    } else {
+        shlRowPortable(n, a, s, buffer);
+    }
+    return out;
+}
+
+// shifts the unsigned `a` right by s < w bits into `buffer`, which may
+// also be below `a`
+static inline void shiftRightRow(size_t n, const WordType* a, int s, WordType* buffer) {
+    if(s == 0) {
+        memmove(buffer, a, n * sizeof(WordType));
+    } else if(WIDE_ROW(n)) {
+        shrRowWide(n, a, s, buffer);
+    } else {
+        shrRowPortable(n, a, s, buffer);
+    }
+}
+
+// the number of words up to the highest one in which a and b differ, 0
+// if they are equal
+static inline size_t diffRows(size_t n, const WordType* a, const WordType* b) {
+    return WIDE_ROW(n) ? diffRowsWide(n, a, b) : diffRowsPortable(n, a, b);
+}
+
+// the number of words up to the highest one of a that is not `fill`, 0 if
+// all are
+static inline size_t spanRow(size_t n, const WordType* a, WordType fill) {
+    // most numbers have no words to drop at all
+    if(n == 0 || a[n - 1] != fill) {
+        return n;
+    }
+    return WIDE_ROW(n) ? spanRowWide(n, a, fill) : spanRowPortable(n, a, fill);
+}
+
+// the minimal length of the n-word two's complement number in `buffer`
+static inline size_t trimBuffer(size_t n, const WordType* buffer) {
+    WordType sign = (WordType)-HI_BIT(buffer[n - 1]);
+    size_t len = spanRow(n, buffer, sign);
+    // keep a word to hold the sign
+    if(len == 0 || HI_BIT(buffer[len - 1]) != (sign & 1)) {
+        len++;
+    }
+    return len;
+}
+
 // helpers
-int addAndCarry(WordType a, WordType b, WordType c, WordType* d);
-WordType mulAndCarry(WordType a, WordType b, WordType* c);
+WordType addRows(size_t n, const WordType* a, const WordType* b, WordType* buffer);
+WordType subRows(size_t n, const WordType* a, const WordType* b, WordType* buffer);
+WordType addWordRow(size_t n, const WordType* a, WordType w, WordType* buffer);
+WordType subWordRow(size_t n, const WordType* a, WordType w, WordType* buffer);
+WordType mulRow(size_t n, const WordType* a, WordType w, WordType* buffer);
+WordType addMulRow(size_t n, const WordType* a, WordType w, WordType* buffer);
+WordType subMulRow(size_t n, const WordType* a, WordType w, WordType* buffer);
 size_t addBuffers(
     size_t alen, const WordType* a,
     size_t blen, const WordType* b,
@@ -23,10 +492,31 @@ size_t addBuffers(
 size_t mulBuffers(
     size_t alen, const WordType* adata,
     size_t blen, const WordType* bdata,
-    size_t len, WordType* buffer);
+    size_t len, WordType* buffer, yabi_workspace_t* ws);
+size_t mulScratchLen(size_t n);
+void mulUnsigned(
+    size_t alen, const WordType* adata,
+    size_t blen, const WordType* bdata,
+    WordType* buffer, WordType* scratch);
+void sqrUnsigned(size_t n, const WordType* a, WordType* buffer, WordType* scratch);
+int nttFits(size_t alen, size_t blen);
+size_t nttScratchLen(size_t alen, size_t blen);
+void mulNTT(
+    size_t alen, const WordType* adata,
+    size_t blen, const WordType* bdata,
+    WordType* buffer, WordType* scratch);
+WordType divremWord(size_t n, const WordType* u, WordType d, WordType* q);
+size_t divremScratchLen(size_t un, size_t n);
+WordType divremNormalized(size_t un, WordType* u, size_t n, const WordType* v, WordType* q, WordType* scratch);
 int eqBuffers(size_t alen, const WordType* a, size_t blen, const WordType* b);
+int nativeValue(const BigInt* a, uint64_t* value);
+int loadMagnitude(const BigInt* a, size_t n, WordType* buffer);
+size_t storeUnsigned(size_t n, const WordType* x, size_t len, WordType* buffer);
 int cmpBuffers(size_t alen, const WordType* a, size_t blen, const WordType* b, int useSign);
 size_t lshiftBuffers(size_t alen, const WordType* a, size_t amt, size_t len, WordType* buffer);
 size_t rshiftBuffers(size_t alen, const WordType* a, size_t amt, size_t len, WordType* buffer, int useSign);
+void addBatches(size_t n, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, int negateb, size_t rlen, const yabi_batch_t* r);
+void cmpBatches(size_t n, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, int8_t* r);
+BigInt* reserveInto(BigInt** dst, size_t len, const BigInt** a, const BigInt** b, BigInt** shared);
 
 #endif
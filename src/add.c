@@ -107,9 +107,10 @@ BigInt* yabi_negate(const BigInt* a) {
     BigInt* res = YABI_NEW_BIGINT(a->len + 1);
     res->refCount = 0;
     res->len = a->len + 1;
+    res->cap = res->len;
     size_t len = yabi_negateToBuf(a, res->len, res->data);
     if(len != res->len) {
-        YABI_RESIZE_BIGINT(res, len);
+        RESIZE_BIGINT(res, len);
     }
     return res;
 }
@@ -127,9 +128,10 @@ BigInt* yabi_add(const BigInt* a, const BigInt* b) {
     BigInt* res = YABI_NEW_BIGINT(len);
     res->refCount = 0;
     res->len = len;
+    res->cap = res->len;
     len = addBuffers(a->len, a->data, b->len, b->data, 0, len, res->data);
     if(len != res->len) {
-        YABI_RESIZE_BIGINT(res, len);
+        RESIZE_BIGINT(res, len);
     }
     return res;
 }
@@ -139,9 +141,170 @@ BigInt* yabi_sub(const BigInt* a, const BigInt* b) {
     BigInt* res = YABI_NEW_BIGINT(len);
     res->refCount = 0;
     res->len = len;
+    res->cap = res->len;
     len = addBuffers(a->len, a->data, b->len, b->data, 1, len, res->data);
     if(len != res->len) {
-        YABI_RESIZE_BIGINT(res, len);
+        RESIZE_BIGINT(res, len);
     }
     return res;
 }
+
+// adds the native integer with words b and sign extension word bext to a.
+// Once b and its carry are used up, the rest of a passes through as it is,
+// so adding a small number to a large one in place only touches the low
+// words
+static size_t addNative(const BigInt* a, const WordType* b, WordType bext, size_t len, WordType* buffer) {
+    size_t alen = a->len;
+    const WordType* adata = a->data;
+    WordType aext = (WordType)-HI_BIT(adata[alen - 1]);
+    // the sum always fits in one more word than the longer operand
+    size_t stop = min(max(alen, NATIVE_WORDS) + 1, len);
+    int carry = 0;
+    size_t i;
+    for(i = 0; i < stop; i++) {
+        if(i >= NATIVE_WORDS && (WordType)carry == (bext & 1)) {
+            // adding bext and the carry leaves every word of a as it is
+            size_t n = i < alen ? min(alen, stop) - i : 0;
+            if(buffer != adata) {
+                memcpy(buffer + i, adata + i, n * sizeof(WordType));
+            }
+            memset(buffer + i + n, aext, (stop - i - n) * sizeof(WordType));
+            break;
+        }
+        WordType x = i < alen ? adata[i] : aext;
+        WordType y = i < NATIVE_WORDS ? b[i] : bext;
+        carry = addAndCarry(x, y, carry, &buffer[i]);
+    }
+    WordType sign = (WordType)-HI_BIT(buffer[stop - 1]);
+    memset(buffer + stop, sign, (len - stop) * sizeof(WordType));
+    // shrink away extra sign words
+    while(stop > 1 && buffer[stop - 1] == sign && HI_BIT(buffer[stop - 2]) == (sign & 1)) {
+        stop--;
+    }
+    return stop;
+}
+
+static BigInt* addNativeAlloc(const BigInt* a, const WordType* b, WordType bext) {
+    size_t len = max(a->len, NATIVE_WORDS) + 1;
+    BigInt* res = YABI_NEW_BIGINT(len);
+    res->refCount = 0;
+    res->len = len;
+    res->cap = res->len;
+    size_t newLen = addNative(a, b, bext, len, res->data);
+    if(newLen != len) {
+        RESIZE_BIGINT(res, newLen);
+    }
+    return res;
+}
+
+size_t yabi_add_siToBuf(const BigInt* a, int64_t b, size_t len, WordType* buffer) {
+    WordType words[NATIVE_WORDS];
+    nativeWords((uint64_t)b, words);
+    return addNative(a, words, (WordType)-(b < 0), len, buffer);
+}
+
+size_t yabi_add_uiToBuf(const BigInt* a, uint64_t b, size_t len, WordType* buffer) {
+    WordType words[NATIVE_WORDS];
+    nativeWords(b, words);
+    return addNative(a, words, 0, len, buffer);
+}
+
+// -b is 0 - b in 64 bits, extended with ones unless b <= 0
+size_t yabi_sub_siToBuf(const BigInt* a, int64_t b, size_t len, WordType* buffer) {
+    WordType words[NATIVE_WORDS];
+    nativeWords(0 - (uint64_t)b, words);
+    return addNative(a, words, (WordType)-(b > 0), len, buffer);
+}
+
+size_t yabi_sub_uiToBuf(const BigInt* a, uint64_t b, size_t len, WordType* buffer) {
+    WordType words[NATIVE_WORDS];
+    nativeWords(0 - b, words);
+    return addNative(a, words, (WordType)-(b != 0), len, buffer);
+}
+
+BigInt* yabi_add_si(const BigInt* a, int64_t b) {
+    WordType words[NATIVE_WORDS];
+    nativeWords((uint64_t)b, words);
+    return addNativeAlloc(a, words, (WordType)-(b < 0));
+}
+
+BigInt* yabi_add_ui(const BigInt* a, uint64_t b) {
+    WordType words[NATIVE_WORDS];
+    nativeWords(b, words);
+    return addNativeAlloc(a, words, 0);
+}
+
+BigInt* yabi_sub_si(const BigInt* a, int64_t b) {
+    WordType words[NATIVE_WORDS];
+    nativeWords(0 - (uint64_t)b, words);
+    return addNativeAlloc(a, words, (WordType)-(b > 0));
+}
+
+BigInt* yabi_sub_ui(const BigInt* a, uint64_t b) {
+    WordType words[NATIVE_WORDS];
+    nativeWords(0 - b, words);
+    return addNativeAlloc(a, words, (WordType)-(b != 0));
+}
+
+BigInt* yabi_add_into(BigInt** dst, const BigInt* a, const BigInt* b) {
+    size_t len = max(a->len, b->len) + 1;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, &b, &shared);
+    res->len = addBuffers(a->len, a->data, b->len, b->data, 0, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_sub_into(BigInt** dst, const BigInt* a, const BigInt* b) {
+    size_t len = max(a->len, b->len) + 1;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, &b, &shared);
+    res->len = addBuffers(a->len, a->data, b->len, b->data, 1, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_negate_into(BigInt** dst, const BigInt* a) {
+    size_t len = a->len + 1;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, NULL, &shared);
+    res->len = yabi_negateToBuf(a, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_add_si_into(BigInt** dst, const BigInt* a, int64_t b) {
+    size_t len = max(a->len, NATIVE_WORDS) + 1;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, NULL, &shared);
+    res->len = yabi_add_siToBuf(a, b, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_add_ui_into(BigInt** dst, const BigInt* a, uint64_t b) {
+    size_t len = max(a->len, NATIVE_WORDS) + 1;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, NULL, &shared);
+    res->len = yabi_add_uiToBuf(a, b, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_sub_si_into(BigInt** dst, const BigInt* a, int64_t b) {
+    size_t len = max(a->len, NATIVE_WORDS) + 1;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, NULL, &shared);
+    res->len = yabi_sub_siToBuf(a, b, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_sub_ui_into(BigInt** dst, const BigInt* a, uint64_t b) {
+    size_t len = max(a->len, NATIVE_WORDS) + 1;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, NULL, &shared);
+    res->len = yabi_sub_uiToBuf(a, b, len, res->data);
+    yabi_release(shared);
+    return res;
+}
@@ -0,0 +1,145 @@
+#include "bigint_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Batches of fixed size integers, see yabi_batch_t. Sums, differences and
+ * comparisons are done by the column kernels in kernels.c. The bitwise
+ * operations need no carries, so they are done by the row kernels on
+ * whatever rows the layout has: a column of each word position, or each
+ * value, or all of them at once when they follow each other without gaps.
+ * Products are done one value at a time by mulBuffers.
+ */
+
+#define BATCH_AND 0
+#define BATCH_OR 1
+#define BATCH_XOR 2
+#define BATCH_COMPL 3
+
+// values in columns are gathered into rows of this many words on the stack
+// to be multiplied, and into allocated ones when they are longer
+#define BATCH_LOCAL_WORDS 96
+
+static void bitwiseRow(int op, size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    switch(op) {
+    case BATCH_AND:
+        andRows(n, a, b, buffer);
+        break;
+    case BATCH_OR:
+        orRows(n, a, b, buffer);
+        break;
+    case BATCH_XOR:
+        xorRows(n, a, b, buffer);
+        break;
+    default:
+        notRow(n, a, buffer);
+        break;
+    }
+}
+
+static inline WordType bitwiseWord(int op, WordType x, WordType y) {
+    switch(op) {
+    case BATCH_AND:
+        return x & y;
+    case BATCH_OR:
+        return x | y;
+    case BATCH_XOR:
+        return x ^ y;
+    default:
+        return (WordType)~x;
+    }
+}
+
+// BATCH_COMPL ignores `b`, which may be `a`
+static void bitwiseBatch(
+        int op, size_t count, size_t len,
+        const yabi_batch_t* a, const yabi_batch_t* b,
+        size_t rlen, const yabi_batch_t* r) {
+    size_t n = min(len, rlen);
+    if(a->lane == 1 && b->lane == 1 && r->lane == 1) {
+        for(size_t j = 0; j < n; j++) {
+            bitwiseRow(op, count, a->data + j * a->word, b->data + j * b->word, r->data + j * r->word);
+        }
+    } else if(a->word == 1 && b->word == 1 && r->word == 1) {
+        if(a->lane == n && b->lane == n && r->lane == n) {
+            bitwiseRow(op, count * n, a->data, b->data, r->data);
+        } else {
+            for(size_t i = 0; i < count; i++) {
+                bitwiseRow(op, n, a->data + i * a->lane, b->data + i * b->lane, r->data + i * r->lane);
+            }
+        }
+    } else {
+        for(size_t i = 0; i < count; i++) {
+            for(size_t j = 0; j < n; j++) {
+                WordType x = a->data[i * a->lane + j * a->word];
+                WordType y = b->data[i * b->lane + j * b->word];
+                r->data[i * r->lane + j * r->word] = bitwiseWord(op, x, y);
+            }
+        }
+    }
+    // the operation on the signs is the sign of the result
+    if(rlen > len) {
+        for(size_t i = 0; i < count; i++) {
+            WordType* v = r->data + i * r->lane;
+            WordType fill = (WordType)-HI_BIT(v[(len - 1) * r->word]);
+            for(size_t j = len; j < rlen; j++) {
+                v[j * r->word] = fill;
+            }
+        }
+    }
+}
+
+void yabi_batch_add(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r) {
+    addBatches(count, len, a, b, 0, rlen, r);
+}
+
+void yabi_batch_sub(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r) {
+    addBatches(count, len, a, b, 1, rlen, r);
+}
+
+void yabi_batch_mul(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r) {
+    if(a->word == 1 && b->word == 1 && r->word == 1) {
+        for(size_t i = 0; i < count; i++) {
+            mulBuffers(len, a->data + i * a->lane, len, b->data + i * b->lane, rlen, r->data + i * r->lane, NULL);
+        }
+        return;
+    }
+    WordType local[BATCH_LOCAL_WORDS];
+    size_t words = 2 * len + rlen;
+    WordType* x = words <= BATCH_LOCAL_WORDS ? local : YABI_MALLOC(words * sizeof(WordType));
+    WordType* y = x + len;
+    WordType* z = y + len;
+    for(size_t i = 0; i < count; i++) {
+        for(size_t j = 0; j < len; j++) {
+            x[j] = a->data[i * a->lane + j * a->word];
+            y[j] = b->data[i * b->lane + j * b->word];
+        }
+        mulBuffers(len, x, len, y, rlen, z, NULL);
+        for(size_t j = 0; j < rlen; j++) {
+            r->data[i * r->lane + j * r->word] = z[j];
+        }
+    }
+    if(x != local) {
+        YABI_FREE(x);
+    }
+}
+
+void yabi_batch_and(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r) {
+    bitwiseBatch(BATCH_AND, count, len, a, b, rlen, r);
+}
+
+void yabi_batch_or(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r) {
+    bitwiseBatch(BATCH_OR, count, len, a, b, rlen, r);
+}
+
+void yabi_batch_xor(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, size_t rlen, const yabi_batch_t* r) {
+    bitwiseBatch(BATCH_XOR, count, len, a, b, rlen, r);
+}
+
+void yabi_batch_compl(size_t count, size_t len, const yabi_batch_t* a, size_t rlen, const yabi_batch_t* r) {
+    bitwiseBatch(BATCH_COMPL, count, len, a, a, rlen, r);
+}
+
+void yabi_batch_cmp(size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, int8_t* r) {
+    cmpBatches(count, len, a, b, r);
+}
@@ -1,36 +1,7 @@
 #include "bigint_internal.h"
+#include <stdlib.h>
 #include <string.h>
 
-/** Adds three unsigned ints and returns the carry out. */
-int addAndCarry(WordType a, WordType b, WordType c, WordType* d) {
-    WordType ab = a + b;
-    WordType abc = ab + c;
-    *d = abc;
-    return (ab < a) + (abc < ab);
-}
-
-WordType mulAndCarry(WordType a, WordType b, WordType* c) {
-    //we use the FOIL method for half-words so as not to
-    //lose overflow bits.
-    // (ahi + alo)(bhi + blo)
-    // = ahi*bhi + ahi*blo + alo*bhi + alo*blo
-    WordType ahi = HI_N_BITS(a, YABI_WORD_BIT_SIZE >> 1);
-    WordType bhi = HI_N_BITS(b, YABI_WORD_BIT_SIZE >> 1);
-    WordType alo = a & (((WordType)1 << (YABI_WORD_BIT_SIZE >> 1)) - 1);
-    WordType blo = b & (((WordType)1 << (YABI_WORD_BIT_SIZE >> 1)) - 1);
-    WordType tmp; //scratch space
-    WordType carry;
-    carry = ahi * bhi;
-    tmp = ahi * blo;
-    carry += HI_N_BITS(tmp, YABI_WORD_BIT_SIZE >> 1);
-    carry += addAndCarry(*c, tmp << (YABI_WORD_BIT_SIZE >> 1), 0, c);
-    tmp = alo * bhi;
-    carry += HI_N_BITS(tmp, YABI_WORD_BIT_SIZE >> 1);
-    carry += addAndCarry(*c, tmp << (YABI_WORD_BIT_SIZE >> 1), 0, c);
-    carry += addAndCarry(*c, alo * blo, 0, c);
-    return carry;
-}
-
 int cmpBuffers(size_t alen, const WordType* a, size_t blen, const WordType* b, int useSign) {
     int asign = HI_BIT(a[alen - 1]);
     int bsign = HI_BIT(b[blen - 1]);
@@ -38,30 +9,23 @@ int cmpBuffers(size_t alen, const WordType* a, size_t blen, const WordType* b, i
     if(useSign && (asign ^ bsign)) {
         return bsign - asign;
     }
-    // normalize alen and blen (trim leading sign words)
-    while(alen > 1 && a[alen - 1] == (useSign && asign)) {
-        alen--;
-    }
-    while(blen > 1 && b[blen - 1] == (useSign && bsign)) {
-        blen--;
-    }
+    // drop the leading sign words, which are the same for both here
+    WordType fill = (WordType)-(useSign && asign);
+    alen = spanRow(alen, a, fill);
+    blen = spanRow(blen, b, fill);
     if(alen != blen) {
         // one is longer than the other
         // and comparison is based on length
-        // this assumes that the buffers are trimmed to minimum size
         int res = (alen > blen) * 2 - 1;
-        return (useSign && asign) ? -res : res;
-    } else {
-        // the first differing words determine the comparison
-        for(size_t i = alen; i > 0; i--) {
-            if(a[i - 1] != b[i - 1]) {
-                int res = (a[i - 1] > b[i - 1]) * 2 - 1;
-                return res;
-            }
-        }
+        return fill ? -res : res;
+    }
+    // the first differing words determine the comparison
+    size_t i = diffRows(alen, a, b);
+    if(i == 0) {
         // a and b are well and truly equal
         return 0;
     }
+    return (a[i - 1] > b[i - 1]) * 2 - 1;
 }
 
 int eqBuffers(size_t alen, const WordType* a, size_t blen, const WordType* b) {
@@ -71,3 +35,187 @@ int eqBuffers(size_t alen, const WordType* a, size_t blen, const WordType* b) {
     }
     return memcmp(a, b, alen * sizeof(WordType)) == 0;
 }
+
+// the value of a, if it fits in a native integer once its redundant sign
+// words are dropped. Returns 0 if it does not
+int nativeValue(const BigInt* a, uint64_t* value) {
+    size_t alen = a->len;
+    WordType sign = (WordType)-HI_BIT(a->data[alen - 1]);
+    while(alen > 1 && a->data[alen - 1] == sign && HI_BIT(a->data[alen - 2]) == (sign & 1)) {
+        alen--;
+    }
+    if(alen > NATIVE_WORDS) {
+        return 0;
+    }
+    // sign extend to 64 bits
+    uint64_t v = (uint64_t)0 - (sign & 1);
+    for(size_t i = alen; i > 0; i--) {
+        v = (v << (YABI_WORD_BIT_SIZE - 1)) << 1 | a->data[i - 1];
+    }
+    *value = v;
+    return 1;
+}
+
+// stores the magnitude of a in the first n >= a->len words of `buffer`,
+// zero extended. `buffer` may be a->data. Returns whether a is negative
+int loadMagnitude(const BigInt* a, size_t n, WordType* buffer) {
+    int negative = HI_BIT(a->data[a->len - 1]);
+    memmove(buffer, a->data, a->len * sizeof(WordType));
+    memset(buffer + a->len, 0, (n - a->len) * sizeof(WordType));
+    if(negative) {
+        for(size_t i = 0; i < a->len; i++) {
+            buffer[i] = ~buffer[i];
+        }
+        addWordRow(n, buffer, 1, buffer);
+    }
+    return negative;
+}
+
+// stores the unsigned n-word x like the ToBuf functions store their
+// results, zero extended or truncated to len words
+size_t storeUnsigned(size_t n, const WordType* x, size_t len, WordType* buffer) {
+    size_t stop = min(n, len);
+    memmove(buffer, x, stop * sizeof(WordType));
+    memset(buffer + stop, 0, (len - stop) * sizeof(WordType));
+    return trimBuffer(len, buffer);
+}
+
+/*
+ * Row kernels. Each of these walks an n-word unsigned row once, keeping its
+ * carry (or borrow) in a local word rather than rippling it through the rest
+ * of the destination. `buffer` may be the same as any of the row arguments.
+ */
+
+// buffer = a + b, returns the carry out
+WordType addRows(size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    int carry = 0;
+    for(size_t i = 0; i < n; i++) {
+        carry = addAndCarry(a[i], b[i], carry, &buffer[i]);
+    }
+    return carry;
+}
+
+// buffer = a - b, returns the borrow out
+WordType subRows(size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    // a - b = a + ~b + 1
+    int carry = 1;
+    for(size_t i = 0; i < n; i++) {
+        carry = addAndCarry(a[i], ~b[i], carry, &buffer[i]);
+    }
+    return !carry;
+}
+
+// buffer = a + w, returns the carry out
+WordType addWordRow(size_t n, const WordType* a, WordType w, WordType* buffer) {
+    size_t i;
+    for(i = 0; i < n && w; i++) {
+        WordType tmp = a[i] + w;
+        w = tmp < w;
+        buffer[i] = tmp;
+    }
+    if(buffer != a && i < n) {
+        memcpy(buffer + i, a + i, (n - i) * sizeof(WordType));
+    }
+    return w;
+}
+
+// buffer = a - w, returns the borrow out
+WordType subWordRow(size_t n, const WordType* a, WordType w, WordType* buffer) {
+    size_t i;
+    for(i = 0; i < n && w; i++) {
+        WordType tmp = a[i] - w;
+        w = tmp > a[i];
+        buffer[i] = tmp;
+    }
+    if(buffer != a && i < n) {
+        memcpy(buffer + i, a + i, (n - i) * sizeof(WordType));
+    }
+    return w;
+}
+
+// buffer = a * w, returns the high word of the product
+WordType mulRow(size_t n, const WordType* a, WordType w, WordType* buffer) {
+    WordType carry = 0;
+    for(size_t i = 0; i < n; i++) {
+        WordType lo = carry;
+        carry = mulAndCarry(a[i], w, &lo);
+        buffer[i] = lo;
+    }
+    return carry;
+}
+
+// buffer += a * w, returns the word carried out of the top
+WordType addMulRow(size_t n, const WordType* a, WordType w, WordType* buffer) {
+    WordType carry = 0;
+    for(size_t i = 0; i < n; i++) {
+        WordType lo = carry;
+        // a[i] * w + carry + buffer[i] < WordType^2, so the high word
+        // cannot overflow
+        WordType hi = mulAndCarry(a[i], w, &lo);
+        hi += addAndCarry(buffer[i], lo, 0, &buffer[i]);
+        carry = hi;
+    }
+    return carry;
+}
+
+// buffer -= a * w, returns the word borrowed from above the top
+WordType subMulRow(size_t n, const WordType* a, WordType w, WordType* buffer) {
+    WordType borrow = 0;
+    for(size_t i = 0; i < n; i++) {
+        WordType lo = borrow;
+        WordType hi = mulAndCarry(a[i], w, &lo);
+        WordType tmp = buffer[i] - lo;
+        hi += tmp > buffer[i];
+        buffer[i] = tmp;
+        borrow = hi;
+    }
+    return borrow;
+}
+
+// makes sure *dst has room for len words and may be written, and returns
+// it. A NULL *dst is allocated as zero. The value in *dst survives only
+// when it is one of the operands `a` and `b` (b may be NULL), which are
+// pointed at the new *dst in case it moved; otherwise it is about to be
+// overwritten and is not copied. A *dst with other owners is left alone
+// and replaced by a fresh BigInt; it is returned in `shared` for the caller
+// to release once the operands have been read. The capacity grows at least
+// geometrically, so a value creeping up a word at a time is only
+// reallocated every so often
+BigInt* reserveInto(BigInt** dst, size_t len, const BigInt** a, const BigInt** b, BigInt** shared) {
+    BigInt* d = *dst;
+    *shared = NULL;
+    int unique = d && refCountLoad(d) == 0;
+    if(unique && d->cap >= len) {
+        return d;
+    }
+    int keepa = *a == d;
+    int keepb = b && *b == d;
+    if(unique && (keepa || keepb)) {
+        size_t dlen = d->len;
+        size_t cap = max(len, d->cap + d->cap / 2);
+        RESIZE_BIGINT(d, cap);
+        d->len = dlen;
+        if(keepa) {
+            *a = d;
+        }
+        if(keepb) {
+            *b = d;
+        }
+    } else {
+        size_t cap = len;
+        if(unique) {
+            cap = max(len, d->cap + d->cap / 2);
+            YABI_FREE_BIGINT(d);
+        } else if(d) {
+            cap = max(len, d->cap);
+            *shared = d;
+        }
+        d = YABI_NEW_BIGINT(cap);
+        d->refCount = 0;
+        d->len = 1;
+        d->cap = cap;
+        d->data[0] = 0;
+    }
+    *dst = d;
+    return d;
+}
@@ -1,10 +1,29 @@
 #include "bigint_internal.h"
 #include <stdlib.h>
 #include <string.h>
-#include <assert.h>
+
+// what folding a row with a sign word of all zeros or all ones does
+#define FOLD_KEEP 0
+#define FOLD_FILL 1
+#define FOLD_FLIP 2
+
+// buffer = a op sign for the n words of a, where `how` is what op does
+// with this sign
+static void foldSign(size_t n, const WordType* a, int how, WordType sign, WordType* buffer) {
+    if(n == 0) {
+        return;
+    }
+    if(how == FOLD_FILL) {
+        memset(buffer, sign, n * sizeof(WordType));
+    } else if(how == FOLD_FLIP) {
+        notRow(n, a, buffer);
+    } else if(buffer != a) {
+        memcpy(buffer, a, n * sizeof(WordType));
+    }
+}
 
 //helper macros for defining the bitwise operations
-#define BITWISE_TOBUF_IMPL(op) \
+#define BITWISE_TOBUF_IMPL(op, rows, fold) \
     size_t stop = max(a->len, b->len); \
     stop = min(stop, len); \
     size_t alen = min(a->len, stop); \
@@ -12,45 +31,33 @@
     size_t upTo = min(alen, blen); \
     WordType asign = -HI_BIT(a->data[alen - 1]); \
     WordType bsign = -HI_BIT(b->data[blen - 1]); \
-    size_t i; \
     /* fold a and b */ \
-    for(i = 0; i < upTo; i++) { \
-        buffer[i] = a->data[i] op b->data[i]; \
-    } \
+    rows(upTo, a->data, b->data, buffer); \
     /* fold a with sign extension of b */ \
-    while(i < alen) { \
-        buffer[i] = a->data[i] op bsign; \
-        i++; \
-    } \
+    foldSign(alen - upTo, a->data + upTo, fold(bsign), bsign, buffer + upTo); \
     /* fold sign extension of a with b */ \
-    while(i < blen) { \
-        buffer[i] = asign op b->data[i]; \
-        i++; \
-    } \
+    foldSign(blen - upTo, b->data + upTo, fold(asign), asign, buffer + upTo); \
     /* fold sign extensions of a and b */ \
-    while(i < len) { \
-        buffer[i++] = asign op bsign; \
-    } \
+    memset(buffer + stop, (WordType)(asign op bsign), (len - stop) * sizeof(WordType)); \
     /* adjust to minimum buffer size */ \
-    int signc = HI_BIT(buffer[stop - 1]); \
-    while(stop > 1 && buffer[stop - 1] == (WordType)-signc) { \
-        stop--; \
-    } \
-    if(HI_BIT(buffer[stop - 1]) != signc) { \
-        stop++; \
-    } \
-    return stop;
+    return trimBuffer(stop, buffer);
+
+// x & 0 is 0 and x & ~0 is x, x | 0 is x and x | ~0 is ~0, x ^ 0 is x and
+// x ^ ~0 is ~x
+#define AND_FOLD(sign) ((sign) ? FOLD_KEEP : FOLD_FILL)
+#define OR_FOLD(sign) ((sign) ? FOLD_FILL : FOLD_KEEP)
+#define XOR_FOLD(sign) ((sign) ? FOLD_FLIP : FOLD_KEEP)
 
 size_t yabi_andToBuf(const BigInt* a, const BigInt* b, size_t len, WordType* buffer) {
-    BITWISE_TOBUF_IMPL(&);
+    BITWISE_TOBUF_IMPL(&, andRows, AND_FOLD);
 }
 
 size_t yabi_orToBuf(const BigInt* a, const BigInt* b, size_t len, WordType* buffer) {
-    BITWISE_TOBUF_IMPL(|);
+    BITWISE_TOBUF_IMPL(|, orRows, OR_FOLD);
 }
 
 size_t yabi_xorToBuf(const BigInt* a, const BigInt* b, size_t len, WordType* buffer) {
-    BITWISE_TOBUF_IMPL(^);
+    BITWISE_TOBUF_IMPL(^, xorRows, XOR_FOLD);
 }
 
 BigInt* yabi_and(const BigInt* a, const BigInt* b) {
@@ -58,9 +65,10 @@ BigInt* yabi_and(const BigInt* a, const BigInt* b) {
     BigInt* res = YABI_NEW_BIGINT(len);
     res->refCount = 0;
     res->len = len;
+    res->cap = res->len;
     len = yabi_andToBuf(a, b, len, res->data);
     if(len != res->len) {
-        YABI_RESIZE_BIGINT(res, len);
+        RESIZE_BIGINT(res, len);
     }
     return res;
 }
@@ -70,9 +78,10 @@ BigInt* yabi_or(const BigInt* a, const BigInt* b) {
     BigInt* res = YABI_NEW_BIGINT(len);
     res->refCount = 0;
     res->len = len;
+    res->cap = res->len;
     len = yabi_orToBuf(a, b, len, res->data);
     if(len != res->len) {
-        YABI_RESIZE_BIGINT(res, len);
+        RESIZE_BIGINT(res, len);
     }
     return res;
 }
@@ -82,29 +91,67 @@ BigInt* yabi_xor(const BigInt* a, const BigInt* b) {
     BigInt* res = YABI_NEW_BIGINT(len);
     res->refCount = 0;
     res->len = len;
+    res->cap = res->len;
     len = yabi_xorToBuf(a, b, len, res->data);
     if(len != res->len) {
-        YABI_RESIZE_BIGINT(res, len);
+        RESIZE_BIGINT(res, len);
     }
     return res;
 }
 
 size_t yabi_complToBuf(const BigInt* a, size_t len, WordType* buffer) {
     size_t stop = min(a->len, len);
-    for(size_t i = 0; i < stop; i++) {
-        buffer[i] = ~a->data[i];
-    }
+    notRow(stop, a->data, buffer);
     //sign extend the buffer
     int signb = HI_BIT(buffer[stop - 1]);
     memset(buffer + stop, (WordType)-signb, (len - stop) * sizeof(WordType));
-    return stop;
+    return trimBuffer(stop, buffer);
 }
 
 BigInt* yabi_compl(const BigInt* a) {
     BigInt* res = YABI_NEW_BIGINT(a->len);
     res->refCount = 0;
     res->len = a->len;
-    size_t s = yabi_complToBuf(a, a->len, res->data);
-    assert(s == a->len);
+    res->cap = res->len;
+    size_t len = yabi_complToBuf(a, a->len, res->data);
+    if(len != res->len) {
+        RESIZE_BIGINT(res, len);
+    }
+    return res;
+}
+
+BigInt* yabi_and_into(BigInt** dst, const BigInt* a, const BigInt* b) {
+    size_t len = max(a->len, b->len);
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, &b, &shared);
+    res->len = yabi_andToBuf(a, b, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_or_into(BigInt** dst, const BigInt* a, const BigInt* b) {
+    size_t len = max(a->len, b->len);
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, &b, &shared);
+    res->len = yabi_orToBuf(a, b, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_xor_into(BigInt** dst, const BigInt* a, const BigInt* b) {
+    size_t len = max(a->len, b->len);
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, &b, &shared);
+    res->len = yabi_xorToBuf(a, b, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_compl_into(BigInt** dst, const BigInt* a) {
+    size_t len = a->len;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, NULL, &shared);
+    res->len = yabi_complToBuf(a, len, res->data);
+    yabi_release(shared);
     return res;
 }
@@ -7,3 +7,33 @@ int yabi_equal(const BigInt* a, const BigInt* b) {
 int yabi_cmp(const BigInt* a, const BigInt* b) {
     return cmpBuffers(a->len, a->data, b->len, b->data, 1);
 }
+
+int yabi_cmp_si(const BigInt* a, int64_t b) {
+    int anegative = HI_BIT(a->data[a->len - 1]);
+    uint64_t v;
+    if(!nativeValue(a, &v)) {
+        // too big either way
+        return anegative ? -1 : 1;
+    }
+    int64_t s = (int64_t)v;
+    return (s > b) - (s < b);
+}
+
+int yabi_cmp_ui(const BigInt* a, uint64_t b) {
+    if(HI_BIT(a->data[a->len - 1])) {
+        return -1;
+    }
+    // a is not negative here, so only leading zero words are redundant
+    size_t alen = a->len;
+    while(alen > 1 && a->data[alen - 1] == 0) {
+        alen--;
+    }
+    if(alen > NATIVE_WORDS) {
+        return 1;
+    }
+    uint64_t v = 0;
+    for(size_t i = alen; i > 0; i--) {
+        v = (v << (YABI_WORD_BIT_SIZE - 1)) << 1 | a->data[i - 1];
+    }
+    return (v > b) - (v < b);
+}
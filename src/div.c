@@ -3,80 +3,288 @@
 #include <stdlib.h>
 #include <assert.h>
 
-// calculates the largest multiple of b that fits into a, returns the quotient
-// and subtracts the appropriate amount from the remainder.
-static WordType simpleDiv(size_t rlen, WordType* rbuf, size_t blen, const WordType* bbuf) {
-    WordType q = 0;
-    size_t shf = rlen;
-    while(rbuf[shf - 1] == 0) {
-        shf--;
-    }
-    shf *= YABI_WORD_BIT_SIZE;
-    while(cmpBuffers(rlen, rbuf, blen, bbuf, 0) >= 0) {
-        size_t shfWords, shfAmt;
-        WordType holder;
-        // calculate the maximum power of two we can divide by
-        while(1) {
-            // number of words to shift right
-            shfWords = shf / YABI_WORD_BIT_SIZE;
-            shfAmt = shf % YABI_WORD_BIT_SIZE;
-            while(shfWords >= rlen) {
-                shfWords--;
-            }
-            // temporary variable for shifted out bits
-            holder = rbuf[shfWords] & (((WordType)1 << shfAmt) - 1);
-            // can we divide by this number
-            rshiftBuffers(rlen - shfWords, rbuf + shfWords, shfAmt, rlen - shfWords, rbuf + shfWords, 0);
-            if(cmpBuffers(rlen - shfWords, rbuf + shfWords, blen, bbuf, 0) >= 0) {
+// divides the n-word unsigned `u`, complemented if `flip` is all ones, by
+// d != 0. Stores the quotient words below qlen in `q` and returns the
+// remainder. Each word costs two multiplications with the reciprocal of d
+// rather than a divide. `q` may be the same as `u`
+static WordType divremWordFlip(size_t n, const WordType* u, WordType flip, WordType d, size_t qlen, WordType* q) {
+    // the reciprocal needs a normalized divisor, so shift both d and u up
+    // until the top bit of d is set. the quotient stays the same
+    int s = leadingZeros(d);
+    d <<= s;
+    WordType inv = wordInverse(d);
+    WordType r = s ? (WordType)(u[n - 1] ^ flip) >> (YABI_WORD_BIT_SIZE - s) : 0;
+    for(size_t i = n; i > 0; i--) {
+        WordType w = (WordType)((u[i - 1] ^ flip) << s);
+        if(s && i > 1) {
+            w |= (WordType)(u[i - 2] ^ flip) >> (YABI_WORD_BIT_SIZE - s);
+        }
+        WordType qw = divWidePre(r, w, d, inv, &r);
+        if(i - 1 < qlen) {
+            q[i - 1] = qw;
+        }
+    }
+    return r >> s;
+}
+
+// divides the n-word unsigned `u` by d != 0, storing the quotient in `q`
+// and returning the remainder. `q` may be the same as `u`
+WordType divremWord(size_t n, const WordType* u, WordType d, WordType* q) {
+    return divremWordFlip(n, u, 0, d, n, q);
+}
+
+// schoolbook division (Knuth's algorithm D) of the un-word `u` by the
+// normalized n-word `v`, where un >= n >= 2. Stores the low un - n words of
+// the quotient in `q` and returns the top one, which is 0 or 1. Leaves the
+// remainder in u[0..n)
+static WordType divremSchoolbook(size_t un, WordType* u, size_t n, const WordType* v, WordType* q) {
+    WordType v1 = v[n - 1];
+    WordType v0 = v[n - 2];
+    WordType qh = cmpBuffers(n, u + un - n, n, v, 0) >= 0;
+    if(qh) {
+        subRows(n, u + un - n, v, u + un - n);
+    }
+    for(size_t j = un - n; j > 0; j--) {
+        // divide the n + 1 words at w by v
+        WordType* w = u + j - 1;
+        WordType u2 = w[n];
+        WordType u1 = w[n - 1];
+        WordType u0 = w[n - 2];
+        // estimate the quotient digit from the top two words of w and the
+        // top word of v, then refine it with the second word of v. The
+        // estimate is then at most one too big
+        WordType qhat;
+        WordType rhat;
+        int overflow;
+        if(u2 >= v1) {
+            qhat = (WordType)~(WordType)0;
+            rhat = u1 + v1;
+            overflow = rhat < v1;
+        } else {
+            qhat = divWide(u2, u1, v1, &rhat);
+            overflow = 0;
+        }
+        while(!overflow) {
+            WordType lo = 0;
+            WordType hi = mulAndCarry(qhat, v0, &lo);
+            if(hi < rhat || (hi == rhat && lo <= u0)) {
                 break;
             }
-            // no, reset and try the next power of two
-            assert(shfWords != 0 || shfAmt != 0);
-            lshiftBuffers(rlen - shfWords, rbuf + shfWords, shfAmt, rlen - shfWords, rbuf + shfWords);
-            rbuf[shfWords] |= holder;
-            shf = shfWords * YABI_WORD_BIT_SIZE + shfAmt - 1;
-        }
-        // calculate (2^shf * (r / 2^shf - d))
-        // rbuf[shfWords:] has already been divided out
-        addBuffers(rlen - shfWords, rbuf + shfWords, blen, bbuf, 1, rlen - shfWords, rbuf + shfWords);
-        lshiftBuffers(rlen - shfWords, rbuf + shfWords, shfAmt, rlen - shfWords, rbuf + shfWords);
-        rbuf[shfWords] |= holder;
-        q += (WordType)1 << shf;
-        shf--;
+            qhat--;
+            rhat += v1;
+            overflow = rhat < v1;
+        }
+        // w -= qhat * v, adding v back if that went below zero
+        WordType borrow = subMulRow(n, v, qhat, w);
+        if(u2 < borrow) {
+            qhat--;
+            addRows(n, w, v, w);
+        }
+        w[n] = 0;
+        q[j - 1] = qhat;
     }
-    return q;
+    return qh;
+}
+
+// divides the 2n-word `u` by the normalized n-word `v`. Each half of the
+// quotient comes from a recursive division by the top half of `v`, and is
+// then corrected with one multiplication by the bottom half. Same contract
+// as divremSchoolbook. `scratch` holds n + mulScratchLen(n) words
+static WordType divremHalves(WordType* u, size_t n, const WordType* v, WordType* q, WordType* scratch) {
+    if(n < YABI_DC_DIV_THRESHOLD) {
+        return divremSchoolbook(2 * n, u, n, v, q);
+    }
+    size_t lo = n / 2;
+    size_t hi = n - lo;
+    WordType* t = scratch;
+    WordType borrow;
+    // high half of the quotient
+    WordType qh = divremHalves(u + 2 * lo, hi, v + lo, q + lo, scratch);
+    mulUnsigned(hi, q + lo, lo, v, t, scratch + n);
+    borrow = subRows(n, u + lo, t, u + lo);
+    if(qh) {
+        borrow += subRows(lo, u + n, v, u + n);
+    }
+    while(borrow) {
+        qh -= subWordRow(hi, q + lo, 1, q + lo);
+        borrow -= addRows(n, u + lo, v, u + lo);
+    }
+    // low half of the quotient
+    WordType ql = divremHalves(u + hi, lo, v + hi, q, scratch);
+    mulUnsigned(hi, v, lo, q, t, scratch + n);
+    borrow = subRows(n, u, t, u);
+    if(ql) {
+        borrow += subRows(hi, u + lo, v, u + lo);
+    }
+    while(borrow) {
+        subWordRow(lo, q, 1, q);
+        borrow -= addRows(n, u, v, u);
+    }
+    return qh;
+}
+
+// divides the (n + qn)-word `u` by the normalized n-word `v`, where
+// qn <= n. The quotient comes from dividing the top 2qn words by the top qn
+// words of `v`, corrected with one multiplication by the rest of `v`
+static WordType divremBlock(size_t qn, WordType* u, size_t n, const WordType* v, WordType* q, WordType* scratch) {
+    if(qn < YABI_DC_DIV_THRESHOLD) {
+        return divremSchoolbook(n + qn, u, n, v, q);
+    }
+    WordType qh = divremHalves(u + n - qn, qn, v + n - qn, q, scratch);
+    if(qn != n) {
+        WordType* t = scratch;
+        mulUnsigned(qn, q, n - qn, v, t, scratch + n);
+        WordType borrow = subRows(n, u, t, u);
+        if(qh) {
+            borrow += subRows(n - qn, u + qn, v, u + qn);
+        }
+        while(borrow) {
+            qh -= subWordRow(qn, q, 1, q);
+            borrow -= addRows(n, u, v, u);
+        }
+    }
+    return qh;
+}
+
+size_t divremScratchLen(size_t un, size_t n) {
+    if(n < YABI_DC_DIV_THRESHOLD || un - n < YABI_DC_DIV_THRESHOLD) {
+        return 0;
+    }
+    return n + mulScratchLen(n);
+}
+
+// divides the un-word `u` by the normalized n-word `v`, where un >= n >= 2.
+// Stores the low un - n words of the quotient in `q` and returns the top
+// one, which is 0 or 1. Leaves the remainder in u[0..n). `scratch` holds
+// divremScratchLen(un, n) words. Large divisions are done a block of n
+// quotient words at a time, each of them by recursive division.
+WordType divremNormalized(size_t un, WordType* u, size_t n, const WordType* v, WordType* q, WordType* scratch) {
+    size_t qn = un - n;
+    if(n < YABI_DC_DIV_THRESHOLD || qn < YABI_DC_DIV_THRESHOLD) {
+        return divremSchoolbook(un, u, n, v, q);
+    }
+    // the top block takes whatever is left over from blocks of n words
+    size_t off = qn - ((qn - 1) % n + 1);
+    WordType qh = divremBlock(qn - off, u + off, n, v, q + off, scratch);
+    while(off > 0) {
+        // the top n words of each block are a remainder, and smaller than v
+        off -= n;
+        divremHalves(u + off, n, v, q + off, scratch);
+    }
+    return qh;
+}
+
+// index of the lowest nonzero word of the n words at x, or n if they are
+// all zero
+static size_t lowestNonzero(size_t n, const WordType* x) {
+    size_t i = 0;
+    while(i < n && x[i] == 0) {
+        i++;
+    }
+    return i;
+}
+
+// word i of the magnitude of x, where `low` is the lowest nonzero word of
+// a negative x. Its words below `low` stay zero, the word at `low` is
+// negated and the ones above complemented, so that the magnitude never
+// needs to be stored
+static inline WordType magnitudeWord(const WordType* x, size_t i, int negative, size_t low) {
+    if(!negative) {
+        return x[i];
+    }
+    return i < low ? 0 : i == low ? (WordType)-x[i] : (WordType)~x[i];
+}
+
+static size_t divScratchLen(size_t alen, size_t blen) {
+    size_t ulen = alen + 1;
+    // the dividend, the divisor, the quotient and scratch for dividing,
+    // whatever their lengths turn out to be once trimmed
+    return ulen + blen + ulen + (blen < YABI_DC_DIV_THRESHOLD ? 0 : blen + mulScratchLen(blen));
 }
 
 /**
- * Divides two unsigned BigInts. b != 0.
+ * Divides the magnitudes of two signed buffers. b needs at least two words,
+ * smaller ones go through divWordSigned. `qbuffer` and `rbuffer` are filled
+ * to their full length, truncating or zero extending the results. Negative
+ * operands are read as their magnitudes on the fly while they are
+ * normalized, so neither needs a negated copy.
  */
-static ydiv_t divUnsigned(const BigInt* a, const BigInt* b, size_t qlen, WordType* qbuffer, size_t rlen, WordType* rbuffer) {
-    // long division
-    memset(qbuffer, 0, qlen * sizeof(WordType));
-    memset(rbuffer, 0, rlen * sizeof(WordType));
-    for(size_t i = a->data[a->len - 1] ? a->len : a->len - 1; i > 0; i--) {
-        // shift r up by 1 word
-        memmove(rbuffer + 1, rbuffer, (rlen - 1) * sizeof(WordType));
-        // set LSW to current word of a
-        rbuffer[0] = a->data[i - 1];
-        // set next digit of q to r / d and subtract qd from r
-        // if r < d, sets the current word of q to 0 and leaves r unchanged
-        WordType w = simpleDiv(rlen, rbuffer, b->len, b->data);
-        if(i <= qlen) {
-            qbuffer[i - 1] = w;
-        }
-    }
-    ydiv_t res;
-    // find quotient and remainder length
-    res.qlen = qlen;
-    res.rlen = rlen;
-    while(res.qlen > 1 && qbuffer[res.qlen - 1] == 0) {
-        res.qlen--;
+static void divMagnitudes(
+        size_t alen, const WordType* adata, int anegative,
+        size_t blen, const WordType* bdata, int bnegative,
+        size_t qlen, WordType* qbuffer,
+        size_t rlen, WordType* rbuffer, yabi_workspace_t* ws) {
+    size_t alow = anegative ? lowestNonzero(alen, adata) : 0;
+    size_t blow = bnegative ? lowestNonzero(blen, bdata) : 0;
+    while(alen > 1 && magnitudeWord(adata, alen - 1, anegative, alow) == 0) {
+        alen--;
     }
-    while(res.rlen > 1 && rbuffer[res.rlen - 1] == 0) {
-        res.rlen--;
+    while(blen > 1 && magnitudeWord(bdata, blen - 1, bnegative, blow) == 0) {
+        blen--;
+    }
+    if(alen < blen) {
+        // |a| < |b|, so q = 0 and r = |a|
+        size_t n = min(alen, rlen);
+        for(size_t i = 0; i < n; i++) {
+            rbuffer[i] = magnitudeWord(adata, i, anegative, alow);
+        }
+        memset(rbuffer + n, 0, (rlen - n) * sizeof(WordType));
+        memset(qbuffer, 0, qlen * sizeof(WordType));
+    } else {
+        // normalize the divisor so its top bit is set, and shift the
+        // numerator up by the same amount. This keeps the quotient the same
+        // and scales the remainder, which is shifted back afterwards.
+        // Work in the caller's buffers when they are large enough
+        int s = leadingZeros(magnitudeWord(bdata, blen - 1, bnegative, blow));
+        size_t ulen = alen + 1;
+        size_t quolen = alen + 1 - blen;
+        int uInPlace = rlen >= ulen && rbuffer != bdata;
+        int qInPlace = qlen >= quolen && qbuffer != adata && qbuffer != bdata;
+        int vInPlace = s == 0 && !bnegative && qbuffer != bdata;
+        size_t divLen = divremScratchLen(ulen, blen);
+        size_t scratchLen = (uInPlace ? 0 : ulen) + (vInPlace ? 0 : blen) + (qInPlace ? 0 : quolen) + divLen;
+        WordType* scratch = takeScratch(ws, scratchLen);
+        WordType* next = scratch;
+        WordType* u = uInPlace ? rbuffer : next;
+        next += uInPlace ? 0 : ulen;
+        WordType* v = vInPlace ? (WordType*)bdata : next;
+        next += vInPlace ? 0 : blen;
+        WordType* q = qInPlace ? qbuffer : next;
+        next += qInPlace ? 0 : quolen;
+        // each magnitude word only depends on the word it replaces, so
+        // `u` may be `adata`
+        if(!vInPlace) {
+            for(size_t i = 0; i < blen; i++) {
+                v[i] = magnitudeWord(bdata, i, bnegative, blow);
+            }
+            shiftLeftRow(blen, v, s, v);
+        }
+        for(size_t i = 0; i < alen; i++) {
+            u[i] = magnitudeWord(adata, i, anegative, alow);
+        }
+        u[alen] = shiftLeftRow(alen, u, s, u);
+        WordType qh = divremNormalized(ulen, u, blen, v, q, next);
+        assert(qh == 0);
+        (void)qh;
+        // unnormalize the remainder
+        if(uInPlace) {
+            shiftRightRow(blen, u, s, rbuffer);
+            memset(rbuffer + blen, 0, (rlen - blen) * sizeof(WordType));
+        } else {
+            shiftRightRow(blen, u, s, u);
+            memcpy(rbuffer, u, min(blen, rlen) * sizeof(WordType));
+            if(rlen > blen) {
+                memset(rbuffer + blen, 0, (rlen - blen) * sizeof(WordType));
+            }
+        }
+        if(!qInPlace) {
+            memcpy(qbuffer, q, min(qlen, quolen) * sizeof(WordType));
+        }
+        if(qlen > quolen) {
+            memset(qbuffer + quolen, 0, (qlen - quolen) * sizeof(WordType));
+        }
+        dropScratch(ws, scratch);
     }
-    return res;
 }
 
 static void negateInPlace(size_t len, WordType* buf) {
@@ -93,65 +301,28 @@ static void negateInPlace(size_t len, WordType* buf) {
     }
 }
 
-ydiv_t yabi_divToBuf(const BigInt* a, const BigInt* b, size_t qlen, WordType* qbuffer, size_t rlen, WordType* rbuffer) {
-    // cannot divide by zero
-    if(b->len == 1 && b->data[0] == 0) {
-        return (ydiv_t) {
-            .qlen = 0,
-            .rlen = 0
-        };
-    }
-    const BigInt* num;
-    const BigInt* denom;
-    size_t rrlen;
-    WordType* rbuf;
-    int qnegative = 0;
-    int rnegative = 0;
-    // change negative numbers to positive
-    if(HI_BIT(a->data[a->len - 1])) {
-        num = yabi_negate(a);
-        qnegative ^= 1;
-        rnegative = 1;
-    } else {
-        num = a;
-    }
-    if(HI_BIT(b->data[b->len - 1])) {
-        denom = yabi_negate(b);
-        qnegative ^= 1;
-    } else {
-        denom = b;
+// negates the unsigned quotient and remainder as needed, and finds their
+// lengths
+static ydiv_t applySigns(
+        int qnegative, size_t qlen, WordType* qbuffer,
+        int rnegative, size_t rlen, WordType* rbuffer) {
+    ydiv_t result;
+    // find quotient and remainder length
+    result.qlen = qlen;
+    result.rlen = rlen;
+    while(result.qlen > 1 && qbuffer[result.qlen - 1] == 0) {
+        result.qlen--;
     }
-    // make sure the remainder can hold partial results
-    // (rlen > b->len)
-    if(rlen <= b->len) {
-        rrlen = b->len + 1;
-        rbuf = YABI_MALLOC(rrlen * sizeof(WordType));
-    } else {
-        rrlen = rlen;
-        rbuf = rbuffer;
+    while(result.rlen > 1 && rbuffer[result.rlen - 1] == 0) {
+        result.rlen--;
     }
-    // quotient does not have to be expanded in long division
-    // ;
-    // do unsigned division
-    ydiv_t result = divUnsigned(num, denom, qlen, qbuffer, rrlen, rbuf);
     // negate the quotient if either operand was negative
     if(qnegative) {
         negateInPlace(qlen, qbuffer);
     }
     // negate the remainder if the numerator was negative
     if(rnegative) {
-        negateInPlace(rrlen, rbuf);
-    }
-    // copy and free dynamic storage
-    if(num != a) {
-        YABI_FREE((void*)num);
-    }
-    if(denom != b) {
-        YABI_FREE((void*)denom);
-    }
-    if(rbuf != rbuffer) {
-        memcpy(rbuffer, rbuf, rlen * sizeof(WordType));
-        YABI_FREE(rbuf);
+        negateInPlace(rlen, rbuffer);
     }
     // fix overflow
     if(result.qlen < qlen && HI_BIT(qbuffer[result.qlen - 1]) != qnegative) {
@@ -166,27 +337,392 @@ ydiv_t yabi_divToBuf(const BigInt* a, const BigInt* b, size_t qlen, WordType* qb
             result.rlen++;
         }
     }
-    // return
     return result;
 }
 
+// if the magnitude of b fits in a word, stores it in d and returns 1
+static int wordMagnitude(const BigInt* b, WordType* d) {
+    WordType sign = (WordType)-HI_BIT(b->data[b->len - 1]);
+    for(size_t i = 1; i < b->len; i++) {
+        if(b->data[i] != sign) {
+            return 0;
+        }
+    }
+    if(!sign) {
+        *d = b->data[0];
+        return 1;
+    }
+    // b = b->data[0] - B, unless the low word is 0 as well
+    *d = (WordType)-b->data[0];
+    return b->data[0] != 0;
+}
+
+// truncating division by a word divisor d != 0 in one pass. A negative
+// numerator is read as its complement |a| - 1, so neither operand needs a
+// negated copy
+static ydiv_t divWordSigned(
+        const BigInt* a, WordType d, int dnegative,
+        size_t qlen, WordType* qbuffer,
+        size_t rlen, WordType* rbuffer) {
+    size_t alen = a->len;
+    int anegative = HI_BIT(a->data[alen - 1]);
+    WordType r = divremWordFlip(alen, a->data, (WordType)-anegative, d, qlen, qbuffer);
+    if(qlen > alen) {
+        memset(qbuffer + alen, 0, (qlen - alen) * sizeof(WordType));
+    }
+    if(anegative) {
+        // a = -(c + 1) for the c that was divided, so the remainder goes up
+        // by one, and the quotient too if that reaches the divisor
+        r++;
+        if(r == d) {
+            r = 0;
+            addWordRow(qlen, qbuffer, 1, qbuffer);
+        }
+    }
+    rbuffer[0] = r;
+    memset(rbuffer + 1, 0, (rlen - 1) * sizeof(WordType));
+    return applySigns(anegative ^ dnegative, qlen, qbuffer, anegative, rlen, rbuffer);
+}
+
+size_t yabi_div_scratch(size_t alen, size_t blen) {
+    return divScratchLen(alen, blen);
+}
+
+ydiv_t yabi_divToBufWs(const BigInt* a, const BigInt* b, size_t qlen, WordType* qbuffer, size_t rlen, WordType* rbuffer, yabi_workspace_t* ws) {
+    WordType d;
+    if(wordMagnitude(b, &d)) {
+        // cannot divide by zero
+        if(d == 0) {
+            return (ydiv_t) {
+                .qlen = 0,
+                .rlen = 0
+            };
+        }
+        return divWordSigned(a, d, HI_BIT(b->data[b->len - 1]), qlen, qbuffer, rlen, rbuffer);
+    }
+    int anegative = HI_BIT(a->data[a->len - 1]);
+    int bnegative = HI_BIT(b->data[b->len - 1]);
+    divMagnitudes(a->len, a->data, anegative, b->len, b->data, bnegative, qlen, qbuffer, rlen, rbuffer, ws);
+    // the quotient is negative when the signs differ, and the remainder
+    // takes the sign of the numerator
+    return applySigns(anegative ^ bnegative, qlen, qbuffer, anegative, rlen, rbuffer);
+}
+
+ydiv_t yabi_divToBuf(const BigInt* a, const BigInt* b, size_t qlen, WordType* qbuffer, size_t rlen, WordType* rbuffer) {
+    return yabi_divToBufWs(a, b, qlen, qbuffer, rlen, rbuffer, NULL);
+}
+
 ydiv_t yabi_div(const BigInt* a, const BigInt* b) {
     size_t qlen = a->len + 1;
     size_t rlen = b->len + 1;
     BigInt* q = YABI_NEW_BIGINT(qlen);
     q->refCount = 0;
     q->len = qlen;
+    q->cap = q->len;
     BigInt* r = YABI_NEW_BIGINT(rlen);
     r->refCount = 0;
     r->len = rlen;
+    r->cap = r->len;
     ydiv_t res = yabi_divToBuf(a, b, qlen, q->data, rlen, r->data);
     if(res.qlen != qlen) {
-        YABI_RESIZE_BIGINT(q, res.qlen);
+        RESIZE_BIGINT(q, res.qlen);
     }
     if(res.rlen != rlen) {
-        YABI_RESIZE_BIGINT(r, res.rlen);
+        RESIZE_BIGINT(r, res.rlen);
     }
     res.quo = q;
     res.rem = r;
     return res;
 }
+
+/*
+ * Division by a prepared divisor. Its magnitude is normalized once, along
+ * with the reciprocal of its top word. The numerator is read a window at a
+ * time, shifted and made unsigned on the fly, so dividing needs no more
+ * than the fixed scratch space the divisor owns.
+ */
+
+// quotient words found per window. Short divisors use longer windows so
+// that the work per window stays large
+#define DIVISOR_MIN_BLOCK 32
+
+static size_t divisorBlock(size_t n) {
+    return max(n, DIVISOR_MIN_BLOCK);
+}
+
+// a window of the numerator, its quotient, and scratch for dividing it
+static size_t divisorScratchLen(size_t n) {
+    size_t k = divisorBlock(n);
+    return n + 2 * k + divremScratchLen(n + k, n);
+}
+
+yabi_divisor_t* yabi_divisor_init(const BigInt* d) {
+    size_t len = d->len;
+    int negative = HI_BIT(d->data[len - 1]);
+    size_t top = len;
+    while(top > 1 && d->data[top - 1] == 0) {
+        top--;
+    }
+    if(top == 1 && d->data[0] == 0) {
+        return NULL;
+    }
+    yabi_divisor_t* res = YABI_MALLOC(sizeof(yabi_divisor_t) + (2 * len + divisorScratchLen(len)) * sizeof(WordType));
+    WordType* mag = (WordType*)(res + 1);
+    memcpy(mag, d->data, len * sizeof(WordType));
+    if(negative) {
+        negateInPlace(len, mag);
+    }
+    while(len > 1 && mag[len - 1] == 0) {
+        len--;
+    }
+    res->n = len;
+    res->negative = negative;
+    res->mag = mag;
+    res->norm = mag + len;
+    res->scratch = mag + 2 * len;
+    res->shift = leadingZeros(mag[len - 1]);
+    shiftLeftRow(len, mag, res->shift, res->norm);
+    res->inv = wordInverse(res->norm[len - 1]);
+    return res;
+}
+
+void yabi_divisor_free(yabi_divisor_t* d) {
+    YABI_FREE(d);
+}
+
+// word i of the numerator shifted up by s. A negative numerator is read as
+// its complement |a| - 1
+static inline WordType numeratorWord(size_t alen, const WordType* a, WordType flip, int s, size_t i) {
+    WordType w = i < alen ? a[i] ^ flip : 0;
+    if(s == 0) {
+        return w;
+    }
+    w <<= s;
+    if(i > 0 && i - 1 < alen) {
+        w |= (WordType)(a[i - 1] ^ flip) >> (YABI_WORD_BIT_SIZE - s);
+    }
+    return w;
+}
+
+static void loadNumerator(size_t alen, const WordType* a, WordType flip, int s, size_t from, size_t n, WordType* buffer) {
+    for(size_t i = 0; i < n; i++) {
+        buffer[i] = numeratorWord(alen, a, flip, s, from + i);
+    }
+}
+
+// unsigned division of the magnitude of a (less one, if it is negative) by
+// d. Only quotient words below qlen are stored, and the unnormalized
+// remainder is left in d->scratch[0..n). Returns the quotient length
+static size_t divPreUnsigned(
+        size_t alen, const WordType* a, WordType flip,
+        yabi_divisor_t* d, size_t qlen, WordType* qbuffer) {
+    size_t n = d->n;
+    int s = d->shift;
+    const WordType* v = d->norm;
+    WordType* u = d->scratch;
+    size_t un = alen + (numeratorWord(alen, a, flip, s, alen) != 0);
+    if(un < n) {
+        loadNumerator(alen, a, flip, s, 0, un, u);
+        memset(u + un, 0, (n - un) * sizeof(WordType));
+        shiftRightRow(n, u, s, u);
+        return 0;
+    }
+    if(n == 1) {
+        // one word at a time, dividing by multiplying with the reciprocal
+        WordType r = 0;
+        for(size_t i = un; i > 0; i--) {
+            WordType q = divWidePre(r, numeratorWord(alen, a, flip, s, i - 1), v[0], d->inv, &r);
+            if(i - 1 < qlen) {
+                qbuffer[i - 1] = q;
+            }
+        }
+        u[0] = r >> s;
+        return un;
+    }
+    // the first window takes whatever is left over from full windows, the
+    // way divremNormalized splits a long division into blocks
+    size_t k = divisorBlock(n);
+    size_t qn = un - n;
+    size_t off = qn - (qn ? (qn - 1) % k + 1 : 0);
+    WordType* q = u + n + k;
+    WordType* next = q + k;
+    loadNumerator(alen, a, flip, s, off, un - off, u);
+    WordType qh = divremNormalized(un - off, u, n, v, q, next);
+    for(size_t i = off; i < qn + 1 && i < qlen; i++) {
+        qbuffer[i] = i < qn ? q[i - off] : qh;
+    }
+    while(off > 0) {
+        // the remainder so far goes above the next k words, so the quotient
+        // of each window fits in k words
+        off -= k;
+        memmove(u + k, u, n * sizeof(WordType));
+        loadNumerator(alen, a, flip, s, off, k, u);
+        divremNormalized(n + k, u, n, v, q, next);
+        for(size_t i = off; i < off + k && i < qlen; i++) {
+            qbuffer[i] = q[i - off];
+        }
+    }
+    shiftRightRow(n, u, s, u);
+    return qn + 1;
+}
+
+ydiv_t yabi_divPreToBuf(const BigInt* a, yabi_divisor_t* d, size_t qlen, WordType* qbuffer, size_t rlen, WordType* rbuffer) {
+    size_t n = d->n;
+    size_t alen = a->len;
+    int anegative = HI_BIT(a->data[alen - 1]);
+    WordType flip = (WordType)-anegative;
+    // ignore redundant sign words
+    while(alen > 1 && a->data[alen - 1] == flip && HI_BIT(a->data[alen - 2]) == (WordType)anegative) {
+        alen--;
+    }
+    size_t quolen = divPreUnsigned(alen, a->data, flip, d, qlen, qbuffer);
+    if(quolen < qlen) {
+        memset(qbuffer + quolen, 0, (qlen - quolen) * sizeof(WordType));
+    }
+    WordType* r = d->scratch;
+    if(anegative) {
+        // a = -(c + 1) for the c that was divided, so the remainder goes up
+        // by one, and the quotient too if that reaches the divisor
+        addWordRow(n, r, 1, r);
+        if(eqBuffers(n, r, n, d->mag)) {
+            memset(r, 0, n * sizeof(WordType));
+            addWordRow(qlen, qbuffer, 1, qbuffer);
+        }
+    }
+    size_t stop = min(n, rlen);
+    memcpy(rbuffer, r, stop * sizeof(WordType));
+    memset(rbuffer + stop, 0, (rlen - stop) * sizeof(WordType));
+    return applySigns(qlen && (anegative ^ d->negative), qlen, qbuffer, anegative, rlen, rbuffer);
+}
+
+ydiv_t yabi_divPre(const BigInt* a, yabi_divisor_t* d) {
+    size_t qlen = a->len + 1;
+    size_t rlen = d->n + 1;
+    BigInt* q = YABI_NEW_BIGINT(qlen);
+    q->refCount = 0;
+    q->len = qlen;
+    q->cap = q->len;
+    BigInt* r = YABI_NEW_BIGINT(rlen);
+    r->refCount = 0;
+    r->len = rlen;
+    r->cap = r->len;
+    ydiv_t res = yabi_divPreToBuf(a, d, qlen, q->data, rlen, r->data);
+    if(res.qlen != qlen) {
+        RESIZE_BIGINT(q, res.qlen);
+    }
+    if(res.rlen != rlen) {
+        RESIZE_BIGINT(r, res.rlen);
+    }
+    res.quo = q;
+    res.rem = r;
+    return res;
+}
+
+size_t yabi_modPreToBuf(const BigInt* a, yabi_divisor_t* d, size_t len, WordType* buffer) {
+    return yabi_divPreToBuf(a, d, 0, NULL, len, buffer).rlen;
+}
+
+BigInt* yabi_modPre(const BigInt* a, yabi_divisor_t* d) {
+    size_t len = d->n + 1;
+    BigInt* r = YABI_NEW_BIGINT(len);
+    r->refCount = 0;
+    r->len = len;
+    r->cap = r->len;
+    size_t newLen = yabi_modPreToBuf(a, d, len, r->data);
+    if(newLen != len) {
+        RESIZE_BIGINT(r, newLen);
+    }
+    return r;
+}
+
+/*
+ * Division by an unsigned native integer. These round toward negative
+ * infinity, so that the remainder is never negative and always fits in 64
+ * bits. When d fits in a word, a negative numerator is divided as its
+ * complement c = -a - 1, since then floor(a / d) = ~floor(c / d) and
+ * a mod d = d - 1 - c mod d.
+ */
+
+// one pass by the reciprocal of the word d
+static uint64_t divmodWord(const BigInt* a, WordType d, size_t len, WordType* buffer) {
+    size_t alen = a->len;
+    WordType flip = (WordType)-HI_BIT(a->data[alen - 1]);
+    WordType r = divremWordFlip(alen, a->data, flip, d, len, buffer);
+    size_t stop = min(alen, len);
+    if(flip) {
+        for(size_t i = 0; i < stop; i++) {
+            buffer[i] = ~buffer[i];
+        }
+        r = d - 1 - r;
+    }
+    memset(buffer + stop, flip, (len - stop) * sizeof(WordType));
+    return r;
+}
+
+// d is wider than a word, which only happens for words below 64 bits. It is
+// split into NATIVE_WORDS words for the general division, which truncates,
+// and the results are moved down to the floor afterwards
+static uint64_t divmodNative(const BigInt* a, uint64_t d, size_t len, WordType* buffer) {
+    WordType v[NATIVE_WORDS];
+    WordType r[NATIVE_WORDS];
+    nativeWords(d, v);
+    size_t alen = a->len;
+    int anegative = HI_BIT(a->data[alen - 1]);
+    divMagnitudes(alen, a->data, anegative, NATIVE_WORDS, v, 0, len, buffer, NATIVE_WORDS, r, NULL);
+    uint64_t rem = 0;
+    for(size_t i = NATIVE_WORDS; i > 0; i--) {
+        rem = (rem << (YABI_WORD_BIT_SIZE - 1)) << 1 | r[i - 1];
+    }
+    if(anegative && rem) {
+        rem = d - rem;
+        addWordRow(len, buffer, 1, buffer);
+    }
+    if(anegative && len) {
+        negateInPlace(len, buffer);
+    }
+    return rem;
+}
+
+size_t yabi_divmod_uiToBuf(const BigInt* a, uint64_t d, uint64_t* rem, size_t len, WordType* buffer) {
+    if(d == 0) {
+        return 0;
+    }
+    uint64_t r = d == (WordType)d ? divmodWord(a, (WordType)d, len, buffer) : divmodNative(a, d, len, buffer);
+    if(rem) {
+        *rem = r;
+    }
+    if(len == 0) {
+        return 0;
+    }
+    return trimBuffer(len, buffer);
+}
+
+BigInt* yabi_divmod_ui(const BigInt* a, uint64_t d, uint64_t* rem) {
+    if(d == 0) {
+        return NULL;
+    }
+    size_t len = a->len;
+    BigInt* q = YABI_NEW_BIGINT(len);
+    q->refCount = 0;
+    q->len = len;
+    q->cap = q->len;
+    size_t newLen = yabi_divmod_uiToBuf(a, d, rem, len, q->data);
+    if(newLen != len) {
+        RESIZE_BIGINT(q, newLen);
+    }
+    return q;
+}
+
+uint64_t yabi_mod_ui(const BigInt* a, uint64_t d) {
+    if(d == 0) {
+        return 0;
+    }
+    if(d != (WordType)d) {
+        // no quotient words are kept, but the buffer must not be NULL
+        WordType q;
+        return divmodNative(a, d, 0, &q);
+    }
+    WordType flip = (WordType)-HI_BIT(a->data[a->len - 1]);
+    WordType r = divremWordFlip(a->len, a->data, flip, (WordType)d, 0, NULL);
+    return flip ? (WordType)d - 1 - r : r;
+}
@@ -0,0 +1,541 @@
+#include "bigint_internal.h"
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+
+/*
+ * Greatest common divisors of the magnitudes of two numbers, by Lehmer's
+ * algorithm: the quotients of the Euclidean algorithm are simulated on the
+ * leading 64 bits of each remainder for as long as Collins' condition
+ * guarantees that they are the true ones, and the 64-bit matrix they add
+ * up to is then applied to the full remainders at once. Once both fit in
+ * 64 bits, Stein's binary algorithm, which only shifts and subtracts,
+ * finishes natively. Everything happens in rows of scratch space.
+ *
+ * The extended algorithm also keeps the cofactors of one operand. Those of
+ * the Euclidean algorithm alternate in sign, so only their magnitudes are
+ * kept, which add up in every step, and the sign follows from the number
+ * of steps taken.
+ */
+
+typedef struct gcdState {
+    // the current remainders, a >= b, in rows of n + NATIVE_WORDS + 1 words
+    WordType* a;
+    WordType* b;
+    size_t alen;
+    size_t blen;
+    // spare rows
+    WordType* s;
+    WordType* t;
+    // the quotient of a division step
+    WordType* q;
+    // scratch for dividing and multiplying
+    WordType* scratch;
+    // magnitudes of the cofactors that go with a and b, both ulen words,
+    // and two spare rows, all of 2n + NATIVE_WORDS + 2 words. NULL if not
+    // needed
+    WordType* ua;
+    WordType* ub;
+    WordType* us;
+    WordType* ut;
+    size_t ulen;
+    // whether the cofactor that goes with a is negative
+    int odd;
+} gcdState;
+
+static size_t gcdRowLen(size_t n) {
+    return n + NATIVE_WORDS + 1;
+}
+
+static size_t cofactorRowLen(size_t n) {
+    return 2 * n + NATIVE_WORDS + 2;
+}
+
+static size_t gcdScratchLen(size_t n, int cofactors) {
+    size_t len = 5 * gcdRowLen(n) + n + mulScratchLen(n + 1);
+    return len + (cofactors ? 4 * cofactorRowLen(n) : 0);
+}
+
+static size_t trimZeros(size_t n, const WordType* x) {
+    n = spanRow(n, x, 0);
+    return n ? n : 1;
+}
+
+static int isZeroRow(size_t n, const WordType* x) {
+    return n == 1 && x[0] == 0;
+}
+
+// lays out the rows for the magnitudes of x and y in `scratch`, larger
+// first. With cofactors, the ones that go with x are kept
+static void gcdInit(gcdState* g, const BigInt* x, const BigInt* y, int cofactors, WordType* scratch) {
+    size_t n = max(x->len, y->len);
+    size_t rowLen = gcdRowLen(n);
+    WordType* next = scratch;
+    g->a = next;
+    g->b = next + rowLen;
+    g->s = next + 2 * rowLen;
+    g->t = next + 3 * rowLen;
+    g->q = next + 4 * rowLen;
+    next += 5 * rowLen;
+    loadMagnitude(x, x->len, g->a);
+    loadMagnitude(y, y->len, g->b);
+    g->alen = trimZeros(x->len, g->a);
+    g->blen = trimZeros(y->len, g->b);
+    int swapped = cmpBuffers(g->alen, g->a, g->blen, g->b, 0) < 0;
+    if(swapped) {
+        WordType* tmp = g->a;
+        g->a = g->b;
+        g->b = tmp;
+        size_t tmplen = g->alen;
+        g->alen = g->blen;
+        g->blen = tmplen;
+    }
+    if(cofactors) {
+        size_t cofactorLen = cofactorRowLen(n);
+        g->ua = next;
+        g->ub = next + cofactorLen;
+        g->us = next + 2 * cofactorLen;
+        g->ut = next + 3 * cofactorLen;
+        next += 4 * cofactorLen;
+        // the cofactors that go with x start out as 1 and 0 when x is a,
+        // and as 0 and 1 when it is b, where the one of a is then on the
+        // negative side of the alternation
+        g->ua[0] = !swapped;
+        g->ub[0] = swapped;
+        g->ulen = 1;
+        g->odd = swapped;
+    } else {
+        g->ua = NULL;
+    }
+    g->scratch = next;
+}
+
+static void trimCofactors(gcdState* g) {
+    while(g->ulen > 1 && g->ua[g->ulen - 1] == 0 && g->ub[g->ulen - 1] == 0) {
+        g->ulen--;
+    }
+}
+
+// one step of the Euclidean algorithm: a, b = b, a mod b
+static void euclidStep(gcdState* g) {
+    size_t alen = g->alen;
+    size_t blen = g->blen;
+    WordType* r = g->s;
+    size_t qlen;
+    if(blen == 1) {
+        r[0] = divremWord(alen, g->a, g->b[0], g->q);
+        qlen = alen;
+    } else {
+        // divide by the normalized b, as divMagnitudes does
+        int sh = leadingZeros(g->b[blen - 1]);
+        WordType* v = g->t;
+        shiftLeftRow(blen, g->b, sh, v);
+        r[alen] = shiftLeftRow(alen, g->a, sh, r);
+        WordType qh = divremNormalized(alen + 1, r, blen, v, g->q, g->scratch);
+        assert(qh == 0);
+        (void)qh;
+        shiftRightRow(blen, r, sh, r);
+        qlen = alen + 1 - blen;
+    }
+    g->s = g->a;
+    g->a = g->b;
+    g->alen = blen;
+    g->b = r;
+    g->blen = trimZeros(blen, r);
+    if(g->ua) {
+        // ua, ub = ub, ua + q * ub
+        qlen = trimZeros(qlen, g->q);
+        size_t n = qlen + g->ulen;
+        mulUnsigned(qlen, g->q, g->ulen, g->ub, g->us, g->scratch);
+        WordType carry = addRows(g->ulen, g->us, g->ua, g->us);
+        addWordRow(n - g->ulen, g->us + g->ulen, carry, g->us + g->ulen);
+        memset(g->ub + g->ulen, 0, (n - g->ulen) * sizeof(WordType));
+        WordType* tmp = g->ua;
+        g->ua = g->ub;
+        g->ub = g->us;
+        g->us = tmp;
+        g->ulen = n;
+        g->odd ^= 1;
+        trimCofactors(g);
+    }
+}
+
+// the 64 bits of the n-word x from bit `pos` up
+static uint64_t bitsAt(size_t n, const WordType* x, size_t pos) {
+    size_t w = pos / YABI_WORD_BIT_SIZE;
+    int sh = pos % YABI_WORD_BIT_SIZE;
+    uint64_t bits = 0;
+    for(int i = 0; i <= NATIVE_WORDS && w + i < n; i++) {
+        int at = i * YABI_WORD_BIT_SIZE - sh;
+        if(at < 0) {
+            bits |= (uint64_t)(x[w] >> sh);
+        } else if(at < 64) {
+            bits |= (uint64_t)x[w + i] << at;
+        }
+    }
+    return bits;
+}
+
+// the value of an n-word x that fits in 64 bits
+static uint64_t rowValue(size_t n, const WordType* x) {
+    return bitsAt(n, x, 0);
+}
+
+static void addCarry(WordType* x, WordType carry) {
+    for(; carry; x++) {
+        *x += carry;
+        carry = *x < carry;
+    }
+}
+
+static void subBorrow(WordType* x, WordType borrow) {
+    for(; borrow; x++) {
+        WordType w = *x;
+        *x = w - borrow;
+        borrow = w < borrow;
+    }
+}
+
+// out = p * x - q * y, which is known not to be negative. Returns its
+// trimmed length
+static size_t lehmerDiff(size_t xn, const WordType* x, uint64_t p, size_t yn, const WordType* y, uint64_t q, WordType* out) {
+    WordType pw[NATIVE_WORDS];
+    WordType qw[NATIVE_WORDS];
+    nativeWords(p, pw);
+    nativeWords(q, qw);
+    size_t n = max(xn, yn) + NATIVE_WORDS;
+    out[xn] = mulRow(xn, x, pw[0], out);
+    memset(out + xn + 1, 0, (n - xn - 1) * sizeof(WordType));
+    for(int j = 1; j < NATIVE_WORDS; j++) {
+        if(pw[j]) {
+            addCarry(out + j + xn, addMulRow(xn, x, pw[j], out + j));
+        }
+    }
+    for(int j = 0; j < NATIVE_WORDS; j++) {
+        if(qw[j]) {
+            subBorrow(out + j + yn, subMulRow(yn, y, qw[j], out + j));
+        }
+    }
+    return trimZeros(n, out);
+}
+
+// out = p * x + q * y for n-word x and y, in n + NATIVE_WORDS words
+static void lehmerSum(size_t n, const WordType* x, uint64_t p, const WordType* y, uint64_t q, WordType* out) {
+    WordType pw[NATIVE_WORDS];
+    WordType qw[NATIVE_WORDS];
+    nativeWords(p, pw);
+    nativeWords(q, qw);
+    out[n] = mulRow(n, x, pw[0], out);
+    memset(out + n + 1, 0, (NATIVE_WORDS - 1) * sizeof(WordType));
+    for(int j = 1; j < NATIVE_WORDS; j++) {
+        if(pw[j]) {
+            addCarry(out + j + n, addMulRow(n, x, pw[j], out + j));
+        }
+    }
+    for(int j = 0; j < NATIVE_WORDS; j++) {
+        if(qw[j]) {
+            addCarry(out + j + n, addMulRow(n, y, qw[j], out + j));
+        }
+    }
+}
+
+// simulates Euclidean steps on the leading 64 bits of a and b, and applies
+// them to the full rows. Returns 0 if not a single step could be simulated
+static int lehmerStep(gcdState* g) {
+    size_t alen = g->alen;
+    size_t blen = g->blen;
+    WordType* a = g->a;
+    WordType* b = g->b;
+    // b lines up with a, and may be shorter
+    size_t bits = alen * YABI_WORD_BIT_SIZE - leadingZeros(a[alen - 1]);
+    size_t pos = bits > 64 ? bits - 64 : 0;
+    uint64_t a1 = bitsAt(alen, a, pos);
+    uint64_t a2 = bitsAt(blen, b, pos);
+    // the cosequences. Rather than keeping their signs, `even` tracks
+    // which of them are negative: u0 and v1 are positive when it is set,
+    // and u1 and v0 otherwise. Collins' condition keeps every quotient
+    // that is found a true one, and the cosequences within 64 bits
+    uint64_t u0 = 0;
+    uint64_t u1 = 1;
+    uint64_t u2 = 0;
+    uint64_t v0 = 0;
+    uint64_t v1 = 0;
+    uint64_t v2 = 1;
+    int even = 0;
+    while(a2 >= v2 && a1 - a2 >= v1 + v2) {
+        // most quotients are small, and a divide is not
+        uint64_t q = 1;
+        uint64_t r = a1 - a2;
+        if(r >= a2) {
+            q = a1 / a2;
+            r = a1 % a2;
+        }
+        a1 = a2;
+        a2 = r;
+        uint64_t t = u1 + q * u2;
+        u0 = u1;
+        u1 = u2;
+        u2 = t;
+        t = v1 + q * v2;
+        v0 = v1;
+        v1 = v2;
+        v2 = t;
+        even = !even;
+    }
+    // the matrix in u0, u1, v0 and v1 stops one step short of the last
+    // quotient found, so it takes at least two to make any progress
+    if(v0 == 0) {
+        return 0;
+    }
+    // a, b = u0 * a + v0 * b, u1 * a + v1 * b
+    size_t newAlen;
+    size_t newBlen;
+    if(even) {
+        newAlen = lehmerDiff(alen, a, u0, blen, b, v0, g->s);
+        newBlen = lehmerDiff(blen, b, v1, alen, a, u1, g->t);
+    } else {
+        newAlen = lehmerDiff(blen, b, v0, alen, a, u0, g->s);
+        newBlen = lehmerDiff(alen, a, u1, blen, b, v1, g->t);
+    }
+    g->a = g->s;
+    g->b = g->t;
+    g->s = a;
+    g->t = b;
+    g->alen = newAlen;
+    g->blen = newBlen;
+    if(g->ua) {
+        // the cofactors have the opposite signs of the ones they are
+        // multiplied with, so their magnitudes add up
+        lehmerSum(g->ulen, g->ua, u0, g->ub, v0, g->us);
+        lehmerSum(g->ulen, g->ua, u1, g->ub, v1, g->ut);
+        WordType* tmp = g->ua;
+        g->ua = g->us;
+        g->us = tmp;
+        tmp = g->ub;
+        g->ub = g->ut;
+        g->ut = tmp;
+        g->ulen += NATIVE_WORDS;
+        // one step fewer than quotients found
+        g->odd ^= !even;
+        trimCofactors(g);
+    }
+    return 1;
+}
+
+// the gcd of two native integers, by Stein's algorithm
+static uint64_t gcdNative(uint64_t a, uint64_t b) {
+    if(a == 0 || b == 0) {
+        return a | b;
+    }
+    int k = trailingZeros(a | b);
+    a >>= trailingZeros(a);
+    do {
+        b >>= trailingZeros(b);
+        if(a > b) {
+            uint64_t t = a;
+            a = b;
+            b = t;
+        }
+        b -= a;
+    } while(b != 0);
+    return a << k;
+}
+
+static void lehmerGcd(gcdState* g) {
+    while(g->alen > NATIVE_WORDS) {
+        if(isZeroRow(g->blen, g->b)) {
+            return;
+        }
+        if(!lehmerStep(g)) {
+            euclidStep(g);
+        }
+    }
+    // both fit in 64 bits
+    uint64_t a = rowValue(g->alen, g->a);
+    uint64_t b = rowValue(g->blen, g->b);
+    if(!g->ua) {
+        nativeWords(gcdNative(a, b), g->a);
+        g->alen = trimZeros(NATIVE_WORDS, g->a);
+        return;
+    }
+    uint64_t u0 = 1;
+    uint64_t u1 = 0;
+    uint64_t v0 = 0;
+    uint64_t v1 = 1;
+    int odd = 0;
+    while(b != 0) {
+        uint64_t q = a / b;
+        uint64_t r = a % b;
+        a = b;
+        b = r;
+        uint64_t t = u0 + q * u1;
+        u0 = u1;
+        u1 = t;
+        t = v0 + q * v1;
+        v0 = v1;
+        v1 = t;
+        odd = !odd;
+    }
+    nativeWords(a, g->a);
+    g->alen = trimZeros(NATIVE_WORDS, g->a);
+    lehmerSum(g->ulen, g->ua, u0, g->ub, v0, g->us);
+    WordType* tmp = g->ua;
+    g->ua = g->us;
+    g->us = tmp;
+    // ub is not needed any more, but has to be as long for trimming
+    memset(g->ub + g->ulen, 0, NATIVE_WORDS * sizeof(WordType));
+    g->ulen += NATIVE_WORDS;
+    g->odd ^= odd;
+    trimCofactors(g);
+}
+
+size_t yabi_gcd_scratch(size_t alen, size_t blen) {
+    return gcdScratchLen(max(alen, blen), 0);
+}
+
+size_t yabi_gcdToBufWs(const BigInt* a, const BigInt* b, size_t len, WordType* buffer, yabi_workspace_t* ws) {
+    gcdState g;
+    WordType* scratch = takeScratch(ws, gcdScratchLen(max(a->len, b->len), 0));
+    gcdInit(&g, a, b, 0, scratch);
+    lehmerGcd(&g);
+    len = storeUnsigned(g.alen, g.a, len, buffer);
+    dropScratch(ws, scratch);
+    return len;
+}
+
+size_t yabi_gcdToBuf(const BigInt* a, const BigInt* b, size_t len, WordType* buffer) {
+    return yabi_gcdToBufWs(a, b, len, buffer, NULL);
+}
+
+BigInt* yabi_gcd(const BigInt* a, const BigInt* b) {
+    // the magnitude of either may need a word more than its length
+    size_t len = max(a->len, b->len) + 1;
+    BigInt* res = YABI_NEW_BIGINT(len);
+    res->refCount = 0;
+    res->len = len;
+    res->cap = res->len;
+    len = yabi_gcdToBuf(a, b, len, res->data);
+    if(len != res->len) {
+        RESIZE_BIGINT(res, len);
+    }
+    return res;
+}
+
+// a new BigInt of the unsigned n-word x, negated if `negative`
+static BigInt* fromMagnitude(size_t n, const WordType* x, int negative) {
+    size_t len = n + 1;
+    BigInt* res = YABI_NEW_BIGINT(len);
+    res->refCount = 0;
+    res->len = len;
+    res->cap = res->len;
+    memcpy(res->data, x, n * sizeof(WordType));
+    res->data[n] = 0;
+    if(negative) {
+        for(size_t i = 0; i < len; i++) {
+            res->data[i] = ~res->data[i];
+        }
+        addWordRow(len, res->data, 1, res->data);
+    }
+    len = trimBuffer(len, res->data);
+    if(len != res->len) {
+        RESIZE_BIGINT(res, len);
+    }
+    return res;
+}
+
+BigInt* yabi_gcdext(const BigInt* a, const BigInt* b, BigInt** s, BigInt** t) {
+    gcdState g;
+    WordType* scratch = YABI_MALLOC(gcdScratchLen(max(a->len, b->len), 1) * sizeof(WordType));
+    gcdInit(&g, a, b, 1, scratch);
+    lehmerGcd(&g);
+    BigInt* res = fromMagnitude(g.alen, g.a, 0);
+    int zero = isZeroRow(g.alen, g.a);
+    BigInt* x = NULL;
+    if(s || t) {
+        // the cofactor found goes with the magnitude of a
+        int negative = g.odd ^ HI_BIT(a->data[a->len - 1]);
+        x = zero ? fromMagnitude(1, g.a, 0) : fromMagnitude(g.ulen, g.ua, negative);
+    }
+    YABI_FREE(scratch);
+    if(t) {
+        // gcd = a * s + b * t, where the division is exact
+        if(yabi_cmp_si(b, 0) == 0) {
+            WordType zero = 0;
+            *t = fromMagnitude(1, &zero, 0);
+        } else {
+            BigInt* p = yabi_mul(a, x);
+            BigInt* d = yabi_sub(res, p);
+            ydiv_t qr = yabi_div(d, b);
+            *t = qr.quo;
+            yabi_release(qr.rem);
+            yabi_release(d);
+            yabi_release(p);
+        }
+    }
+    if(s) {
+        *s = x;
+    } else {
+        yabi_release(x);
+    }
+    return res;
+}
+
+size_t yabi_invert_scratch(size_t alen, size_t mlen) {
+    return gcdScratchLen(max(alen, mlen), 1);
+}
+
+size_t yabi_invertToBufWs(const BigInt* a, const BigInt* m, size_t len, WordType* buffer, yabi_workspace_t* ws) {
+    if(yabi_cmp_si(m, 0) == 0) {
+        return 0;
+    }
+    size_t n = max(a->len, m->len);
+    gcdState g;
+    WordType* scratch = takeScratch(ws, gcdScratchLen(n, 1));
+    gcdInit(&g, a, m, 1, scratch);
+    lehmerGcd(&g);
+    // an inverse only exists when the gcd is 1, and then the magnitude of
+    // the cofactor of a is below that of m
+    if(g.alen != 1 || g.a[0] != 1) {
+        dropScratch(ws, scratch);
+        return 0;
+    }
+    WordType* mag = g.s;
+    loadMagnitude(m, m->len, mag);
+    size_t mlen = trimZeros(m->len, mag);
+    WordType* x = g.ua;
+    size_t xlen = trimZeros(g.ulen, x);
+    if(mlen == 1 && mag[0] == 1) {
+        // everything is 0 modulo 1
+        x[0] = 0;
+        xlen = 1;
+    } else if((g.odd ^ HI_BIT(a->data[a->len - 1])) && !isZeroRow(xlen, x)) {
+        // a negative cofactor x stands for m - |x|
+        memset(x + xlen, 0, (mlen - xlen) * sizeof(WordType));
+        subRows(mlen, mag, x, x);
+        xlen = trimZeros(mlen, x);
+    }
+    len = storeUnsigned(xlen, x, len, buffer);
+    dropScratch(ws, scratch);
+    return len;
+}
+
+size_t yabi_invertToBuf(const BigInt* a, const BigInt* m, size_t len, WordType* buffer) {
+    return yabi_invertToBufWs(a, m, len, buffer, NULL);
+}
+
+BigInt* yabi_invert(const BigInt* a, const BigInt* m) {
+    size_t len = m->len + 1;
+    BigInt* res = YABI_NEW_BIGINT(len);
+    res->refCount = 0;
+    res->len = len;
+    res->cap = res->len;
+    len = yabi_invertToBuf(a, m, len, res->data);
+    if(len == 0) {
+        YABI_FREE_BIGINT(res);
+        return NULL;
+    }
+    if(len != res->len) {
+        RESIZE_BIGINT(res, len);
+    }
+    return res;
+}
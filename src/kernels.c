@@ -0,0 +1,530 @@
+#include "bigint_internal.h"
+#include <string.h>
+
+/*
+ * Row kernels for the passes that touch every word once: the bitwise
+ * operations, shifts and the scans of comparisons. There is a portable
+ * version of each, which is all there is off x86. On x86 there are SSE2,
+ * AVX2 and AVX-512 versions as well, and the first time a kernel is needed
+ * cpuid tells which of them the processor and operating system support.
+ *
+ * A row of words on a little-endian machine is the same run of bytes
+ * whatever the word size, so the vector loops never look at words. A
+ * shift by s bits is done on it in 64-bit lanes: each is shifted and
+ * takes the bits it is missing from the lane 8 bytes further down (or
+ * up), loaded unaligned, which makes a funnel shift of two plain ones.
+ * The vector loops leave what does not fill a vector to the portable
+ * ones, which bigint_internal.h also uses inline for short rows.
+ *
+ * The column kernels behind the batch functions go across values instead:
+ * the words of many values in the same position lie side by side, one
+ * value to a vector lane, and each lane carries into the next word by
+ * itself. Unlike the row kernels they need lanes of the word size.
+ */
+
+#if !defined(YABI_PORTABLE_PRIMITIVES) && YABI_SIMD_LEVEL > 0 \
+        && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) \
+        && (defined(__GNUC__) || defined(_MSC_VER))
+    #define ROW_KERNELS_X86
+#endif
+
+typedef struct rowKernelTable {
+    void (*andRows)(size_t n, const WordType* a, const WordType* b, WordType* buffer);
+    void (*orRows)(size_t n, const WordType* a, const WordType* b, WordType* buffer);
+    void (*xorRows)(size_t n, const WordType* a, const WordType* b, WordType* buffer);
+    void (*notRow)(size_t n, const WordType* a, WordType* buffer);
+    // the shifts of shiftLeftRow and shiftRightRow by 0 < s < w bits,
+    // without the carry out
+    void (*shlRow)(size_t n, const WordType* a, int s, WordType* buffer);
+    void (*shrRow)(size_t n, const WordType* a, int s, WordType* buffer);
+    size_t (*diffRows)(size_t n, const WordType* a, const WordType* b);
+    size_t (*spanRow)(size_t n, const WordType* a, WordType fill);
+    // addBatches and cmpBatches for n values side by side, whose word j
+    // is the row at a + j * as and so on
+    void (*addColumns)(
+        size_t n, size_t len, const WordType* a, size_t as, const WordType* b, size_t bs,
+        int negateb, size_t rlen, WordType* r, size_t rs);
+    void (*cmpColumns)(size_t n, size_t len, const WordType* a, size_t as, const WordType* b, size_t bs, int8_t* r);
+    // the YABI_SIMD_LEVEL of these
+    int level;
+} rowKernelTable;
+
+// a + b, or a - b when negateb is set, for each of n values whose word j
+// is a[i * al + j * aw] and so on
+static void addValuesPortable(
+        size_t n, size_t len,
+        const WordType* a, size_t al, size_t aw,
+        const WordType* b, size_t bl, size_t bw,
+        int negateb, size_t rlen, WordType* r, size_t rl, size_t rw) {
+    // a - b = a + ~b + 1
+    WordType flip = (WordType)-negateb;
+    for(size_t i = 0; i < n; i++) {
+        WordType carry = (WordType)negateb;
+        WordType x = 0;
+        WordType y = 0;
+        WordType s;
+        size_t j = 0;
+        for( ; j < len && j < rlen; j++) {
+            x = a[i * al + j * aw];
+            y = b[i * bl + j * bw] ^ flip;
+            carry = addAndCarry(x, y, carry, &s);
+            r[i * rl + j * rw] = s;
+        }
+        if(j < rlen) {
+            // the word above adds up the signs, and the rest is its sign
+            addAndCarry((WordType)-HI_BIT(x), (WordType)-HI_BIT(y), carry, &s);
+            for( ; j < rlen; j++) {
+                r[i * rl + j * rw] = s;
+                s = (WordType)-HI_BIT(s);
+            }
+        }
+    }
+}
+
+// the signed comparison of each of n values, laid out as for
+// addValuesPortable
+static void cmpValuesPortable(
+        size_t n, size_t len,
+        const WordType* a, size_t al, size_t aw,
+        const WordType* b, size_t bl, size_t bw,
+        int8_t* r) {
+    // flipping the top bit of the top words makes them compare unsigned
+    const WordType top = (WordType)1 << (YABI_WORD_BIT_SIZE - 1);
+    for(size_t i = 0; i < n; i++) {
+        int c = 0;
+        WordType flip = top;
+        for(size_t j = len; j-- > 0; flip = 0) {
+            WordType x = a[i * al + j * aw] ^ flip;
+            WordType y = b[i * bl + j * bw] ^ flip;
+            if(x != y) {
+                c = x < y ? -1 : 1;
+                break;
+            }
+        }
+        r[i] = (int8_t)c;
+    }
+}
+
+static void addColumnsPortable(
+        size_t n, size_t len, const WordType* a, size_t as, const WordType* b, size_t bs,
+        int negateb, size_t rlen, WordType* r, size_t rs) {
+    addValuesPortable(n, len, a, 1, as, b, 1, bs, negateb, rlen, r, 1, rs);
+}
+
+static void cmpColumnsPortable(size_t n, size_t len, const WordType* a, size_t as, const WordType* b, size_t bs, int8_t* r) {
+    cmpValuesPortable(n, len, a, 1, as, b, 1, bs, r);
+}
+
+static const rowKernelTable portableKernels = {
+    andRowsPortable, orRowsPortable, xorRowsPortable, notRowPortable,
+    shlRowPortable, shrRowPortable, diffRowsPortable, spanRowPortable,
+    addColumnsPortable, cmpColumnsPortable, 0
+};
+
+#ifdef ROW_KERNELS_X86
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #define KERNEL_TARGET(isa)
+#else
+    #include <immintrin.h>
+    #include <cpuid.h>
+    #define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// `fill` repeated across 64 bits
+static uint64_t fillPattern(WordType fill) {
+    uint64_t pattern = 0;
+    for(int i = 0; i < NATIVE_WORDS; i++) {
+        pattern = (pattern << (YABI_WORD_BIT_SIZE - 1)) << 1 | fill;
+    }
+    return pattern;
+}
+
+/*
+ * The kernels of one instruction set, given its vector type and size in
+ * bytes, and the operations on it: unaligned loads and stores, bitwise
+ * and, or and xor, all ones, 64-bit lane shifts by a count in the low
+ * lane of a 128-bit vector, equality of all bytes and a broadcast of 64
+ * bits.
+ */
+#define DEFINE_ROW_KERNELS(isa, target, vec, bytes, load, store, vand, vor, vxor, ones, sll, srl, same, set1) \
+    static KERNEL_TARGET(target) void andRows##isa(size_t n, const WordType* a, const WordType* b, WordType* buffer) { \
+        size_t i = 0; \
+        for( ; i + bytes / sizeof(WordType) <= n; i += bytes / sizeof(WordType)) { \
+            store(buffer + i, vand(load(a + i), load(b + i))); \
+        } \
+        andRowsPortable(n - i, a + i, b + i, buffer + i); \
+    } \
+    static KERNEL_TARGET(target) void orRows##isa(size_t n, const WordType* a, const WordType* b, WordType* buffer) { \
+        size_t i = 0; \
+        for( ; i + bytes / sizeof(WordType) <= n; i += bytes / sizeof(WordType)) { \
+            store(buffer + i, vor(load(a + i), load(b + i))); \
+        } \
+        orRowsPortable(n - i, a + i, b + i, buffer + i); \
+    } \
+    static KERNEL_TARGET(target) void xorRows##isa(size_t n, const WordType* a, const WordType* b, WordType* buffer) { \
+        size_t i = 0; \
+        for( ; i + bytes / sizeof(WordType) <= n; i += bytes / sizeof(WordType)) { \
+            store(buffer + i, vxor(load(a + i), load(b + i))); \
+        } \
+        xorRowsPortable(n - i, a + i, b + i, buffer + i); \
+    } \
+    static KERNEL_TARGET(target) void notRow##isa(size_t n, const WordType* a, WordType* buffer) { \
+        vec all = ones; \
+        size_t i = 0; \
+        for( ; i + bytes / sizeof(WordType) <= n; i += bytes / sizeof(WordType)) { \
+            store(buffer + i, vxor(load(a + i), all)); \
+        } \
+        notRowPortable(n - i, a + i, buffer + i); \
+    } \
+    static KERNEL_TARGET(target) void shlRow##isa(size_t n, const WordType* a, int s, WordType* buffer) { \
+        const char* x = (const char*)a; \
+        char* y = (char*)buffer; \
+        __m128i up = _mm_cvtsi32_si128(s); \
+        __m128i down = _mm_cvtsi32_si128(64 - s); \
+        /* the bytes left to shift, from the top down */ \
+        size_t top = n * sizeof(WordType); \
+        for( ; top >= bytes + 8; top -= bytes) { \
+            vec v = load(x + top - bytes); \
+            vec lower = load(x + top - bytes - 8); \
+            store(y + top - bytes, vor(sll(v, up), srl(lower, down))); \
+        } \
+        shlRowPortable(top / sizeof(WordType), a, s, buffer); \
+    } \
+    static KERNEL_TARGET(target) void shrRow##isa(size_t n, const WordType* a, int s, WordType* buffer) { \
+        const char* x = (const char*)a; \
+        char* y = (char*)buffer; \
+        __m128i down = _mm_cvtsi32_si128(s); \
+        __m128i up = _mm_cvtsi32_si128(64 - s); \
+        size_t end = n * sizeof(WordType); \
+        size_t lo = 0; \
+        for( ; lo + bytes + 8 <= end; lo += bytes) { \
+            vec v = load(x + lo); \
+            vec upper = load(x + lo + 8); \
+            store(y + lo, vor(srl(v, down), sll(upper, up))); \
+        } \
+        size_t i = lo / sizeof(WordType); \
+        shrRowPortable(n - i, a + i, s, buffer + i); \
+    } \
+    static KERNEL_TARGET(target) size_t diffRows##isa(size_t n, const WordType* a, const WordType* b) { \
+        while(n >= bytes / sizeof(WordType) \
+                && same(load(a + n - bytes / sizeof(WordType)), load(b + n - bytes / sizeof(WordType)))) { \
+            n -= bytes / sizeof(WordType); \
+        } \
+        return diffRowsPortable(n, a, b); \
+    } \
+    static KERNEL_TARGET(target) size_t spanRow##isa(size_t n, const WordType* a, WordType fill) { \
+        vec pattern = set1((long long)fillPattern(fill)); \
+        while(n >= bytes / sizeof(WordType) && same(load(a + n - bytes / sizeof(WordType)), pattern)) { \
+            n -= bytes / sizeof(WordType); \
+        } \
+        return spanRowPortable(n, a, fill); \
+    }
+
+/*
+ * The column kernels of one instruction set, given the same as for the
+ * row kernels as well as and-not, zero, and per lane of a word: addition,
+ * subtraction and the top bit moved to the bottom. A carry out of a lane
+ * is the top bit of (x & y) | ((x | y) & ~s) for the sum s of x and y, and
+ * a lane is nonzero when the top bit of it or of its negation is set.
+ */
+#define DEFINE_COLUMN_KERNELS(isa, target, vec, bytes, load, store, vand, vor, vxor, vandnot, zero, ones, add, sub, top) \
+    static KERNEL_TARGET(target) void addColumns##isa( \
+            size_t n, size_t len, const WordType* a, size_t as, const WordType* b, size_t bs, \
+            int negateb, size_t rlen, WordType* r, size_t rs) { \
+        vec flip = negateb ? ones : zero; \
+        size_t i = 0; \
+        for( ; i + bytes / sizeof(WordType) <= n; i += bytes / sizeof(WordType)) { \
+            vec carry = negateb ? top(ones) : zero; \
+            vec x = zero; \
+            vec y = zero; \
+            vec s; \
+            size_t j = 0; \
+            for( ; j < len && j < rlen; j++) { \
+                x = load(a + i + j * as); \
+                y = vxor(load(b + i + j * bs), flip); \
+                s = add(add(x, y), carry); \
+                carry = top(vor(vand(x, y), vandnot(s, vor(x, y)))); \
+                store(r + i + j * rs, s); \
+            } \
+            if(j < rlen) { \
+                s = add(add(sub(zero, top(x)), sub(zero, top(y))), carry); \
+                for( ; j < rlen; j++) { \
+                    store(r + i + j * rs, s); \
+                    s = sub(zero, top(s)); \
+                } \
+            } \
+        } \
+        addColumnsPortable(n - i, len, a + i, as, b + i, bs, negateb, rlen, r + i, rs); \
+    } \
+    static KERNEL_TARGET(target) void cmpColumns##isa( \
+            size_t n, size_t len, const WordType* a, size_t as, const WordType* b, size_t bs, int8_t* r) { \
+        size_t i = 0; \
+        for( ; i + bytes / sizeof(WordType) <= n; i += bytes / sizeof(WordType)) { \
+            /* a - b = a + ~b + 1 with one more word for the sign, and */ \
+            /* whether any words differ */ \
+            vec carry = top(ones); \
+            vec diff = zero; \
+            vec x = zero; \
+            vec y = zero; \
+            for(size_t j = 0; j < len; j++) { \
+                x = load(a + i + j * as); \
+                vec bj = load(b + i + j * bs); \
+                y = vxor(bj, ones); \
+                vec s = add(add(x, y), carry); \
+                carry = top(vor(vand(x, y), vandnot(s, vor(x, y)))); \
+                diff = vor(diff, vxor(x, bj)); \
+            } \
+            vec less = top(add(add(sub(zero, top(x)), sub(zero, top(y))), carry)); \
+            vec differ = top(vor(diff, sub(zero, diff))); \
+            WordType c[bytes / sizeof(WordType)]; \
+            store(c, sub(differ, add(less, less))); \
+            for(size_t k = 0; k < bytes / sizeof(WordType); k++) { \
+                r[i + k] = (int8_t)(c[k] == 0 ? 0 : c[k] == 1 ? 1 : -1); \
+            } \
+        } \
+        cmpColumnsPortable(n - i, len, a + i, as, b + i, bs, r + i); \
+    }
+
+#define KERNEL_TABLE(isa, columns, level) \
+    static const rowKernelTable isa##Kernels = { \
+        andRows##isa, orRows##isa, xorRows##isa, notRow##isa, \
+        shlRow##isa, shrRow##isa, diffRows##isa, spanRow##isa, \
+        addColumns##columns, cmpColumns##columns, level \
+    };
+
+// the lanes of one word in each instruction set. AVX-512F only has lanes
+// of 32 and 64 bits, so smaller words stay with AVX2
+#if YABI_WORD_BIT_SIZE == 8
+    #define SSE2_LANE_ADD _mm_add_epi8
+    #define SSE2_LANE_SUB _mm_sub_epi8
+    #define SSE2_LANE_TOP(x) _mm_and_si128(_mm_srli_epi16(x, 7), _mm_set1_epi8(1))
+    #define AVX2_LANE_ADD _mm256_add_epi8
+    #define AVX2_LANE_SUB _mm256_sub_epi8
+    #define AVX2_LANE_TOP(x) _mm256_and_si256(_mm256_srli_epi16(x, 7), _mm256_set1_epi8(1))
+#elif YABI_WORD_BIT_SIZE == 16
+    #define SSE2_LANE_ADD _mm_add_epi16
+    #define SSE2_LANE_SUB _mm_sub_epi16
+    #define SSE2_LANE_TOP(x) _mm_srli_epi16(x, 15)
+    #define AVX2_LANE_ADD _mm256_add_epi16
+    #define AVX2_LANE_SUB _mm256_sub_epi16
+    #define AVX2_LANE_TOP(x) _mm256_srli_epi16(x, 15)
+#elif YABI_WORD_BIT_SIZE == 32
+    #define SSE2_LANE_ADD _mm_add_epi32
+    #define SSE2_LANE_SUB _mm_sub_epi32
+    #define SSE2_LANE_TOP(x) _mm_srli_epi32(x, 31)
+    #define AVX2_LANE_ADD _mm256_add_epi32
+    #define AVX2_LANE_SUB _mm256_sub_epi32
+    #define AVX2_LANE_TOP(x) _mm256_srli_epi32(x, 31)
+    #define AVX512_LANE_ADD _mm512_add_epi32
+    #define AVX512_LANE_SUB _mm512_sub_epi32
+    #define AVX512_LANE_TOP(x) _mm512_srli_epi32(x, 31)
+#else
+    #define SSE2_LANE_ADD _mm_add_epi64
+    #define SSE2_LANE_SUB _mm_sub_epi64
+    #define SSE2_LANE_TOP(x) _mm_srli_epi64(x, 63)
+    #define AVX2_LANE_ADD _mm256_add_epi64
+    #define AVX2_LANE_SUB _mm256_sub_epi64
+    #define AVX2_LANE_TOP(x) _mm256_srli_epi64(x, 63)
+    #define AVX512_LANE_ADD _mm512_add_epi64
+    #define AVX512_LANE_SUB _mm512_sub_epi64
+    #define AVX512_LANE_TOP(x) _mm512_srli_epi64(x, 63)
+#endif
+
+#define SSE2_LOAD(p) _mm_loadu_si128((const __m128i*)(const void*)(p))
+#define SSE2_STORE(p, v) _mm_storeu_si128((__m128i*)(void*)(p), v)
+#define SSE2_SAME(x, y) (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) == 0xffff)
+DEFINE_ROW_KERNELS(Sse2, "sse2", __m128i, 16, SSE2_LOAD, SSE2_STORE,
+    _mm_and_si128, _mm_or_si128, _mm_xor_si128, _mm_set1_epi32(-1),
+    _mm_sll_epi64, _mm_srl_epi64, SSE2_SAME, _mm_set1_epi64x)
+DEFINE_COLUMN_KERNELS(Sse2, "sse2", __m128i, 16, SSE2_LOAD, SSE2_STORE,
+    _mm_and_si128, _mm_or_si128, _mm_xor_si128, _mm_andnot_si128,
+    _mm_setzero_si128(), _mm_set1_epi32(-1), SSE2_LANE_ADD, SSE2_LANE_SUB, SSE2_LANE_TOP)
+KERNEL_TABLE(Sse2, Sse2, 1)
+
+#if YABI_SIMD_LEVEL >= 2
+#define AVX2_LOAD(p) _mm256_loadu_si256((const __m256i*)(const void*)(p))
+#define AVX2_STORE(p, v) _mm256_storeu_si256((__m256i*)(void*)(p), v)
+#define AVX2_SAME(x, y) (_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)) == -1)
+DEFINE_ROW_KERNELS(Avx2, "avx2", __m256i, 32, AVX2_LOAD, AVX2_STORE,
+    _mm256_and_si256, _mm256_or_si256, _mm256_xor_si256, _mm256_set1_epi32(-1),
+    _mm256_sll_epi64, _mm256_srl_epi64, AVX2_SAME, _mm256_set1_epi64x)
+DEFINE_COLUMN_KERNELS(Avx2, "avx2", __m256i, 32, AVX2_LOAD, AVX2_STORE,
+    _mm256_and_si256, _mm256_or_si256, _mm256_xor_si256, _mm256_andnot_si256,
+    _mm256_setzero_si256(), _mm256_set1_epi32(-1), AVX2_LANE_ADD, AVX2_LANE_SUB, AVX2_LANE_TOP)
+KERNEL_TABLE(Avx2, Avx2, 2)
+#endif
+
+#if YABI_SIMD_LEVEL >= 3
+#define AVX512_LOAD(p) _mm512_loadu_si512((const void*)(p))
+#define AVX512_STORE(p, v) _mm512_storeu_si512((void*)(p), v)
+#define AVX512_SAME(x, y) (_mm512_cmpneq_epi64_mask(x, y) == 0)
+DEFINE_ROW_KERNELS(Avx512, "avx512f", __m512i, 64, AVX512_LOAD, AVX512_STORE,
+    _mm512_and_si512, _mm512_or_si512, _mm512_xor_si512, _mm512_set1_epi32(-1),
+    _mm512_sll_epi64, _mm512_srl_epi64, AVX512_SAME, _mm512_set1_epi64)
+#if YABI_WORD_BIT_SIZE >= 32
+DEFINE_COLUMN_KERNELS(Avx512, "avx512f", __m512i, 64, AVX512_LOAD, AVX512_STORE,
+    _mm512_and_si512, _mm512_or_si512, _mm512_xor_si512, _mm512_andnot_si512,
+    _mm512_setzero_si512(), _mm512_set1_epi32(-1), AVX512_LANE_ADD, AVX512_LANE_SUB, AVX512_LANE_TOP)
+KERNEL_TABLE(Avx512, Avx512, 3)
+#else
+KERNEL_TABLE(Avx512, Avx2, 3)
+#endif
+#endif
+
+// eax, ebx, ecx and edx of cpuid with the given leaf and subleaf
+static void cpuid(unsigned int leaf, unsigned int sub, unsigned int r[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuidex(regs, (int)leaf, (int)sub);
+    for(int i = 0; i < 4; i++) {
+        r[i] = (unsigned int)regs[i];
+    }
+#else
+    __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+}
+
+// the register states the operating system saves, which have to include
+// the vector registers before they can be used
+static uint64_t enabledStates(void) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _xgetbv(0);
+#else
+    unsigned int lo;
+    unsigned int hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (uint64_t)hi << 32 | lo;
+#endif
+}
+
+// the widest kernels the processor supports, up to `level`
+static const rowKernelTable* pickKernels(int level) {
+    unsigned int r[4];
+    cpuid(0, 0, r);
+    unsigned int maxLeaf = r[0];
+    cpuid(1, 0, r);
+    if(level < 1 || !(r[3] & (1u << 26))) {
+        // no SSE2
+        return &portableKernels;
+    }
+    const rowKernelTable* k = &Sse2Kernels;
+    // AVX, and the operating system saving its registers
+    if(level < 2 || maxLeaf < 7 || !(r[2] & (1u << 27)) || !(r[2] & (1u << 28))) {
+        return k;
+    }
+    uint64_t states = enabledStates();
+    cpuid(7, 0, r);
+#if YABI_SIMD_LEVEL >= 2
+    // xmm and ymm state
+    if((states & 0x6) != 0x6 || !(r[1] & (1u << 5))) {
+        return k;
+    }
+    k = &Avx2Kernels;
+#endif
+#if YABI_SIMD_LEVEL >= 3
+    // opmask and zmm state as well
+    if(level >= 3 && (states & 0xe6) == 0xe6 && (r[1] & (1u << 16))) {
+        k = &Avx512Kernels;
+    }
+#endif
+    (void)states;
+    return k;
+}
+
+#else
+
+static const rowKernelTable* pickKernels(int level) {
+    (void)level;
+    return &portableKernels;
+}
+
+#endif
+
+static const rowKernelTable* selected;
+
+// the kernels for this processor, which are picked on first use. Every
+// thread picks the same ones, so racing to store them does no harm
+static const rowKernelTable* rowKernels(void) {
+#if defined(__GNUC__)
+    const rowKernelTable* k = __atomic_load_n(&selected, __ATOMIC_RELAXED);
+#else
+    const rowKernelTable* k = selected;
+#endif
+    if(!k) {
+        k = pickKernels(YABI_SIMD_LEVEL);
+#if defined(__GNUC__)
+        __atomic_store_n(&selected, k, __ATOMIC_RELAXED);
+#else
+        selected = k;
+#endif
+    }
+    return k;
+}
+
+int useKernelLevel(int level) {
+    const rowKernelTable* k = pickKernels(level);
+#if defined(__GNUC__)
+    __atomic_store_n(&selected, k, __ATOMIC_RELAXED);
+#else
+    selected = k;
+#endif
+    return k->level;
+}
+
+// the kernels behind the row functions in bigint_internal.h, which only
+// call these for rows of at least ROW_KERNEL_BYTES
+
+void andRowsWide(size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    rowKernels()->andRows(n, a, b, buffer);
+}
+
+void orRowsWide(size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    rowKernels()->orRows(n, a, b, buffer);
+}
+
+void xorRowsWide(size_t n, const WordType* a, const WordType* b, WordType* buffer) {
+    rowKernels()->xorRows(n, a, b, buffer);
+}
+
+void notRowWide(size_t n, const WordType* a, WordType* buffer) {
+    rowKernels()->notRow(n, a, buffer);
+}
+
+void shlRowWide(size_t n, const WordType* a, int s, WordType* buffer) {
+    rowKernels()->shlRow(n, a, s, buffer);
+}
+
+void shrRowWide(size_t n, const WordType* a, int s, WordType* buffer) {
+    rowKernels()->shrRow(n, a, s, buffer);
+}
+
+size_t diffRowsWide(size_t n, const WordType* a, const WordType* b) {
+    return rowKernels()->diffRows(n, a, b);
+}
+
+size_t spanRowWide(size_t n, const WordType* a, WordType fill) {
+    return rowKernels()->spanRow(n, a, fill);
+}
+
+// a + b, or a - b when negateb is set, and the signed comparison, for each
+// of n values. Vectors go across the values when their words are side by
+// side
+
+void addBatches(size_t n, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, int negateb, size_t rlen, const yabi_batch_t* r) {
+    if(a->lane == 1 && b->lane == 1 && r->lane == 1) {
+        rowKernels()->addColumns(n, len, a->data, a->word, b->data, b->word, negateb, rlen, r->data, r->word);
+    } else {
+        addValuesPortable(n, len, a->data, a->lane, a->word, b->data, b->lane, b->word,
+            negateb, rlen, r->data, r->lane, r->word);
+    }
+}
+
+void cmpBatches(size_t n, size_t len, const yabi_batch_t* a, const yabi_batch_t* b, int8_t* r) {
+    if(a->lane == 1 && b->lane == 1) {
+        rowKernels()->cmpColumns(n, len, a->data, a->word, b->data, b->word, r);
+    } else {
+        cmpValuesPortable(n, len, a->data, a->lane, a->word, b->data, b->lane, b->word, r);
+    }
+}
@@ -0,0 +1,281 @@
+#include "bigint_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Arithmetic modulo an odd m in Montgomery form, where x is represented by
+ * x * R mod m with R = 2^(n * w). Multiplying two such numbers and dividing
+ * by R gives the representation of their product, and dividing by R is a
+ * word at a time reduction instead of a long division.
+ */
+
+// largest window used by yabi_mont_powmod, which keeps 2^(MONT_MAX_WINDOW - 1)
+// odd powers of the base
+#define MONT_MAX_WINDOW 6
+
+// exponents longer than windowLimits[k - 1] bits use a window of k + 1 bits
+static const size_t windowLimits[MONT_MAX_WINDOW - 1] = { 7, 36, 140, 450, 1303 };
+
+// scratch layout: the product of two numbers, then whatever squaring needs,
+// then the table of odd powers and the accumulator used by powmod
+static size_t workLen(size_t n) {
+    return 2 * n + 1 + mulScratchLen(n);
+}
+
+static int isZero(size_t n, const WordType* a) {
+    for(size_t i = 0; i < n; i++) {
+        if(a[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Montgomery reduction of the 2n-word t < m * R, which is overwritten.
+// Each row adds the multiple of m that clears the lowest word, so that word
+// is free to keep the row's carry until they are all added in at the end
+static void redc(const yabi_mont_t* ctx, WordType* t, WordType* buffer) {
+    size_t n = ctx->n;
+    for(size_t i = 0; i < n; i++) {
+        WordType q = (WordType)(t[i] * ctx->minv);
+        t[i] = addMulRow(n, ctx->mod, q, t + i);
+    }
+    WordType carry = addRows(n, t + n, t, buffer);
+    if(carry || cmpBuffers(n, buffer, n, ctx->mod, 0) >= 0) {
+        subRows(n, buffer, ctx->mod, buffer);
+    }
+}
+
+// a * b / R mod m for a < R and b < m, by coarsely integrated operand
+// scanning: each row of a times a word of b is followed at once by the row
+// of m that clears the lowest word, so the sum never grows past n + 1
+// words. It slides up one word of `t` per row rather than being shifted
+// down, so `t` holds 2n + 1 words
+static void mulRedc(const yabi_mont_t* ctx, const WordType* a, const WordType* b, WordType* t, WordType* buffer) {
+    size_t n = ctx->n;
+    const WordType* m = ctx->mod;
+    // the sum is below 2m, so it only spills one bit past n words
+    WordType top = 0;
+    memset(t, 0, n * sizeof(WordType));
+    for(size_t i = 0; i < n; i++) {
+        WordType* ti = t + i;
+        WordType ca = addMulRow(n, a, b[i], ti);
+        WordType q = (WordType)(ti[0] * ctx->minv);
+        WordType cm = addMulRow(n, m, q, ti);
+        top = addAndCarry(ca, cm, top, &ti[n]);
+    }
+    if(top || cmpBuffers(n, t + n, n, m, 0) >= 0) {
+        subRows(n, t + n, m, buffer);
+    } else {
+        memmove(buffer, t + n, n * sizeof(WordType));
+    }
+}
+
+// reduces the magnitude of a, which is longer than n words, modulo m
+static void reduceLong(const yabi_mont_t* ctx, const BigInt* a, WordType* buffer) {
+    size_t n = ctx->n;
+    size_t ulen = a->len + 1;
+    size_t divLen = n == 1 ? 0 : divremScratchLen(ulen, n);
+    WordType* u = YABI_MALLOC((2 * ulen + divLen) * sizeof(WordType));
+    WordType* q = u + ulen;
+    loadMagnitude(a, ulen, u);
+    if(n == 1) {
+        buffer[0] = divremWord(ulen, u, ctx->mod[0], q);
+    } else {
+        // divide by the normalized modulus, as divUnsigned does
+        int s = leadingZeros(ctx->mod[n - 1]);
+        shiftLeftRow(ulen, u, s, u);
+        divremNormalized(ulen, u, n, ctx->norm, q, q + ulen);
+        shiftRightRow(n, u, s, buffer);
+    }
+    YABI_FREE(u);
+}
+
+yabi_mont_t* yabi_mont_init(const BigInt* modulus) {
+    size_t n = modulus->len;
+    // the modulus must be odd and positive
+    if(HI_BIT(modulus->data[n - 1]) || !(modulus->data[0] & 1)) {
+        return NULL;
+    }
+    while(n > 1 && modulus->data[n - 1] == 0) {
+        n--;
+    }
+    size_t scratchLen = workLen(n) + (((size_t)1 << (MONT_MAX_WINDOW - 1)) + 1) * n;
+    yabi_mont_t* ctx = YABI_MALLOC(sizeof(yabi_mont_t) + (4 * n + scratchLen) * sizeof(WordType));
+    WordType* next = (WordType*)(ctx + 1);
+    ctx->n = n;
+    ctx->mod = next;
+    ctx->norm = next + n;
+    ctx->one = next + 2 * n;
+    ctx->r2 = next + 3 * n;
+    ctx->scratch = next + 4 * n;
+    memcpy(ctx->mod, modulus->data, n * sizeof(WordType));
+    shiftLeftRow(n, ctx->mod, leadingZeros(ctx->mod[n - 1]), ctx->norm);
+    // Newton's iteration for m^-1 mod 2^w. m is its own inverse mod 8,
+    // and each step doubles the number of correct bits
+    WordType inv = ctx->mod[0];
+    for(int bits = 3; bits < YABI_WORD_BIT_SIZE; bits *= 2) {
+        inv = (WordType)(inv * (WordType)(2 - (WordType)(ctx->mod[0] * inv)));
+    }
+    ctx->minv = (WordType)-inv;
+    // R^2 mod m by one long division, then R mod m by reducing it once
+    WordType* u = ctx->scratch;
+    memset(u, 0, 2 * n * sizeof(WordType));
+    if(n == 1) {
+        u[2] = 1;
+        ctx->r2[0] = divremWord(3, u, ctx->mod[0], u + 3);
+    } else {
+        int s = leadingZeros(ctx->mod[n - 1]);
+        size_t divLen = divremScratchLen(2 * n + 1, n);
+        WordType* q = YABI_MALLOC((n + 1 + divLen) * sizeof(WordType));
+        u[2 * n] = (WordType)1 << s;
+        divremNormalized(2 * n + 1, u, n, ctx->norm, q, q + n + 1);
+        shiftRightRow(n, u, s, ctx->r2);
+        YABI_FREE(q);
+    }
+    memcpy(u, ctx->r2, n * sizeof(WordType));
+    memset(u + n, 0, n * sizeof(WordType));
+    redc(ctx, u, ctx->one);
+    return ctx;
+}
+
+void yabi_mont_free(yabi_mont_t* ctx) {
+    YABI_FREE(ctx);
+}
+
+void yabi_mont_to(yabi_mont_t* ctx, const BigInt* a, WordType* buffer) {
+    size_t n = ctx->n;
+    int negative;
+    if(a->len <= n) {
+        // anything below R can go straight into the multiplication by R^2
+        negative = loadMagnitude(a, n, buffer);
+    } else {
+        negative = HI_BIT(a->data[a->len - 1]);
+        reduceLong(ctx, a, buffer);
+    }
+    mulRedc(ctx, buffer, ctx->r2, ctx->scratch, buffer);
+    // -x mod m is m - x, unless x is 0
+    if(negative && !isZero(n, buffer)) {
+        subRows(n, ctx->mod, buffer, buffer);
+    }
+}
+
+size_t yabi_mont_fromToBuf(yabi_mont_t* ctx, const WordType* a, size_t len, WordType* buffer) {
+    size_t n = ctx->n;
+    WordType* t = ctx->scratch;
+    memcpy(t, a, n * sizeof(WordType));
+    memset(t + n, 0, n * sizeof(WordType));
+    redc(ctx, t, t);
+    return storeUnsigned(n, t, len, buffer);
+}
+
+BigInt* yabi_mont_from(yabi_mont_t* ctx, const WordType* a) {
+    size_t len = ctx->n + 1;
+    BigInt* res = YABI_NEW_BIGINT(len);
+    res->refCount = 0;
+    res->len = len;
+    res->cap = res->len;
+    size_t newLen = yabi_mont_fromToBuf(ctx, a, len, res->data);
+    if(newLen != len) {
+        RESIZE_BIGINT(res, newLen);
+    }
+    return res;
+}
+
+void yabi_mont_mulmod(yabi_mont_t* ctx, const WordType* a, const WordType* b, WordType* buffer) {
+    mulRedc(ctx, a, b, ctx->scratch, buffer);
+}
+
+void yabi_mont_sqrmod(yabi_mont_t* ctx, const WordType* a, WordType* buffer) {
+    // squaring computes each cross product once, which saves more than
+    // fusing the reduction into the multiplication would
+    WordType* t = ctx->scratch;
+    sqrUnsigned(ctx->n, a, t, t + 2 * ctx->n + 1);
+    redc(ctx, t, buffer);
+}
+
+// bit i of the non-negative exponent
+static int expBit(const BigInt* e, size_t i) {
+    return (e->data[i / YABI_WORD_BIT_SIZE] >> (i % YABI_WORD_BIT_SIZE)) & 1;
+}
+
+size_t yabi_mont_powmod(yabi_mont_t* ctx, const BigInt* base, const BigInt* exp, size_t len, WordType* buffer) {
+    // negative exponents would need an inverse
+    if(HI_BIT(exp->data[exp->len - 1])) {
+        return 0;
+    }
+    size_t n = ctx->n;
+    size_t bits = exp->len * YABI_WORD_BIT_SIZE;
+    while(bits > 0 && !expBit(exp, bits - 1)) {
+        bits--;
+    }
+    int k = 1;
+    while(k < MONT_MAX_WINDOW && bits > windowLimits[k - 1]) {
+        k++;
+    }
+    // table[i] holds base^(2i + 1)
+    WordType* table = ctx->scratch + workLen(n);
+    WordType* acc = table + ((size_t)1 << (MONT_MAX_WINDOW - 1)) * n;
+    yabi_mont_to(ctx, base, table);
+    if(k > 1) {
+        yabi_mont_sqrmod(ctx, table, acc);
+        for(size_t i = 1; i < ((size_t)1 << (k - 1)); i++) {
+            yabi_mont_mulmod(ctx, table + (i - 1) * n, acc, table + i * n);
+        }
+    }
+    // left to right, each window is the longest run of at most k bits
+    // that starts and ends with a one
+    int started = 0;
+    size_t i = bits;
+    while(i > 0) {
+        if(!expBit(exp, i - 1)) {
+            yabi_mont_sqrmod(ctx, acc, acc);
+            i--;
+            continue;
+        }
+        size_t l = min((size_t)k, i);
+        while(!expBit(exp, i - l)) {
+            l--;
+        }
+        size_t w = 0;
+        for(size_t j = 0; j < l; j++) {
+            w = (w << 1) | expBit(exp, i - 1 - j);
+        }
+        const WordType* power = table + (w >> 1) * n;
+        if(started) {
+            for(size_t j = 0; j < l; j++) {
+                yabi_mont_sqrmod(ctx, acc, acc);
+            }
+            yabi_mont_mulmod(ctx, acc, power, acc);
+        } else {
+            memcpy(acc, power, n * sizeof(WordType));
+            started = 1;
+        }
+        i -= l;
+    }
+    if(!started) {
+        memcpy(acc, ctx->one, n * sizeof(WordType));
+    }
+    return yabi_mont_fromToBuf(ctx, acc, len, buffer);
+}
+
+BigInt* yabi_powmod(const BigInt* base, const BigInt* exp, const BigInt* mod) {
+    if(HI_BIT(exp->data[exp->len - 1])) {
+        return NULL;
+    }
+    yabi_mont_t* ctx = yabi_mont_init(mod);
+    if(!ctx) {
+        return NULL;
+    }
+    size_t len = ctx->n + 1;
+    BigInt* res = YABI_NEW_BIGINT(len);
+    res->refCount = 0;
+    res->len = len;
+    res->cap = res->len;
+    size_t newLen = yabi_mont_powmod(ctx, base, exp, len, res->data);
+    if(newLen != len) {
+        RESIZE_BIGINT(res, newLen);
+    }
+    yabi_mont_free(ctx);
+    return res;
+}
@@ -3,66 +3,472 @@
 #include <string.h>
 #include <assert.h>
 
-// naive two's complement multiplication for buffers
-size_t mulBuffers(
+// grade-school multiplication of unsigned buffers. Stores the low `len` words
+// of a * b in `buffer`, where len <= alen + blen. `buffer` may not overlap
+// either argument.
+static void mulBasecase(
         size_t alen, const WordType* adata,
         size_t blen, const WordType* bdata,
         size_t len, WordType* buffer) {
-    WordType asign = -HI_BIT(adata[alen - 1]);
-    WordType bsign = -HI_BIT(bdata[blen - 1]);
-    size_t stop = max(alen, blen) * 2;
-    stop = min(stop, len);
-    //we multiply with the following method based on the grade-school
-    //multiplication method. This allows `buffer` to alias `adata` or `bdata`
-    // for idx in [len..1]:
-    //    WordType tmp[2] = 0
-    //    for j in [0..idx]:
-    //        buffer[idx-1:] += a[j] * b[idx - 1 - j]
-    for(size_t idx = stop - 1; idx > 0; idx--) {
-        {
-            //calculate with the data at `idx - 1` before we
-            //overwrite it
-            WordType scratch[3] = { 0, 0, 0 };
-            WordType scratch2[3] = { 0, 0, 0 };
-            WordType awordAtIdx = idx < alen ? adata[idx] : asign;
-            WordType bwordAtIdx = idx < blen ? bdata[idx] : bsign;
-            scratch[1] = mulAndCarry(awordAtIdx, bdata[0], &scratch[0]);
-            scratch2[1] = mulAndCarry(bwordAtIdx, adata[0], &scratch[0]);
-            buffer[idx] = 0;
-            addBuffers(len - idx, buffer + idx,
-                3, scratch,
-                0,
-                len - idx, buffer + idx);
-            addBuffers(len - idx, buffer + idx,
-                3, scratch2,
-                0,
-                len - idx, buffer + idx);
-        }
-        for(size_t j = 1; j < idx; j++) {
-            //we use the FOIL method for half-words so as not to
-            //lose overflow bits.
-            // (ahi + alo)(bhi + blo)
-            // = ahi*bhi + ahi*blo + alo*bhi + alo*blo
-            WordType scratch[3] = { 0, 0, 0 };
-            WordType aword = j < alen ? adata[j] : asign;
-            WordType bword = (idx - j) < blen ? bdata[idx - j] : bsign;
-            scratch[1] = mulAndCarry(aword, bword, &scratch[0]);
-            addBuffers(len - idx, buffer + idx,
-                3, scratch,
-                0,
-                len - idx, buffer + idx);
-        }
-    }
-    {
-        //calculate buffer[0]
-        WordType scratch[3] = { 0, 0, 0 };
-        scratch[1] = mulAndCarry(adata[0], bdata[0], &scratch[0]);
-        buffer[0] = 0;
-        addBuffers(len, buffer,
-            3, scratch,
-            0,
-            len, buffer);
+    assert(len <= alen + blen);
+    // iterate over the shorter argument, accumulating one row per word
+    if(alen > blen) {
+        const WordType* tmp = adata;
+        adata = bdata;
+        bdata = tmp;
+        size_t tmplen = alen;
+        alen = blen;
+        blen = tmplen;
+    }
+    alen = min(alen, len);
+    // the first row initializes the buffer. every later row adds into the
+    // words the rows before it wrote, and stores its carry in the next fresh word
+    size_t rowLen = min(blen, len);
+    WordType carry = mulRow(rowLen, bdata, adata[0], buffer);
+    if(rowLen < len) {
+        buffer[rowLen] = carry;
+    }
+    for(size_t i = 1; i < alen; i++) {
+        rowLen = min(blen, len - i);
+        carry = addMulRow(rowLen, bdata, adata[i], buffer + i);
+        if(i + rowLen < len) {
+            buffer[i + rowLen] = carry;
+        }
+    }
+}
+
+// grade-school squaring of an unsigned buffer. Stores the low `len` words of
+// a^2 in `buffer`, where len <= 2n. Every cross product a[i] * a[j] with
+// i < j is computed once, then the sum of them is doubled and the squares of
+// single words are added in. `buffer` may not overlap `a`.
+static void sqrBasecase(size_t n, const WordType* a, size_t len, WordType* buffer) {
+    assert(len <= 2 * n);
+    memset(buffer, 0, len * sizeof(WordType));
+    // row i holds a[i] * a[i + 1..n), starting at word 2i + 1
+    for(size_t i = 0; i + 1 < n && 2 * i + 1 < len; i++) {
+        size_t rowLen = min(n - 1 - i, len - 2 * i - 1);
+        WordType carry = addMulRow(rowLen, a + i + 1, a[i], buffer + 2 * i + 1);
+        if(2 * i + 1 + rowLen < len) {
+            buffer[2 * i + 1 + rowLen] = carry;
+        }
+    }
+    shiftLeftRow(len, buffer, 1, buffer);
+    WordType carry = 0;
+    for(size_t i = 0; 2 * i < len; i++) {
+        WordType lo = 0;
+        WordType hi = mulAndCarry(a[i], a[i], &lo);
+        carry = addAndCarry(buffer[2 * i], lo, carry, &buffer[2 * i]);
+        if(2 * i + 1 < len) {
+            carry = addAndCarry(buffer[2 * i + 1], hi, carry, &buffer[2 * i + 1]);
+        }
+    }
+}
+
+// scratch words needed by mulUnsigned and sqrUnsigned for operands of at
+// most n words. Every level of recursion uses fewer than 4n + 16 words and
+// recurses on operands of fewer than n / 2 + 3 words, unless it hands the
+// operands to the number theoretic transform.
+size_t mulScratchLen(size_t n) {
+    size_t len = 0;
+    size_t ntt = 0;
+    while(n >= min(YABI_KARATSUBA_THRESHOLD, YABI_SQR_KARATSUBA_THRESHOLD)) {
+        if(n >= YABI_NTT_THRESHOLD && nttFits(n, n)) {
+            ntt = max(ntt, len + nttScratchLen(n, n));
+        }
+        len += 4 * n + 16;
+        n = n / 2 + 3;
+    }
+    return max(len, ntt);
+}
+
+// buffer[0..an) = |a - b| for unsigned a and b with an >= bn. returns 1
+// if the difference is negative. `buffer` may be the same as `a`.
+static int absDiff(size_t an, const WordType* a, size_t bn, const WordType* b, WordType* buffer) {
+    if(cmpBuffers(an, a, bn, b, 0) >= 0) {
+        WordType borrow = subRows(bn, a, b, buffer);
+        subWordRow(an - bn, a + bn, borrow, buffer + bn);
+        return 0;
+    } else {
+        // b is bigger, so the high words of a are all zero
+        subRows(bn, b, a, buffer);
+        memset(buffer + bn, 0, (an - bn) * sizeof(WordType));
+        return 1;
+    }
+}
+
+// buffer[off..len) += a, where a fits once added
+static void addAt(size_t len, WordType* buffer, size_t off, size_t alen, const WordType* a) {
+    size_t n = min(alen, len - off);
+    WordType carry = addRows(n, buffer + off, a, buffer + off);
+    addWordRow(len - off - n, buffer + off + n, carry, buffer + off + n);
+}
+
+// buffer[0..len) -= a, zero extending a
+static void subFrom(size_t len, WordType* buffer, size_t alen, const WordType* a) {
+    WordType borrow = subRows(alen, buffer, a, buffer);
+    subWordRow(len - alen, buffer + alen, borrow, buffer + alen);
+}
+
+// divides a two's complement buffer by 3, which must divide it exactly
+static void divExactBy3(size_t len, WordType* buffer) {
+    // multiply by the inverse of 3 modulo 2^w, one word at a time
+    const WordType inv = (WordType)(((WordType)~(WordType)0 / 3) * 2 + 1);
+    WordType borrow = 0;
+    for(size_t i = 0; i < len; i++) {
+        WordType s = buffer[i] - borrow;
+        borrow = s > buffer[i];
+        WordType q = s * inv;
+        buffer[i] = q;
+        // q * 3 == s modulo 2^w, the high word is what must be borrowed
+        WordType lo = 0;
+        borrow += mulAndCarry(q, 3, &lo);
+    }
+}
+
+// divides a two's complement buffer by 2, which must divide it exactly
+static void divExactBy2(size_t len, WordType* buffer) {
+    for(size_t i = 0; i < len - 1; i++) {
+        buffer[i] = (WordType)(buffer[i] >> 1) | (WordType)(buffer[i + 1] << (YABI_WORD_BIT_SIZE - 1));
+    }
+    buffer[len - 1] = (WordType)(buffer[len - 1] >> 1) | (WordType)(buffer[len - 1] & ((WordType)1 << (YABI_WORD_BIT_SIZE - 1)));
+}
+
+// a product that may be left to a task on another thread
+typedef struct mulJob {
+    size_t alen;
+    const WordType* adata;
+    size_t blen;
+    const WordType* bdata;
+    WordType* buffer;
+    WordType* scratch;
+    // the copies of the operands and the scratch of a forked job
+    WordType* own;
+    parTask task;
+} mulJob;
+
+static void runMulJob(void* arg) {
+    mulJob* j = arg;
+    if(j->bdata) {
+        mulUnsigned(j->alen, j->adata, j->blen, j->bdata, j->buffer, j->scratch);
+    } else {
+        sqrUnsigned(j->alen, j->adata, j->buffer, j->scratch);
+    }
+}
+
+// starts buffer = a * b, or a^2 when `b` is NULL. A product that is worth a
+// task gets copies of its operands and scratch of its own, so that the
+// caller may reuse both, and is forked. Otherwise, or when there is no
+// memory for it, it is done at once in `scratch`
+static void forkProduct(
+        mulJob* j,
+        size_t alen, const WordType* adata,
+        size_t blen, const WordType* bdata,
+        WordType* buffer, WordType* scratch) {
+    j->alen = alen;
+    j->adata = adata;
+    j->blen = blen;
+    j->bdata = bdata;
+    j->buffer = buffer;
+    j->scratch = scratch;
+    j->own = NULL;
+    size_t n = bdata ? min(alen, blen) : alen;
+    if(PARALLEL_WORTH(n)) {
+        size_t copyLen = alen + (bdata ? blen : 0);
+        j->own = YABI_MALLOC((copyLen + mulScratchLen(max(alen, blen)) + 1) * sizeof(WordType));
     }
+    if(!j->own) {
+        runMulJob(j);
+        return;
+    }
+    memcpy(j->own, adata, alen * sizeof(WordType));
+    j->adata = j->own;
+    if(bdata) {
+        memcpy(j->own + alen, bdata, blen * sizeof(WordType));
+        j->bdata = j->own + alen;
+    }
+    j->scratch = j->own + alen + (bdata ? blen : 0);
+    forkTask(&j->task, runMulJob, j);
+}
+
+static void joinProduct(mulJob* j) {
+    if(j->own) {
+        joinTask(&j->task);
+        YABI_FREE(j->own);
+    }
+}
+
+// splits a = a1 * 2^(hw) + a0 and b likewise, and uses
+// a * b = z2 * 2^(2hw) + (z2 + z0 - (a0 - a1)(b0 - b1)) * 2^(hw) + z0
+// requires alen >= blen > h
+static void mulKaratsuba(
+        size_t alen, const WordType* adata,
+        size_t blen, const WordType* bdata,
+        WordType* buffer, WordType* scratch) {
+    size_t len = alen + blen;
+    size_t h = (alen + 1) / 2;
+    size_t a1len = alen - h;
+    size_t b1len = blen - h;
+    // layout: |a0 - a1|, |b0 - b1|, one spare word, then their product.
+    // the first 2h + 1 words are later reused for the middle term
+    WordType* da = scratch;
+    WordType* db = scratch + h;
+    WordType* t = scratch + 2 * h + 1;
+    WordType* next = t + 2 * h;
+    int negative = absDiff(h, adata, a1len, adata + h, da)
+        ^ absDiff(h, bdata, b1len, bdata + h, db);
+    // z0 and z2 go straight to where they belong in the product
+    mulJob z0, z2;
+    forkProduct(&z0, h, adata, h, bdata, buffer, next);
+    forkProduct(&z2, a1len, adata + h, b1len, bdata + h, buffer + 2 * h, next);
+    mulUnsigned(h, da, h, db, t, next);
+    joinProduct(&z2);
+    joinProduct(&z0);
+    // middle term
+    WordType* mid = scratch;
+    size_t z2len = a1len + b1len;
+    WordType carry = addRows(z2len, buffer, buffer + 2 * h, mid);
+    mid[2 * h] = addWordRow(2 * h - z2len, buffer + z2len, carry, mid + z2len);
+    if(negative) {
+        mid[2 * h] += addRows(2 * h, mid, t, mid);
+    } else {
+        mid[2 * h] -= subRows(2 * h, mid, t, mid);
+    }
+    addAt(len, buffer, h, 2 * h + 1, mid);
+}
+
+// finishes a Toom-3 product from its point values. v0 and vinf are already
+// in place in `buffer`, which is zero between them, and v1, vm1 and v2 are
+// two's complement buffers of 2k + 2 words
+static void interpolateToom3(
+        size_t len, WordType* buffer, size_t k,
+        WordType* v1, WordType* vm1, WordType* v2, size_t vinfLen) {
+    size_t m = 2 * k + 2;
+    const WordType* v0 = buffer;
+    const WordType* vinf = buffer + 4 * k;
+    // interpolate in two's complement. The coefficients of x, x^2 and x^3
+    // end up in vm1, v1 and v2
+    // r3 = (v2 - vm1) / 3
+    subRows(m, v2, vm1, v2);
+    divExactBy3(m, v2);
+    // r1 = (v1 - vm1) / 2
+    subRows(m, v1, vm1, vm1);
+    divExactBy2(m, vm1);
+    // r2 = v1 - v0
+    subFrom(m, v1, 2 * k, v0);
+    // r3 = (r3 - r2) / 2 - 2vinf
+    subRows(m, v2, v1, v2);
+    divExactBy2(m, v2);
+    subFrom(m, v2, vinfLen, vinf);
+    subFrom(m, v2, vinfLen, vinf);
+    // r2 = r2 - r1 - vinf
+    subRows(m, v1, vm1, v1);
+    subFrom(m, v1, vinfLen, vinf);
+    // r1 = r1 - r3
+    subRows(m, vm1, v2, vm1);
+    addAt(len, buffer, k, m, vm1);
+    addAt(len, buffer, 2 * k, m, v1);
+    addAt(len, buffer, 3 * k, m, v2);
+}
+
+// splits both operands into three pieces of k words, treats them as
+// polynomials in x = 2^(kw), and multiplies them by evaluating at
+// 0, 1, -1, 2 and infinity. requires alen >= blen > 2k
+static void mulToom3(
+        size_t alen, const WordType* adata,
+        size_t blen, const WordType* bdata,
+        WordType* buffer, WordType* scratch) {
+    size_t len = alen + blen;
+    size_t k = (alen + 2) / 3;
+    size_t a2len = alen - 2 * k;
+    size_t b2len = blen - 2 * k;
+    size_t vinfLen = a2len + b2len;
+    // every point value and interpolated coefficient fits in m signed words
+    size_t m = 2 * k + 2;
+    WordType* v1 = scratch;
+    WordType* vm1 = v1 + m;
+    WordType* v2 = vm1 + m;
+    WordType* ea = v2 + m;
+    WordType* eb = ea + k + 1;
+    WordType* next = eb + k + 1;
+    const WordType* a1 = adata + k;
+    const WordType* a2 = adata + 2 * k;
+    const WordType* b1 = bdata + k;
+    const WordType* b2 = bdata + 2 * k;
+    WordType carry;
+    // v0 and vinf go straight to where they belong in the product. The
+    // evaluated operands are reused for each point, so every product but
+    // the last is done or has copies of its own before the next point
+    mulJob j0, jinf, j1, jm1;
+    forkProduct(&j0, k, adata, k, bdata, buffer, next);
+    forkProduct(&jinf, a2len, a2, b2len, b2, buffer + 4 * k, next);
+    // v1 = (a0 + a1 + a2)(b0 + b1 + b2)
+    ea[k] = addRows(k, adata, a1, ea);
+    carry = addRows(a2len, ea, a2, ea);
+    ea[k] += addWordRow(k - a2len, ea + a2len, carry, ea + a2len);
+    eb[k] = addRows(k, bdata, b1, eb);
+    carry = addRows(b2len, eb, b2, eb);
+    eb[k] += addWordRow(k - b2len, eb + b2len, carry, eb + b2len);
+    forkProduct(&j1, k + 1, ea, k + 1, eb, v1, next);
+    // vm1 = (a0 - a1 + a2)(b0 - b1 + b2)
+    carry = addRows(a2len, adata, a2, ea);
+    ea[k] = addWordRow(k - a2len, adata + a2len, carry, ea + a2len);
+    int negative = absDiff(k + 1, ea, k, a1, ea);
+    carry = addRows(b2len, bdata, b2, eb);
+    eb[k] = addWordRow(k - b2len, bdata + b2len, carry, eb + b2len);
+    negative ^= absDiff(k + 1, eb, k, b1, eb);
+    forkProduct(&jm1, k + 1, ea, k + 1, eb, vm1, next);
+    // v2 = (a0 + 2a1 + 4a2)(b0 + 2b1 + 4b2)
+    memcpy(ea, adata, k * sizeof(WordType));
+    ea[k] = addMulRow(k, a1, 2, ea);
+    carry = addMulRow(a2len, a2, 4, ea);
+    ea[k] += addWordRow(k - a2len, ea + a2len, carry, ea + a2len);
+    memcpy(eb, bdata, k * sizeof(WordType));
+    eb[k] = addMulRow(k, b1, 2, eb);
+    carry = addMulRow(b2len, b2, 4, eb);
+    eb[k] += addWordRow(k - b2len, eb + b2len, carry, eb + b2len);
+    mulUnsigned(k + 1, ea, k + 1, eb, v2, next);
+    joinProduct(&jm1);
+    joinProduct(&j1);
+    joinProduct(&jinf);
+    joinProduct(&j0);
+    if(negative) {
+        for(size_t i = 0; i < m; i++) {
+            vm1[i] = ~vm1[i];
+        }
+        addWordRow(m, vm1, 1, vm1);
+    }
+    memset(buffer + 2 * k, 0, 2 * k * sizeof(WordType));
+    interpolateToom3(len, buffer, k, v1, vm1, v2, vinfLen);
+}
+
+// squaring version of mulKaratsuba, where the middle term is
+// z2 + z0 - (a0 - a1)^2 and never needs a sign. requires n > h
+static void sqrKaratsuba(size_t n, const WordType* a, WordType* buffer, WordType* scratch) {
+    size_t h = (n + 1) / 2;
+    size_t a1len = n - h;
+    // same layout as mulKaratsuba
+    WordType* da = scratch;
+    WordType* t = scratch + 2 * h + 1;
+    WordType* next = t + 2 * h;
+    absDiff(h, a, a1len, a + h, da);
+    mulJob z0, z2;
+    forkProduct(&z0, h, a, h, NULL, buffer, next);
+    forkProduct(&z2, a1len, a + h, a1len, NULL, buffer + 2 * h, next);
+    sqrUnsigned(h, da, t, next);
+    joinProduct(&z2);
+    joinProduct(&z0);
+    WordType* mid = scratch;
+    size_t z2len = 2 * a1len;
+    WordType carry = addRows(z2len, buffer, buffer + 2 * h, mid);
+    mid[2 * h] = addWordRow(2 * h - z2len, buffer + z2len, carry, mid + z2len);
+    mid[2 * h] -= subRows(2 * h, mid, t, mid);
+    addAt(2 * n, buffer, h, 2 * h + 1, mid);
+}
+
+// squaring version of mulToom3. The point values are squares, so vm1 needs
+// no sign. requires n > 2k
+static void sqrToom3(size_t n, const WordType* a, WordType* buffer, WordType* scratch) {
+    size_t k = (n + 2) / 3;
+    size_t a2len = n - 2 * k;
+    size_t m = 2 * k + 2;
+    WordType* v1 = scratch;
+    WordType* vm1 = v1 + m;
+    WordType* v2 = vm1 + m;
+    WordType* ea = v2 + m;
+    WordType* next = ea + k + 1;
+    const WordType* a1 = a + k;
+    const WordType* a2 = a + 2 * k;
+    WordType carry;
+    // v0 and vinf go straight to where they belong in the product
+    mulJob j0, jinf, j1, jm1;
+    forkProduct(&j0, k, a, k, NULL, buffer, next);
+    forkProduct(&jinf, a2len, a2, a2len, NULL, buffer + 4 * k, next);
+    // v1 = (a0 + a1 + a2)^2
+    ea[k] = addRows(k, a, a1, ea);
+    carry = addRows(a2len, ea, a2, ea);
+    ea[k] += addWordRow(k - a2len, ea + a2len, carry, ea + a2len);
+    forkProduct(&j1, k + 1, ea, k + 1, NULL, v1, next);
+    // vm1 = (a0 - a1 + a2)^2
+    carry = addRows(a2len, a, a2, ea);
+    ea[k] = addWordRow(k - a2len, a + a2len, carry, ea + a2len);
+    absDiff(k + 1, ea, k, a1, ea);
+    forkProduct(&jm1, k + 1, ea, k + 1, NULL, vm1, next);
+    // v2 = (a0 + 2a1 + 4a2)^2
+    memcpy(ea, a, k * sizeof(WordType));
+    ea[k] = addMulRow(k, a1, 2, ea);
+    carry = addMulRow(a2len, a2, 4, ea);
+    ea[k] += addWordRow(k - a2len, ea + a2len, carry, ea + a2len);
+    sqrUnsigned(k + 1, ea, v2, next);
+    joinProduct(&jm1);
+    joinProduct(&j1);
+    joinProduct(&jinf);
+    joinProduct(&j0);
+    memset(buffer + 2 * k, 0, 2 * k * sizeof(WordType));
+    interpolateToom3(2 * n, buffer, k, v1, vm1, v2, 2 * a2len);
+}
+
+// multiplies a by b in pieces of blen words when a is much longer than b
+static void mulUnbalanced(
+        size_t alen, const WordType* adata,
+        size_t blen, const WordType* bdata,
+        WordType* buffer, WordType* scratch) {
+    WordType* t = scratch;
+    WordType* next = scratch + 2 * blen;
+    mulUnsigned(blen, adata, blen, bdata, buffer, next);
+    for(size_t i = blen; i < alen; i += blen) {
+        size_t n = min(blen, alen - i);
+        mulUnsigned(n, adata + i, blen, bdata, t, next);
+        // buffer[i..i + blen) already holds the top of the last piece
+        WordType carry = addRows(blen, buffer + i, t, buffer + i);
+        addWordRow(n, t + blen, carry, buffer + i + blen);
+    }
+}
+
+// stores the full unsigned product of a and b in buffer[0..alen + blen).
+// `buffer` may not overlap either argument or `scratch`, which must hold
+// mulScratchLen(max(alen, blen)) words
+void mulUnsigned(
+        size_t alen, const WordType* adata,
+        size_t blen, const WordType* bdata,
+        WordType* buffer, WordType* scratch) {
+    if(alen < blen) {
+        const WordType* tmp = adata;
+        adata = bdata;
+        bdata = tmp;
+        size_t tmplen = alen;
+        alen = blen;
+        blen = tmplen;
+    }
+    if(blen < YABI_KARATSUBA_THRESHOLD) {
+        mulBasecase(alen, adata, blen, bdata, alen + blen, buffer);
+    } else if(blen >= YABI_NTT_THRESHOLD && nttFits(alen, blen)) {
+        mulNTT(alen, adata, blen, bdata, buffer, scratch);
+    } else if(blen >= YABI_TOOM3_THRESHOLD && blen > 2 * ((alen + 2) / 3)) {
+        mulToom3(alen, adata, blen, bdata, buffer, scratch);
+    } else if(blen > (alen + 1) / 2) {
+        mulKaratsuba(alen, adata, blen, bdata, buffer, scratch);
+    } else {
+        mulUnbalanced(alen, adata, blen, bdata, buffer, scratch);
+    }
+}
+
+// stores the full square of the unsigned `a` in buffer[0..2n). Same
+// requirements as mulUnsigned
+void sqrUnsigned(size_t n, const WordType* a, WordType* buffer, WordType* scratch) {
+    if(n < YABI_SQR_KARATSUBA_THRESHOLD) {
+        sqrBasecase(n, a, 2 * n, buffer);
+    } else if(n >= YABI_NTT_THRESHOLD && nttFits(n, n)) {
+        mulNTT(n, a, n, a, buffer, scratch);
+    } else if(n >= YABI_TOOM3_THRESHOLD) {
+        sqrToom3(n, a, buffer, scratch);
+    } else {
+        sqrKaratsuba(n, a, buffer, scratch);
+    }
+}
+
+// fills buffer[stop..len) with the sign of the product in buffer[0..stop),
+// and returns its minimal length
+static size_t finishProduct(size_t stop, size_t len, WordType* buffer) {
     WordType sign = -HI_BIT(buffer[stop - 1]);
     memset(buffer + stop, sign, (len - stop) * sizeof(WordType));
     // shrink away extra sign words
@@ -76,8 +482,136 @@ size_t mulBuffers(
     return stop;
 }
 
+// two's complement squaring for buffers
+static size_t sqrBuffers(size_t alen, const WordType* adata, size_t len, WordType* buffer, yabi_workspace_t* ws) {
+    // ignore redundant sign words, they only make more work
+    while(alen > 1 && adata[alen - 1] == (WordType)-HI_BIT(adata[alen - 2])) {
+        alen--;
+    }
+    // the square always fits in 2 * alen words
+    size_t stop = min(2 * alen, len);
+    int negative = HI_BIT(adata[alen - 1]);
+    // squaring the magnitude leaves no sign to correct. Words of it above
+    // `stop` cannot affect the result
+    size_t n = min(alen, stop);
+    int basecase = n < YABI_SQR_KARATSUBA_THRESHOLD;
+    size_t prodLen = !basecase && stop < 2 * n ? 2 * n : 0;
+    size_t scratchLen = basecase ? 0 : mulScratchLen(n);
+    // a negative argument is negated into a copy, and so is one that
+    // `buffer` refers to, since the square is written before it is read
+    size_t copyLen = (negative || buffer == adata) ? n : 0;
+    WordType* work = takeScratch(ws, copyLen + prodLen + scratchLen);
+    if(negative) {
+        for(size_t i = 0; i < n; i++) {
+            work[i] = ~adata[i];
+        }
+        addWordRow(n, work, 1, work);
+        adata = work;
+    } else if(copyLen) {
+        memcpy(work, adata, n * sizeof(WordType));
+        adata = work;
+    }
+    if(basecase) {
+        sqrBasecase(n, adata, stop, buffer);
+    } else if(prodLen) {
+        WordType* prod = work + copyLen;
+        sqrUnsigned(n, adata, prod, prod + prodLen);
+        memcpy(buffer, prod, stop * sizeof(WordType));
+    } else {
+        sqrUnsigned(n, adata, buffer, work + copyLen);
+    }
+    dropScratch(ws, work);
+    return finishProduct(stop, len, buffer);
+}
+
+// two's complement multiplication for buffers
+size_t mulBuffers(
+        size_t alen, const WordType* adata,
+        size_t blen, const WordType* bdata,
+        size_t len, WordType* buffer, yabi_workspace_t* ws) {
+    if(adata == bdata && alen == blen) {
+        return sqrBuffers(alen, adata, len, buffer, ws);
+    }
+    // ignore redundant sign words, they only make more work
+    while(alen > 1 && adata[alen - 1] == (WordType)-HI_BIT(adata[alen - 2])) {
+        alen--;
+    }
+    while(blen > 1 && bdata[blen - 1] == (WordType)-HI_BIT(bdata[blen - 2])) {
+        blen--;
+    }
+    // the product always fits in alen + blen words
+    size_t stop = min(alen + blen, len);
+    int asign = HI_BIT(adata[alen - 1]);
+    int bsign = HI_BIT(bdata[blen - 1]);
+    // words of the arguments above `stop` cannot affect the result
+    alen = min(alen, stop);
+    blen = min(blen, stop);
+    // subquadratic multiplication needs scratch space, and a full size
+    // product when the result is truncated
+    int basecase = min(alen, blen) < YABI_KARATSUBA_THRESHOLD;
+    size_t prodLen = !basecase && stop < alen + blen ? alen + blen : 0;
+    size_t scratchLen = basecase ? 0 : mulScratchLen(max(alen, blen));
+    // the product is written before the arguments are fully read, so copy
+    // whichever of them `buffer` refers to
+    size_t copyLen = buffer == adata ? alen : buffer == bdata ? blen : 0;
+    WordType* work = takeScratch(ws, copyLen + prodLen + scratchLen);
+    if(buffer == adata) {
+        memcpy(work, adata, alen * sizeof(WordType));
+        adata = work;
+    } else if(buffer == bdata) {
+        memcpy(work, bdata, blen * sizeof(WordType));
+        bdata = work;
+    }
+    // multiply as if both arguments were unsigned, then correct for the sign.
+    // a negative `a` was read as a + 2^(alen*w), which added b * 2^(alen*w)
+    // to the product, and likewise for `b`. The cross term 2^((alen+blen)*w)
+    // falls outside the product
+    if(basecase) {
+        mulBasecase(alen, adata, blen, bdata, stop, buffer);
+    } else if(prodLen) {
+        WordType* prod = work + copyLen;
+        mulUnsigned(alen, adata, blen, bdata, prod, prod + prodLen);
+        memcpy(buffer, prod, stop * sizeof(WordType));
+    } else {
+        mulUnsigned(alen, adata, blen, bdata, buffer, work + copyLen);
+    }
+    if(asign && alen < stop) {
+        size_t n = min(blen, stop - alen);
+        WordType borrow = subRows(n, buffer + alen, bdata, buffer + alen);
+        subWordRow(stop - alen - n, buffer + alen + n, borrow, buffer + alen + n);
+    }
+    if(bsign && blen < stop) {
+        size_t n = min(alen, stop - blen);
+        WordType borrow = subRows(n, buffer + blen, adata, buffer + blen);
+        subWordRow(stop - blen - n, buffer + blen + n, borrow, buffer + blen + n);
+    }
+    dropScratch(ws, work);
+    return finishProduct(stop, len, buffer);
+}
+
+// the most mulBuffers takes for a copy of an operand, a full product and
+// scratch for subquadratic multiplication
+size_t yabi_mul_scratch(size_t alen, size_t blen) {
+    size_t n = max(alen, blen);
+    if(min(alen, blen) < YABI_KARATSUBA_THRESHOLD) {
+        return n;
+    }
+    return n + alen + blen + mulScratchLen(n);
+}
+
+size_t yabi_sqr_scratch(size_t alen) {
+    if(alen < YABI_SQR_KARATSUBA_THRESHOLD) {
+        return alen;
+    }
+    return 3 * alen + mulScratchLen(alen);
+}
+
 size_t yabi_mulToBuf(const BigInt* a, const BigInt* b, size_t len, WordType* buffer) {
-    return mulBuffers(a->len, a->data, b->len, b->data, len, buffer);
+    return mulBuffers(a->len, a->data, b->len, b->data, len, buffer, NULL);
+}
+
+size_t yabi_mulToBufWs(const BigInt* a, const BigInt* b, size_t len, WordType* buffer, yabi_workspace_t* ws) {
+    return mulBuffers(a->len, a->data, b->len, b->data, len, buffer, ws);
 }
 
 BigInt* yabi_mul(const BigInt* a, const BigInt* b) {
@@ -85,9 +619,251 @@ BigInt* yabi_mul(const BigInt* a, const BigInt* b) {
     BigInt* res = YABI_NEW_BIGINT(len);
     res->refCount = 0;
     res->len = len;
-    len = mulBuffers(a->len, a->data, b->len, b->data, len, res->data);
+    res->cap = res->len;
+    len = mulBuffers(a->len, a->data, b->len, b->data, len, res->data, NULL);
+    if(len != res->len) {
+        RESIZE_BIGINT(res, len);
+    }
+    return res;
+}
+
+size_t yabi_sqrToBuf(const BigInt* a, size_t len, WordType* buffer) {
+    return sqrBuffers(a->len, a->data, len, buffer, NULL);
+}
+
+size_t yabi_sqrToBufWs(const BigInt* a, size_t len, WordType* buffer, yabi_workspace_t* ws) {
+    return sqrBuffers(a->len, a->data, len, buffer, ws);
+}
+
+BigInt* yabi_sqr(const BigInt* a) {
+    size_t len = 2 * a->len;
+    BigInt* res = YABI_NEW_BIGINT(len);
+    res->refCount = 0;
+    res->len = len;
+    res->cap = res->len;
+    len = sqrBuffers(a->len, a->data, len, res->data, NULL);
     if(len != res->len) {
-        YABI_RESIZE_BIGINT(res, len);
+        RESIZE_BIGINT(res, len);
+    }
+    return res;
+}
+
+// multiplies a by the native integer with magnitude words b, a word of a at
+// a time. The magnitude of a and the sign of the product are applied on the
+// fly, and the pending high words stay in `acc`, so `buffer` may be `a`
+static size_t mulNative(const BigInt* a, const WordType* b, int bnegative, size_t len, WordType* buffer) {
+    size_t alen = a->len;
+    const WordType* adata = a->data;
+    // ignore redundant sign words, they only make more work
+    while(alen > 1 && adata[alen - 1] == (WordType)-HI_BIT(adata[alen - 2])) {
+        alen--;
+    }
+    int anegative = HI_BIT(adata[alen - 1]);
+    WordType aflip = (WordType)-anegative;
+    WordType pflip = (WordType)-(anegative ^ bnegative);
+    // |a| = (a ^ aflip) + acarry, and the same goes for the product
+    WordType acarry = (WordType)anegative;
+    WordType pcarry = pflip & 1;
+    // |a| fits in alen words, so the product fits in alen + NATIVE_WORDS
+    size_t stop = min(alen + NATIVE_WORDS, len);
+    WordType acc[NATIVE_WORDS] = { 0 };
+    for(size_t i = 0; i < stop; i++) {
+        WordType ai = 0;
+        if(i < alen) {
+            acarry = addAndCarry(adata[i] ^ aflip, acarry, 0, &ai);
+        }
+        // acc += ai * b, and the low word is done
+        WordType carry = 0;
+        for(int j = 0; j < NATIVE_WORDS; j++) {
+            WordType lo = acc[j];
+            WordType hi = mulAndCarry(ai, b[j], &lo);
+            hi += addAndCarry(lo, carry, 0, &acc[j]);
+            carry = hi;
+        }
+        pcarry = addAndCarry(acc[0] ^ pflip, pcarry, 0, &buffer[i]);
+        for(int j = 1; j < NATIVE_WORDS; j++) {
+            acc[j - 1] = acc[j];
+        }
+        acc[NATIVE_WORDS - 1] = carry;
+    }
+    return finishProduct(stop, len, buffer);
+}
+
+static BigInt* mulNativeAlloc(const BigInt* a, const WordType* b, int bnegative) {
+    size_t len = a->len + NATIVE_WORDS;
+    BigInt* res = YABI_NEW_BIGINT(len);
+    res->refCount = 0;
+    res->len = len;
+    res->cap = res->len;
+    size_t newLen = mulNative(a, b, bnegative, len, res->data);
+    if(newLen != len) {
+        RESIZE_BIGINT(res, newLen);
     }
     return res;
 }
+
+size_t yabi_mul_siToBuf(const BigInt* a, int64_t b, size_t len, WordType* buffer) {
+    WordType words[NATIVE_WORDS];
+    nativeWords(b < 0 ? 0 - (uint64_t)b : (uint64_t)b, words);
+    return mulNative(a, words, b < 0, len, buffer);
+}
+
+size_t yabi_mul_uiToBuf(const BigInt* a, uint64_t b, size_t len, WordType* buffer) {
+    WordType words[NATIVE_WORDS];
+    nativeWords(b, words);
+    return mulNative(a, words, 0, len, buffer);
+}
+
+BigInt* yabi_mul_si(const BigInt* a, int64_t b) {
+    WordType words[NATIVE_WORDS];
+    nativeWords(b < 0 ? 0 - (uint64_t)b : (uint64_t)b, words);
+    return mulNativeAlloc(a, words, b < 0);
+}
+
+BigInt* yabi_mul_ui(const BigInt* a, uint64_t b) {
+    WordType words[NATIVE_WORDS];
+    nativeWords(b, words);
+    return mulNativeAlloc(a, words, 0);
+}
+
+BigInt* yabi_mul_into(BigInt** dst, const BigInt* a, const BigInt* b) {
+    size_t len = a->len + b->len;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, &b, &shared);
+    res->len = mulBuffers(a->len, a->data, b->len, b->data, len, res->data, NULL);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_sqr_into(BigInt** dst, const BigInt* a) {
+    size_t len = 2 * a->len;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, NULL, &shared);
+    res->len = sqrBuffers(a->len, a->data, len, res->data, NULL);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_mul_si_into(BigInt** dst, const BigInt* a, int64_t b) {
+    size_t len = a->len + NATIVE_WORDS;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, NULL, &shared);
+    res->len = yabi_mul_siToBuf(a, b, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_mul_ui_into(BigInt** dst, const BigInt* a, uint64_t b) {
+    size_t len = a->len + NATIVE_WORDS;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, NULL, &shared);
+    res->len = yabi_mul_uiToBuf(a, b, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+// buffer[0..len) += a * b, or -= when `subtract`, for signed a and b with
+// alen + blen < len. Every row of the product goes straight into `buffer`,
+// which may not overlap either argument. For the unsigned readings A and B
+// the product is A * B, less B * 2^(alen*w) if a is negative and less
+// A * 2^(blen*w) if b is, plus 2^((alen+blen)*w) if both are
+static void addmulBasecase(
+        size_t alen, const WordType* adata,
+        size_t blen, const WordType* bdata,
+        int subtract, size_t len, WordType* buffer) {
+    int asign = HI_BIT(adata[alen - 1]);
+    int bsign = HI_BIT(bdata[blen - 1]);
+    // one row per word of the shorter argument
+    if(alen < blen) {
+        const WordType* tmp = adata;
+        adata = bdata;
+        bdata = tmp;
+        size_t tmplen = alen;
+        alen = blen;
+        blen = tmplen;
+        int tmpsign = asign;
+        asign = bsign;
+        bsign = tmpsign;
+    }
+    if(subtract) {
+        for(size_t i = 0; i < blen; i++) {
+            WordType borrow = subMulRow(alen, adata, bdata[i], buffer + i);
+            subWordRow(len - i - alen, buffer + i + alen, borrow, buffer + i + alen);
+        }
+        if(asign) {
+            addAt(len, buffer, alen, blen, bdata);
+        }
+        if(bsign) {
+            addAt(len, buffer, blen, alen, adata);
+        }
+        if(asign && bsign) {
+            subWordRow(len - alen - blen, buffer + alen + blen, 1, buffer + alen + blen);
+        }
+    } else {
+        for(size_t i = 0; i < blen; i++) {
+            WordType carry = addMulRow(alen, adata, bdata[i], buffer + i);
+            addWordRow(len - i - alen, buffer + i + alen, carry, buffer + i + alen);
+        }
+        if(asign) {
+            subFrom(len - alen, buffer + alen, blen, bdata);
+        }
+        if(bsign) {
+            subFrom(len - blen, buffer + blen, alen, adata);
+        }
+        if(asign && bsign) {
+            addWordRow(len - alen - blen, buffer + alen + blen, 1, buffer + alen + blen);
+        }
+    }
+}
+
+static BigInt* addmulInto(BigInt** dst, const BigInt* a, const BigInt* b, int subtract) {
+    size_t alen = a->len;
+    size_t blen = b->len;
+    // ignore redundant sign words, they only make more work
+    while(alen > 1 && a->data[alen - 1] == (WordType)-HI_BIT(a->data[alen - 2])) {
+        alen--;
+    }
+    while(blen > 1 && b->data[blen - 1] == (WordType)-HI_BIT(b->data[blen - 2])) {
+        blen--;
+    }
+    const BigInt* self = *dst;
+    size_t len = max(self ? self->len : 1, alen + blen) + 1;
+    // large products are computed separately, and so are ones that would
+    // overwrite their own arguments
+    int fused = min(alen, blen) < YABI_KARATSUBA_THRESHOLD && a != self && b != self;
+    WordType* prod = NULL;
+    size_t prodLen = 0;
+    if(!fused) {
+        prod = YABI_MALLOC((alen + blen) * sizeof(WordType));
+        prodLen = mulBuffers(alen, a->data, blen, b->data, alen + blen, prod, NULL);
+    }
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &self, NULL, &shared);
+    // when *dst has other owners the sum goes into a fresh BigInt, and
+    // `self` still points at the old value
+    if(!self) {
+        self = res;
+    }
+    if(fused) {
+        WordType sign = -HI_BIT(self->data[self->len - 1]);
+        if(self != res) {
+            memcpy(res->data, self->data, self->len * sizeof(WordType));
+        }
+        memset(res->data + self->len, sign, (len - self->len) * sizeof(WordType));
+        addmulBasecase(alen, a->data, blen, b->data, subtract, len, res->data);
+        res->len = finishProduct(len, len, res->data);
+    } else {
+        res->len = addBuffers(self->len, self->data, prodLen, prod, subtract, len, res->data);
+        YABI_FREE(prod);
+    }
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_addmul(BigInt** dst, const BigInt* a, const BigInt* b) {
+    return addmulInto(dst, a, b, 0);
+}
+
+BigInt* yabi_submul(BigInt** dst, const BigInt* a, const BigInt* b) {
+    return addmulInto(dst, a, b, 1);
+}
@@ -0,0 +1,411 @@
+#include "bigint_internal.h"
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+/*
+ * Multiplication by number theoretic transform. The operands are cut into
+ * 32 bit coefficients and convolved modulo three primes below 2^31, whose
+ * product is large enough to hold every coefficient of the convolution
+ * exactly. The primes are reassembled with the Chinese remainder theorem.
+ * Arithmetic modulo each prime is done in Montgomery form with R = 2^32.
+ */
+
+// every prime supports transforms of up to 2^NTT_MAX_LOG points
+#define NTT_MAX_LOG 24
+#define NTT_PRIMES 3
+
+typedef struct nttPrime {
+    uint32_t p;
+    // -p^-1 mod 2^32
+    uint32_t pinv;
+    // a primitive root modulo p
+    uint32_t g;
+} nttPrime;
+
+static const nttPrime primes[NTT_PRIMES] = {
+    { 2013265921u, 2013265919u, 31 },   // 15 * 2^27 + 1
+    { 469762049u, 469762047u, 3 },      // 7 * 2^26 + 1
+    { 754974721u, 754974719u, 11 },     // 45 * 2^24 + 1
+};
+
+// Montgomery reduction of t < p * 2^32
+static inline uint32_t redc(uint64_t t, const nttPrime* pr) {
+    uint32_t m = (uint32_t)t * pr->pinv;
+    uint32_t r = (uint32_t)((t + (uint64_t)m * pr->p) >> 32);
+    return r >= pr->p ? r - pr->p : r;
+}
+
+static inline uint32_t mulMont(uint32_t a, uint32_t b, const nttPrime* pr) {
+    return redc((uint64_t)a * b, pr);
+}
+
+static inline uint32_t addMod(uint32_t a, uint32_t b, uint32_t p) {
+    uint32_t r = a + b;
+    return r >= p ? r - p : r;
+}
+
+static inline uint32_t subMod(uint32_t a, uint32_t b, uint32_t p) {
+    return a >= b ? a - b : a + p - b;
+}
+
+// plain modular exponentiation, only used to set up tables
+static uint32_t powMod(uint32_t b, uint64_t e, uint32_t p) {
+    uint64_t r = 1;
+    uint64_t x = b;
+    while(e) {
+        if(e & 1) {
+            r = r * x % p;
+        }
+        x = x * x % p;
+        e >>= 1;
+    }
+    return (uint32_t)r;
+}
+
+// number of 32 bit coefficients in `len` words
+static size_t chunkCount(size_t len) {
+    return (len * YABI_WORD_BIT_SIZE + 31) / 32;
+}
+
+static uint32_t getChunk(size_t len, const WordType* a, size_t i) {
+#if YABI_WORD_BIT_SIZE == 64
+    (void)len;
+    return (uint32_t)(a[i >> 1] >> ((i & 1) * 32));
+#elif YABI_WORD_BIT_SIZE == 32
+    (void)len;
+    return a[i];
+#else
+    uint32_t c = 0;
+    for(size_t j = 0; j < 32 / YABI_WORD_BIT_SIZE; j++) {
+        size_t idx = i * (32 / YABI_WORD_BIT_SIZE) + j;
+        if(idx < len) {
+            c |= (uint32_t)a[idx] << (j * YABI_WORD_BIT_SIZE);
+        }
+    }
+    return c;
+#endif
+}
+
+static void putChunk(size_t len, WordType* a, size_t i, uint32_t c) {
+#if YABI_WORD_BIT_SIZE == 64
+    (void)len;
+    a[i >> 1] |= (WordType)c << ((i & 1) * 32);
+#elif YABI_WORD_BIT_SIZE == 32
+    (void)len;
+    a[i] = c;
+#else
+    for(size_t j = 0; j < 32 / YABI_WORD_BIT_SIZE; j++) {
+        size_t idx = i * (32 / YABI_WORD_BIT_SIZE) + j;
+        if(idx < len) {
+            a[idx] = (WordType)(c >> (j * YABI_WORD_BIT_SIZE));
+        }
+    }
+#endif
+}
+
+// smallest power of two that can hold the product of a and b
+static size_t transformLen(size_t alen, size_t blen) {
+    size_t n = chunkCount(alen) + chunkCount(blen);
+    size_t len = 1;
+    while(len < n) {
+        len <<= 1;
+    }
+    return len;
+}
+
+int nttFits(size_t alen, size_t blen) {
+    return chunkCount(alen) + chunkCount(blen) <= ((size_t)1 << NTT_MAX_LOG);
+}
+
+size_t nttScratchLen(size_t alen, size_t blen) {
+    // six uint32_t arrays of the transform length, plus room for alignment
+    size_t bytes = 6 * transformLen(alen, blen) * sizeof(uint32_t) + sizeof(uint32_t);
+    return (bytes + sizeof(WordType) - 1) / sizeof(WordType);
+}
+
+// fills roots[h + j] with w^j for every level of a transform of n points,
+// where w is a primitive (2h)th root of unity, in Montgomery form. The
+// inverse roots are stored the same way
+static void makeRoots(size_t n, const nttPrime* pr, uint32_t* roots, uint32_t* iroots) {
+    uint64_t r2 = ((uint64_t)1 << 32) % pr->p;
+    for(size_t h = 1; h < n; h <<= 1) {
+        uint64_t w = powMod(pr->g, (pr->p - 1) / (2 * h), pr->p);
+        uint64_t iw = powMod((uint32_t)w, pr->p - 2, pr->p);
+        uint64_t x = r2;
+        uint64_t ix = r2;
+        for(size_t j = 0; j < h; j++) {
+            roots[h + j] = (uint32_t)x;
+            iroots[h + j] = (uint32_t)ix;
+            x = x * w % pr->p;
+            ix = ix * iw % pr->p;
+        }
+    }
+}
+
+// words that n points take up, for PARALLEL_WORTH
+#define POINT_WORDS(n) ((n) * sizeof(uint32_t) / sizeof(WordType))
+
+static void forward(size_t n, uint32_t* x, const uint32_t* roots, const nttPrime* pr);
+static void inverse(size_t n, uint32_t* x, const uint32_t* iroots, const nttPrime* pr);
+
+// half of a transform, which may be left to a task
+typedef struct transformJob {
+    size_t n;
+    uint32_t* x;
+    const uint32_t* roots;
+    const nttPrime* pr;
+    parTask task;
+} transformJob;
+
+static void runForward(void* arg) {
+    transformJob* j = arg;
+    forward(j->n, j->x, j->roots, j->pr);
+}
+
+static void runInverse(void* arg) {
+    transformJob* j = arg;
+    inverse(j->n, j->x, j->roots, j->pr);
+}
+
+// decimation in frequency: natural order in, bit reversed order out. After
+// the first level the two halves are transforms of their own, which large
+// transforms do in parallel
+static void forward(size_t n, uint32_t* x, const uint32_t* roots, const nttPrime* pr) {
+    uint32_t p = pr->p;
+    for(size_t h = n >> 1; h > 0; h >>= 1) {
+        for(size_t blk = 0; blk < n; blk += 2 * h) {
+            uint32_t* lo = x + blk;
+            uint32_t* hi = lo + h;
+            for(size_t j = 0; j < h; j++) {
+                uint32_t u = lo[j];
+                uint32_t v = hi[j];
+                lo[j] = addMod(u, v, p);
+                hi[j] = mulMont(subMod(u, v, p), roots[h + j], pr);
+            }
+        }
+        if(h == n >> 1 && h > 1 && PARALLEL_WORTH(POINT_WORDS(h))) {
+            transformJob lo;
+            lo.n = h;
+            lo.x = x;
+            lo.roots = roots;
+            lo.pr = pr;
+            forkTask(&lo.task, runForward, &lo);
+            forward(h, x + h, roots, pr);
+            joinTask(&lo.task);
+            return;
+        }
+    }
+}
+
+// decimation in time: bit reversed order in, natural order out. Unscaled.
+// Everything but the last level is two transforms of half the size
+static void inverse(size_t n, uint32_t* x, const uint32_t* iroots, const nttPrime* pr) {
+    uint32_t p = pr->p;
+    size_t h = 1;
+    if(n > 2 && PARALLEL_WORTH(POINT_WORDS(n / 2))) {
+        transformJob lo;
+        lo.n = n / 2;
+        lo.x = x;
+        lo.roots = iroots;
+        lo.pr = pr;
+        forkTask(&lo.task, runInverse, &lo);
+        inverse(n / 2, x + n / 2, iroots, pr);
+        joinTask(&lo.task);
+        h = n / 2;
+    }
+    for(; h < n; h <<= 1) {
+        for(size_t blk = 0; blk < n; blk += 2 * h) {
+            uint32_t* lo = x + blk;
+            uint32_t* hi = lo + h;
+            for(size_t j = 0; j < h; j++) {
+                uint32_t u = lo[j];
+                uint32_t v = mulMont(hi[j], iroots[h + j], pr);
+                lo[j] = addMod(u, v, p);
+                hi[j] = subMod(u, v, p);
+            }
+        }
+    }
+}
+
+static void load(size_t n, uint32_t* x, size_t len, const WordType* a, uint32_t p) {
+    size_t chunks = chunkCount(len);
+    for(size_t i = 0; i < chunks; i++) {
+        x[i] = getChunk(len, a, i) % p;
+    }
+    memset(x + chunks, 0, (n - chunks) * sizeof(uint32_t));
+}
+
+// the transform of one operand, which may be left to a task
+typedef struct loadJob {
+    size_t n;
+    uint32_t* x;
+    size_t len;
+    const WordType* a;
+    const uint32_t* roots;
+    const nttPrime* pr;
+    parTask task;
+} loadJob;
+
+static void runLoad(void* arg) {
+    loadJob* j = arg;
+    load(j->n, j->x, j->len, j->a, j->pr->p);
+    forward(j->n, j->x, j->roots, j->pr);
+}
+
+// convolves a and b modulo one prime, leaving the result in fa. When a
+// and b are the same, their transform is only computed once
+static void convolve(
+        size_t n, const nttPrime* pr,
+        size_t alen, const WordType* adata,
+        size_t blen, const WordType* bdata,
+        uint32_t* fa, uint32_t* fb, uint32_t* roots, uint32_t* iroots) {
+    makeRoots(n, pr, roots, iroots);
+    if(adata == bdata && alen == blen) {
+        load(n, fa, alen, adata, pr->p);
+        forward(n, fa, roots, pr);
+        for(size_t i = 0; i < n; i++) {
+            fa[i] = mulMont(fa[i], fa[i], pr);
+        }
+    } else {
+        loadJob b;
+        b.n = n;
+        b.x = fb;
+        b.len = blen;
+        b.a = bdata;
+        b.roots = roots;
+        b.pr = pr;
+        int forked = PARALLEL_WORTH(POINT_WORDS(n));
+        if(forked) {
+            forkTask(&b.task, runLoad, &b);
+        } else {
+            runLoad(&b);
+        }
+        load(n, fa, alen, adata, pr->p);
+        forward(n, fa, roots, pr);
+        if(forked) {
+            joinTask(&b.task);
+        }
+        for(size_t i = 0; i < n; i++) {
+            fa[i] = mulMont(fa[i], fb[i], pr);
+        }
+    }
+    inverse(n, fa, iroots, pr);
+    // the pointwise products picked up a factor of R^-1, so scaling by
+    // n^-1 * R^2 in Montgomery form cancels it as well as dividing by n
+    uint64_t r2 = ((uint64_t)1 << 32) % pr->p;
+    r2 = r2 * r2 % pr->p;
+    uint32_t scale = (uint32_t)(powMod((uint32_t)n, pr->p - 2, pr->p) * r2 % pr->p);
+    for(size_t i = 0; i < n; i++) {
+        fa[i] = mulMont(fa[i], scale, pr);
+    }
+}
+
+// the convolution for one prime, which may be left to a task
+typedef struct convolveJob {
+    size_t n;
+    const nttPrime* pr;
+    size_t alen;
+    const WordType* adata;
+    size_t blen;
+    const WordType* bdata;
+    uint32_t* fa;
+    uint32_t* fb;
+    uint32_t* roots;
+    uint32_t* iroots;
+    // the transform and roots of a forked job
+    uint32_t* own;
+    parTask task;
+} convolveJob;
+
+static void runConvolve(void* arg) {
+    convolveJob* j = arg;
+    convolve(j->n, j->pr, j->alen, j->adata, j->blen, j->bdata, j->fa, j->fb, j->roots, j->iroots);
+}
+
+// starts the convolution for primes[i] into `fa`. It is forked with arrays
+// of its own when it is worth it and there is memory for them, and done at
+// once with `fb`, `roots` and `iroots` otherwise
+static void forkConvolve(
+        convolveJob* j, int i, size_t n,
+        size_t alen, const WordType* adata,
+        size_t blen, const WordType* bdata,
+        uint32_t* fa, uint32_t* fb, uint32_t* roots, uint32_t* iroots) {
+    j->n = n;
+    j->pr = &primes[i];
+    j->alen = alen;
+    j->adata = adata;
+    j->blen = blen;
+    j->bdata = bdata;
+    j->fa = fa;
+    j->fb = fb;
+    j->roots = roots;
+    j->iroots = iroots;
+    j->own = NULL;
+    if(PARALLEL_WORTH(POINT_WORDS(n))) {
+        j->own = YABI_MALLOC(3 * n * sizeof(uint32_t));
+    }
+    if(!j->own) {
+        runConvolve(j);
+        return;
+    }
+    j->fb = j->own;
+    j->roots = j->own + n;
+    j->iroots = j->own + 2 * n;
+    forkTask(&j->task, runConvolve, j);
+}
+
+static void joinConvolve(convolveJob* j) {
+    if(j->own) {
+        joinTask(&j->task);
+        YABI_FREE(j->own);
+    }
+}
+
+void mulNTT(
+        size_t alen, const WordType* adata,
+        size_t blen, const WordType* bdata,
+        WordType* buffer, WordType* scratch) {
+    assert(nttFits(alen, blen));
+    size_t n = transformLen(alen, blen);
+    uintptr_t addr = (uintptr_t)scratch;
+    uint32_t* fa = (uint32_t*)((addr + sizeof(uint32_t) - 1) & ~(uintptr_t)(sizeof(uint32_t) - 1));
+    uint32_t* fb = fa + n;
+    uint32_t* r0 = fb + n;
+    uint32_t* r1 = r0 + n;
+    uint32_t* roots = r1 + n;
+    uint32_t* iroots = roots + n;
+    // the three primes are independent
+    convolveJob c0, c1;
+    forkConvolve(&c0, 0, n, alen, adata, blen, bdata, r0, fb, roots, iroots);
+    forkConvolve(&c1, 1, n, alen, adata, blen, bdata, r1, fb, roots, iroots);
+    convolve(n, &primes[2], alen, adata, blen, bdata, fa, fb, roots, iroots);
+    joinConvolve(&c1);
+    joinConvolve(&c0);
+    // Garner's algorithm: x = r0 + p0 * t1 + p0 * p1 * t2
+    const uint64_t p0 = primes[0].p;
+    const uint64_t p1 = primes[1].p;
+    const uint64_t p2 = primes[2].p;
+    const uint64_t p0inv = powMod((uint32_t)(p0 % p1), p1 - 2, (uint32_t)p1);
+    const uint64_t p01 = p0 * p1;
+    const uint64_t p01inv = powMod((uint32_t)(p01 % p2), p2 - 2, (uint32_t)p2);
+    // what the coefficients so far carry into the current one
+    uint64_t carry = 0;
+    size_t len = alen + blen;
+    size_t chunks = chunkCount(len);
+    memset(buffer, 0, len * sizeof(WordType));
+    for(size_t i = 0; i < chunks; i++) {
+        uint64_t t1 = (r1[i] + p1 - r0[i] % p1) % p1 * p0inv % p1;
+        uint64_t x01 = r0[i] + p0 * t1;
+        uint64_t t2 = (fa[i] + p2 - x01 % p2) % p2 * p01inv % p2;
+        // x = x01 + p01 * t2 is below 2^90, so add it to the carry in two
+        // halves of 32 and 64 bits
+        uint64_t lo = (p01 & 0xffffffffu) * t2;
+        uint64_t hi = (p01 >> 32) * t2 + (lo >> 32);
+        lo = (lo & 0xffffffffu) + (x01 & 0xffffffffu) + (carry & 0xffffffffu);
+        hi += (x01 >> 32) + (carry >> 32) + (lo >> 32);
+        putChunk(len, buffer, i, (uint32_t)lo);
+        carry = hi;
+    }
+    assert(carry == 0);
+}
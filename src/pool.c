@@ -0,0 +1,338 @@
+#include "bigint_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Pool allocator for BigInts. Every block starts with a header naming the
+ * thread cache that owns it and its size class. Blocks of up to
+ * 2^POOL_MAX_SHIFT bytes are carved from chunks of the allocating thread
+ * and recycled through that thread's free lists, one per power of two
+ * size. A block freed on another thread is pushed onto its owner's remote
+ * list, which the owner takes back whenever a free list runs dry, so
+ * memory flows back to the thread that carved it instead of piling up
+ * elsewhere, and a reset never leaves a block behind on another thread.
+ * Larger blocks come straight from YABI_MALLOC and are kept on a list of
+ * their own so that a reset finds them.
+ *
+ * A cache lives on the heap rather than in thread local storage, since its
+ * blocks may outlive the thread. When a thread exits, its cache is put on
+ * a list of orphans along with everything it owns, where frees from other
+ * threads keep reaching its remote list. The next thread to need a cache
+ * adopts one from that list before making a new one.
+ */
+
+#define POOL_MIN_SHIFT 6
+#define POOL_MAX_SHIFT 16
+#define POOL_CLASSES (POOL_MAX_SHIFT - POOL_MIN_SHIFT + 1)
+#define POOL_BIG POOL_CLASSES
+#define POOL_CHUNK_BYTES ((size_t)1 << 18)
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+#if defined(YABI_NO_THREADS)
+    // a single thread, whose cache is never orphaned
+#elif defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+struct poolCache;
+
+typedef struct poolHeader {
+    struct poolCache* owner;
+    size_t cls;
+} poolHeader;
+
+// big blocks are linked in front of their header
+typedef struct poolBig {
+    struct poolBig* prev;
+    struct poolBig* next;
+} poolBig;
+
+// the start of every chunk, padded to keep the blocks after it aligned
+typedef struct poolChunk {
+    struct poolChunk* next;
+    size_t pad;
+} poolChunk;
+
+typedef struct poolCache {
+    // free blocks link through the first word after their header
+    poolHeader* free[POOL_CLASSES];
+    // blocks of this thread that other threads freed
+    poolHeader* remote;
+    poolBig* big;
+    poolChunk* chunks;
+    char* bump;
+    char* end;
+    struct poolCache* nextOrphan;
+} poolCache;
+
+static YABI_THREAD_LOCAL poolCache* cache;
+
+#if defined(YABI_NO_THREADS)
+
+static poolCache* newCache(void) {
+    static poolCache only;
+    return &only;
+}
+
+#else
+
+static poolCache* orphans;
+
+#if defined(_WIN32)
+static SRWLOCK orphanLock = SRWLOCK_INIT;
+static INIT_ONCE exitOnce = INIT_ONCE_STATIC_INIT;
+static DWORD exitKey;
+#define orphansLock() AcquireSRWLockExclusive(&orphanLock)
+#define orphansUnlock() ReleaseSRWLockExclusive(&orphanLock)
+#else
+static pthread_mutex_t orphanLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t exitOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t exitKey;
+#define orphansLock() pthread_mutex_lock(&orphanLock)
+#define orphansUnlock() pthread_mutex_unlock(&orphanLock)
+#endif
+
+// runs when a thread with a cache exits
+#if defined(_WIN32)
+static void WINAPI orphanCache(void* p) {
+#else
+static void orphanCache(void* p) {
+#endif
+    poolCache* c = p;
+    if(!c) {
+        return;
+    }
+    cache = NULL;
+    orphansLock();
+    c->nextOrphan = orphans;
+    orphans = c;
+    orphansUnlock();
+}
+
+#if defined(_WIN32)
+static BOOL CALLBACK makeExitKey(PINIT_ONCE once, void* param, void** context) {
+    (void)once; (void)param; (void)context;
+    exitKey = FlsAlloc(orphanCache);
+    return TRUE;
+}
+#else
+static void makeExitKey(void) {
+    pthread_key_create(&exitKey, orphanCache);
+}
+#endif
+
+// adopts an orphan, or makes a new cache, and has it orphaned when the
+// calling thread exits
+static poolCache* newCache(void) {
+    orphansLock();
+    poolCache* c = orphans;
+    if(c) {
+        orphans = c->nextOrphan;
+    }
+    orphansUnlock();
+    if(!c) {
+        c = YABI_MALLOC(sizeof(poolCache));
+        memset(c, 0, sizeof(poolCache));
+    }
+#if defined(_WIN32)
+    InitOnceExecuteOnce(&exitOnce, makeExitKey, NULL, NULL);
+    FlsSetValue(exitKey, c);
+#else
+    pthread_once(&exitOnce, makeExitKey);
+    pthread_setspecific(exitKey, c);
+#endif
+    return c;
+}
+
+#endif
+
+static poolCache* ownCache(void) {
+    poolCache* c = cache;
+    if(!c) {
+        c = cache = newCache();
+    }
+    return c;
+}
+
+static poolHeader** nextFree(poolHeader* h) {
+    return (poolHeader**)(h + 1);
+}
+
+static void remotePush(poolCache* c, poolHeader* h) {
+#if defined(_MSC_VER)
+    void* head;
+    do {
+        head = c->remote;
+        *nextFree(h) = head;
+    } while(_InterlockedCompareExchangePointer((void* volatile*)&c->remote, h, head) != head);
+#else
+    poolHeader* head = __atomic_load_n(&c->remote, __ATOMIC_RELAXED);
+    do {
+        *nextFree(h) = head;
+    } while(!__atomic_compare_exchange_n(&c->remote, &head, h, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+#endif
+}
+
+static poolHeader* remoteTake(poolCache* c) {
+#if defined(_MSC_VER)
+    return _InterlockedExchangePointer((void* volatile*)&c->remote, NULL);
+#else
+    // a plain load first keeps the common empty case free of locked
+    // instructions
+    if(!__atomic_load_n(&c->remote, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+    return __atomic_exchange_n(&c->remote, NULL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+// the size class of a BigInt of len words, or POOL_BIG
+static size_t classOf(size_t len) {
+    size_t bytes = sizeof(poolHeader) + sizeof(BigInt) + len * sizeof(WordType);
+    size_t cls = 0;
+    while(cls < POOL_BIG && ((size_t)1 << (cls + POOL_MIN_SHIFT)) < bytes) {
+        cls++;
+    }
+    return cls;
+}
+
+// the number of words a BigInt in a block of the class has room for
+static size_t classCapacity(size_t cls) {
+    size_t bytes = (size_t)1 << (cls + POOL_MIN_SHIFT);
+    return (bytes - sizeof(poolHeader) - sizeof(BigInt)) / sizeof(WordType);
+}
+
+static void freeBig(poolCache* c, poolHeader* h) {
+    poolBig* b = (poolBig*)h - 1;
+    if(b->prev) {
+        b->prev->next = b->next;
+    } else {
+        c->big = b->next;
+    }
+    if(b->next) {
+        b->next->prev = b->prev;
+    }
+    YABI_FREE(b);
+}
+
+// moves the blocks other threads gave back onto the free lists
+static void drainRemote(poolCache* c) {
+    poolHeader* h = remoteTake(c);
+    while(h) {
+        poolHeader* next = *nextFree(h);
+        if(h->cls == POOL_BIG) {
+            freeBig(c, h);
+        } else {
+            *nextFree(h) = c->free[h->cls];
+            c->free[h->cls] = h;
+        }
+        h = next;
+    }
+}
+
+static poolHeader* carve(poolCache* c, size_t cls) {
+    size_t bytes = (size_t)1 << (cls + POOL_MIN_SHIFT);
+    if((size_t)(c->end - c->bump) < bytes) {
+        // the tail of the old chunk is too small for this class, so it is
+        // handed out to the smaller ones
+        for(size_t k = cls; k-- > 0; ) {
+            size_t kbytes = (size_t)1 << (k + POOL_MIN_SHIFT);
+            while((size_t)(c->end - c->bump) >= kbytes) {
+                poolHeader* h = (poolHeader*)c->bump;
+                c->bump += kbytes;
+                h->owner = c;
+                h->cls = k;
+                *nextFree(h) = c->free[k];
+                c->free[k] = h;
+            }
+        }
+        poolChunk* chunk = YABI_MALLOC(POOL_CHUNK_BYTES);
+        chunk->next = c->chunks;
+        c->chunks = chunk;
+        c->bump = (char*)(chunk + 1);
+        c->end = (char*)chunk + POOL_CHUNK_BYTES;
+    }
+    poolHeader* h = (poolHeader*)c->bump;
+    c->bump += bytes;
+    return h;
+}
+
+BigInt* yabi_pool_new(size_t len) {
+    poolCache* c = ownCache();
+    size_t cls = classOf(len);
+    poolHeader* h;
+    if(cls == POOL_BIG) {
+        poolBig* b = YABI_MALLOC(sizeof(poolBig) + sizeof(poolHeader) + sizeof(BigInt) + len * sizeof(WordType));
+        b->prev = NULL;
+        b->next = c->big;
+        if(c->big) {
+            c->big->prev = b;
+        }
+        c->big = b;
+        h = (poolHeader*)(b + 1);
+    } else {
+        if(!c->free[cls]) {
+            drainRemote(c);
+        }
+        h = c->free[cls];
+        if(h) {
+            c->free[cls] = *nextFree(h);
+        } else {
+            h = carve(c, cls);
+        }
+    }
+    h->owner = c;
+    h->cls = cls;
+    return (BigInt*)(h + 1);
+}
+
+void yabi_pool_free(BigInt* a) {
+    poolHeader* h = (poolHeader*)a - 1;
+    poolCache* c = ownCache();
+    if(h->owner != c) {
+        remotePush(h->owner, h);
+    } else if(h->cls == POOL_BIG) {
+        freeBig(c, h);
+    } else {
+        *nextFree(h) = c->free[h->cls];
+        c->free[h->cls] = h;
+    }
+}
+
+BigInt* yabi_pool_resize(BigInt* a, size_t len) {
+    poolHeader* h = (poolHeader*)a - 1;
+    size_t cls = classOf(len);
+    if(cls == h->cls && cls != POOL_BIG) {
+        // the block stays, and all of it is usable
+        a->len = len;
+        a->cap = classCapacity(cls);
+        return a;
+    }
+    BigInt* res = yabi_pool_new(len);
+    memcpy(res, a, sizeof(BigInt) + min(a->cap, len) * sizeof(WordType));
+    res->len = len;
+    res->cap = len;
+    yabi_pool_free(a);
+    return res;
+}
+
+void yabi_pool_reset(void) {
+    poolCache* c = ownCache();
+    drainRemote(c);
+    while(c->big) {
+        poolBig* next = c->big->next;
+        YABI_FREE(c->big);
+        c->big = next;
+    }
+    while(c->chunks) {
+        poolChunk* next = c->chunks->next;
+        YABI_FREE(c->chunks);
+        c->chunks = next;
+    }
+    memset(c, 0, sizeof(poolCache));
+}
@@ -0,0 +1,17 @@
+#include "bigint_internal.h"
+#include <stdlib.h>
+
+BigInt* yabi_retain(BigInt* a) {
+    refCountInc(a);
+    return a;
+}
+
+void yabi_release(BigInt* a) {
+    if(!a) {
+        return;
+    }
+    // a sole owner cannot race with anyone, so it skips the decrement
+    if(refCountLoad(a) == 0 || refCountDec(a) == 0) {
+        YABI_FREE_BIGINT(a);
+    }
+}
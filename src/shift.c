@@ -1,54 +1,32 @@
 #include "bigint_internal.h"
 #include <stdlib.h>
 #include <string.h>
-#include <assert.h>
 
 size_t lshiftBuffers(size_t alen, const WordType* a, size_t amt, size_t len, WordType* buffer) {
-    if(amt == 0) {
-        //x << 0 == x
-        size_t stop = min(len, alen);
-        unsigned char sign = -HI_BIT(a[stop - 1]);
-        memcpy(buffer, a, stop * sizeof(WordType));
-        if(stop < len) {
-            memset(buffer + stop, sign, (len - stop) * sizeof(WordType));
-        }
-        return stop;
-    }
     //the number of *words* to shift left
     size_t shiftWords = (amt / YABI_WORD_BIT_SIZE);
-    //special case logic
-    if((alen == 1 && a[0] == 0) || (shiftWords >= len)) {
-        //0 << x == 0
+    if(shiftWords >= len) {
+        //everything is shifted out
         memset(buffer, 0, len * sizeof(WordType));
         return 1;
     }
     //the remaining number of *bits* to shift left within a word
-    WordType shiftRem = amt & (YABI_WORD_BIT_SIZE - 1);
-    size_t stop = min(alen + shiftWords, len);
+    int shiftRem = amt & (YABI_WORD_BIT_SIZE - 1);
     WordType asign = -HI_BIT(a[alen - 1]);
-    // hi carry out
-    WordType carry = HI_N_BITS(a[stop - 1 - shiftWords], shiftRem);
-    size_t i = stop;
-    // set the hi words to the sign extension
-    memset(buffer + stop, asign, (len - stop) * sizeof(WordType));
-    // add hi carry if there is room
-    if(stop < len && carry != HI_N_BITS(asign, shiftRem)) {
-        buffer[stop++] = (WordType)(asign << shiftRem) | carry;
-    }
-    // shift the remaining words from hi to lo
-    for( ; i > shiftWords + 1; i--) {
-        carry = HI_N_BITS(a[i - 2 - shiftWords], shiftRem);
-        buffer[i - 1] = (WordType)(a[i - 1 - shiftWords] << shiftRem) | carry;
+    //the words of a that make it into the buffer. Shifting hi to lo keeps
+    //this safe when `buffer` is `a`
+    size_t n = min(alen, len - shiftWords);
+    WordType carry = shiftLeftRow(n, a, shiftRem, buffer + shiftWords);
+    size_t stop = shiftWords + n;
+    if(stop < len) {
+        // hi carry into the sign extension
+        buffer[stop] = (WordType)(asign << shiftRem) | carry;
+        memset(buffer + stop + 1, asign, (len - stop - 1) * sizeof(WordType));
+        stop++;
     }
-    // shift the first word
-    buffer[shiftWords] = (WordType)(a[0] << shiftRem);
     // fill lo words with 0
     memset(buffer, 0, shiftWords * sizeof(WordType));
-    //fix potential overflow of the sign bit
-    if(stop < len && (WordType)-HI_BIT(buffer[stop - 1]) != asign) {
-        stop++;
-    }
-    return stop;
+    return trimBuffer(stop, buffer);
 }
 
 size_t yabi_lshiftToBuf(const BigInt* a, size_t amt, size_t len, WordType* buffer) {
@@ -56,52 +34,32 @@ size_t yabi_lshiftToBuf(const BigInt* a, size_t amt, size_t len, WordType* buffe
 }
 
 size_t rshiftBuffers(size_t alen, const WordType* a, size_t amt, size_t len, WordType* buffer, int useSign) {
-    if(amt == 0) {
-        //x >> 0 == x
-        size_t stop = min(len, alen);
-        unsigned char sign = useSign ? -HI_BIT(a[stop - 1]) : 0;
-        memcpy(buffer, a, stop * sizeof(WordType));
-        if(stop < len) {
-            memset(buffer + stop, sign, (len - stop) * sizeof(WordType));
-        }
-        return stop;
-    }
     //the number of words to shift right
     size_t shiftWords = (amt / YABI_WORD_BIT_SIZE);
-    size_t stop = min(alen - shiftWords, len);
     WordType asign = useSign ? -HI_BIT(a[alen - 1]) : 0;
-    //special case logic
-    if((alen == 1 && a[0] == 0) || (shiftWords >= alen)) {
-        //0 >> x == 0 and a >> huge == sign
+    if(shiftWords >= alen) {
+        //a >> huge == sign
         memset(buffer, asign, len * sizeof(WordType));
         return 1;
     }
-    #define SHIFT_HI(word) (((word) & (((WordType)1 << shiftRem) - 1)) << (YABI_WORD_BIT_SIZE - shiftRem))
     //the remaining number of *bits* to shift right within a word
-    WordType shiftRem = amt & (YABI_WORD_BIT_SIZE - 1);
-    // lo carry out
-    assert(shiftWords < alen);
-    WordType carry;
-    // shift data in lo to hi order
-    for(size_t i = 0; i < stop - 1; i++) {
-        carry = SHIFT_HI(a[i + 1 + shiftWords]);
-        buffer[i] = (WordType)(a[i + shiftWords] >> shiftRem) | carry;
+    int shiftRem = amt & (YABI_WORD_BIT_SIZE - 1);
+    //the words of the result that fit, and the word above them, which
+    //shifts its lo bits into the hi word. Shifting lo to hi keeps this
+    //safe when `buffer` is `a`
+    size_t stop = min(alen - shiftWords, len);
+    WordType above = stop + shiftWords < alen ? a[stop + shiftWords] : asign;
+    shiftRightRow(stop, a + shiftWords, shiftRem, buffer);
+    if(shiftRem) {
+        buffer[stop - 1] |= (WordType)(above << (YABI_WORD_BIT_SIZE - shiftRem));
     }
-    // shift hi word into place
-    carry = SHIFT_HI(stop + shiftWords < alen ? a[stop + shiftWords] : asign);
-    buffer[stop - 1] = (WordType)(a[stop - 1 + shiftWords] >> shiftRem) | carry;
     // fill sign extension
     memset(buffer + stop, asign, (len - stop) * sizeof(WordType));
-    //calculate actual buffer length
-    while(stop > 1 && buffer[stop - 1] == asign) {
-        stop--;
+    if(!useSign) {
+        size_t span = spanRow(stop, buffer, 0);
+        return max(span, 1);
     }
-    //fix for overcorrection
-    if(HI_BIT(buffer[stop - 1]) != (asign & 1)) {
-        stop++;
-    }
-    return stop;
-    #undef SHIFT_HI
+    return trimBuffer(stop, buffer);
 }
 
 size_t yabi_rshiftToBuf(const BigInt* a, size_t amt, size_t len, WordType* buffer) {
@@ -113,9 +71,10 @@ BigInt* yabi_lshift(const BigInt* a, size_t amt) {
     BigInt* res = YABI_NEW_BIGINT(len);
     res->refCount = 0;
     res->len = len;
+    res->cap = res->len;
     len = yabi_lshiftToBuf(a, amt, len, res->data);
     if(len != res->len) {
-        YABI_RESIZE_BIGINT(res, len);
+        RESIZE_BIGINT(res, len);
     }
     return res;
 }
@@ -125,9 +84,28 @@ BigInt* yabi_rshift(const BigInt* a, size_t amt) {
     BigInt* res = YABI_NEW_BIGINT(len);
     res->refCount = 0;
     res->len = len;
+    res->cap = res->len;
     len = yabi_rshiftToBuf(a, amt, len, res->data);
     if(len != res->len) {
-        YABI_RESIZE_BIGINT(res, len);
+        RESIZE_BIGINT(res, len);
     }
     return res;
 }
+
+BigInt* yabi_lshift_into(BigInt** dst, const BigInt* a, size_t amt) {
+    size_t len = a->len + (amt / YABI_WORD_BIT_SIZE) + 1;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, NULL, &shared);
+    res->len = yabi_lshiftToBuf(a, amt, len, res->data);
+    yabi_release(shared);
+    return res;
+}
+
+BigInt* yabi_rshift_into(BigInt** dst, const BigInt* a, size_t amt) {
+    size_t len = a->len;
+    BigInt* shared;
+    BigInt* res = reserveInto(dst, len, &a, NULL, &shared);
+    res->len = yabi_rshiftToBuf(a, amt, len, res->data);
+    yabi_release(shared);
+    return res;
+}
@@ -0,0 +1,225 @@
+#include "bigint_internal.h"
+#include <stdlib.h>
+
+/*
+ * Inline integers are tagged: a small value v is stored as 2v + 1. Sums
+ * and differences of two tagged values only need the tag of one of them
+ * taken off, (2a + 1) + 2b = 2(a + b) + 1, and products need one side
+ * untagged and the other shifted down, 2a * b + 1 = 2ab + 1. In each case
+ * the native operation overflows exactly when the result does not fit
+ * inline.
+ */
+
+#define SMALL_MAX (INTPTR_MAX / 2)
+#define SMALL_MIN (-SMALL_MAX - 1)
+
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+    #define addOverflows(a, b, r) __builtin_add_overflow(a, b, r)
+    #define subOverflows(a, b, r) __builtin_sub_overflow(a, b, r)
+    #define mulOverflows(a, b, r) __builtin_mul_overflow(a, b, r)
+#else
+static int addOverflows(intptr_t a, intptr_t b, intptr_t* r) {
+    uintptr_t s = (uintptr_t)a + (uintptr_t)b;
+    *r = (intptr_t)s;
+    // the signs of both operands differ from the sign of the sum
+    return (intptr_t)((a ^ s) & (b ^ s)) < 0;
+}
+static int subOverflows(intptr_t a, intptr_t b, intptr_t* r) {
+    uintptr_t s = (uintptr_t)a - (uintptr_t)b;
+    *r = (intptr_t)s;
+    return (intptr_t)((a ^ b) & (a ^ s)) < 0;
+}
+// conservative: only products of two half word factors are done inline
+static int mulOverflows(intptr_t a, intptr_t b, intptr_t* r) {
+    const intptr_t half = (intptr_t)1 << (sizeof(intptr_t) * 4 - 1);
+    if(a < -half || a > half || b < -half || b >= half) {
+        return 1;
+    }
+    *r = a * b;
+    return 0;
+}
+#endif
+
+static yabi_int_t makeSmall(intptr_t v) {
+    yabi_int_t x;
+    x.bits = ((uintptr_t)v << 1) | 1;
+    return x;
+}
+
+// 2v + 1 is odd, so halving after removing the tag is exact
+static intptr_t smallValue(yabi_int_t x) {
+    return ((intptr_t)x.bits - 1) / 2;
+}
+
+static BigInt* bigOf(yabi_int_t x) {
+    return (BigInt*)x.bits;
+}
+
+static BigInt* bigFromNative(int64_t v) {
+    BigInt* res = YABI_NEW_BIGINT(NATIVE_WORDS);
+    res->refCount = 0;
+    res->len = NATIVE_WORDS;
+    res->cap = res->len;
+    nativeWords((uint64_t)v, res->data);
+    size_t len = NATIVE_WORDS;
+    // shrink away extra sign words
+    while(len > 1 && res->data[len - 1] == (WordType)-HI_BIT(res->data[len - 2])) {
+        len--;
+    }
+    if(len != res->len) {
+        RESIZE_BIGINT(res, len);
+    }
+    return res;
+}
+
+// wraps a BigInt result, demoting it when it fits inline
+static yabi_int_t makeBig(BigInt* a) {
+    uint64_t v;
+    if(nativeValue(a, &v) && (int64_t)v >= SMALL_MIN && (int64_t)v <= SMALL_MAX) {
+        yabi_release(a);
+        return makeSmall((intptr_t)(int64_t)v);
+    }
+    yabi_int_t x;
+    x.bits = (uintptr_t)a;
+    return x;
+}
+
+yabi_int_t yabi_int_from_si(int64_t v) {
+    if(v >= SMALL_MIN && v <= SMALL_MAX) {
+        return makeSmall((intptr_t)v);
+    }
+    return makeBig(bigFromNative(v));
+}
+
+yabi_int_t yabi_int_from_big(BigInt* a) {
+    return makeBig(a);
+}
+
+BigInt* yabi_int_to_big(yabi_int_t x) {
+    if(x.bits & 1) {
+        return bigFromNative(smallValue(x));
+    }
+    return yabi_retain(bigOf(x));
+}
+
+int yabi_int_get_si(yabi_int_t x, int64_t* v) {
+    if(x.bits & 1) {
+        *v = smallValue(x);
+        return 1;
+    }
+    uint64_t u;
+    if(!nativeValue(bigOf(x), &u)) {
+        return 0;
+    }
+    *v = (int64_t)u;
+    return 1;
+}
+
+int yabi_int_is_small(yabi_int_t x) {
+    return x.bits & 1;
+}
+
+yabi_int_t yabi_int_retain(yabi_int_t x) {
+    if(!(x.bits & 1)) {
+        yabi_retain(bigOf(x));
+    }
+    return x;
+}
+
+void yabi_int_release(yabi_int_t x) {
+    if(!(x.bits & 1)) {
+        yabi_release(bigOf(x));
+    }
+}
+
+yabi_int_t yabi_int_add(yabi_int_t a, yabi_int_t b) {
+    if(a.bits & b.bits & 1) {
+        intptr_t r;
+        if(!addOverflows((intptr_t)a.bits, (intptr_t)b.bits - 1, &r)) {
+            yabi_int_t x;
+            x.bits = (uintptr_t)r;
+            return x;
+        }
+        // two inline values always add up to less than 64 bits
+        return makeBig(bigFromNative((int64_t)smallValue(a) + smallValue(b)));
+    }
+    if(a.bits & 1) {
+        return makeBig(yabi_add_si(bigOf(b), smallValue(a)));
+    }
+    if(b.bits & 1) {
+        return makeBig(yabi_add_si(bigOf(a), smallValue(b)));
+    }
+    return makeBig(yabi_add(bigOf(a), bigOf(b)));
+}
+
+yabi_int_t yabi_int_sub(yabi_int_t a, yabi_int_t b) {
+    if(a.bits & b.bits & 1) {
+        intptr_t r;
+        if(!subOverflows((intptr_t)a.bits, (intptr_t)b.bits - 1, &r)) {
+            yabi_int_t x;
+            x.bits = (uintptr_t)r;
+            return x;
+        }
+        return makeBig(bigFromNative((int64_t)smallValue(a) - smallValue(b)));
+    }
+    if(b.bits & 1) {
+        return makeBig(yabi_sub_si(bigOf(a), smallValue(b)));
+    }
+    if(a.bits & 1) {
+        // a - b = -(b - a)
+        BigInt* d = yabi_sub_si(bigOf(b), smallValue(a));
+        BigInt* res = yabi_negate(d);
+        yabi_release(d);
+        return makeBig(res);
+    }
+    return makeBig(yabi_sub(bigOf(a), bigOf(b)));
+}
+
+yabi_int_t yabi_int_mul(yabi_int_t a, yabi_int_t b) {
+    if(a.bits & b.bits & 1) {
+        intptr_t r;
+        if(!mulOverflows((intptr_t)a.bits - 1, smallValue(b), &r)) {
+            yabi_int_t x;
+            x.bits = (uintptr_t)r | 1;
+            return x;
+        }
+        BigInt* t = bigFromNative(smallValue(a));
+        BigInt* res = yabi_mul_si(t, smallValue(b));
+        yabi_release(t);
+        return makeBig(res);
+    }
+    if(a.bits & 1) {
+        return makeBig(yabi_mul_si(bigOf(b), smallValue(a)));
+    }
+    if(b.bits & 1) {
+        return makeBig(yabi_mul_si(bigOf(a), smallValue(b)));
+    }
+    return makeBig(yabi_mul(bigOf(a), bigOf(b)));
+}
+
+yabi_int_t yabi_int_negate(yabi_int_t a) {
+    if(a.bits & 1) {
+        intptr_t v = smallValue(a);
+        if(v != SMALL_MIN) {
+            return makeSmall(-v);
+        }
+        return makeBig(bigFromNative(-(int64_t)v));
+    }
+    return makeBig(yabi_negate(bigOf(a)));
+}
+
+int yabi_int_cmp(yabi_int_t a, yabi_int_t b) {
+    if(a.bits & b.bits & 1) {
+        // tagging keeps the order
+        intptr_t x = (intptr_t)a.bits;
+        intptr_t y = (intptr_t)b.bits;
+        return (x > y) - (x < y);
+    }
+    if(a.bits & 1) {
+        return -yabi_cmp_si(bigOf(b), smallValue(a));
+    }
+    if(b.bits & 1) {
+        return yabi_cmp_si(bigOf(a), smallValue(b));
+    }
+    return yabi_cmp(bigOf(a), bigOf(b));
+}
@@ -3,7 +3,309 @@
 #include <string.h>
 #include <assert.h>
 
-size_t yabi_fromStrToBuf(const char* restrict str, size_t len, WordType* data) {
+static const char digitChars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+#define HEX_ROW(h) \
+    h "0" h "1" h "2" h "3" h "4" h "5" h "6" h "7" \
+    h "8" h "9" h "a" h "b" h "c" h "d" h "e" h "f"
+// the two hex digits of every byte value
+static const char hexPairs[] =
+    HEX_ROW("0") HEX_ROW("1") HEX_ROW("2") HEX_ROW("3")
+    HEX_ROW("4") HEX_ROW("5") HEX_ROW("6") HEX_ROW("7")
+    HEX_ROW("8") HEX_ROW("9") HEX_ROW("a") HEX_ROW("b")
+    HEX_ROW("c") HEX_ROW("d") HEX_ROW("e") HEX_ROW("f");
+#undef HEX_ROW
+
+// one more than the value of each character as a digit, 0 if it is not one
+static const unsigned char charValues[256] = {
+    ['0'] = 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+    ['A'] = 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23,
+    24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36,
+    ['a'] = 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23,
+    24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36,
+};
+
+// the value of c as a digit, or -1 if it is not one
+static int digitValue(char c) {
+    return charValues[(unsigned char)c] - 1;
+}
+
+typedef struct radix {
+    int base;
+    // the largest power of the base that fits in a word, and its exponent
+    WordType big;
+    int digits;
+    // log2 of the base if it is a power of two, otherwise 0
+    int bits;
+} radix;
+
+static radix makeRadix(int base) {
+    radix rx;
+    rx.base = base;
+    rx.big = (WordType)base;
+    rx.digits = 1;
+    while(rx.big <= (WordType)~(WordType)0 / base) {
+        rx.big *= base;
+        rx.digits++;
+    }
+    rx.bits = 0;
+    if((base & (base - 1)) == 0) {
+        while((1 << rx.bits) < base) {
+            rx.bits++;
+        }
+    }
+    return rx;
+}
+
+// words that are enough for any number of d digits, with room to spare
+// for the sign bit or for a product of two parts that add up to d digits
+static size_t radixWords(const radix* rx, size_t d) {
+    return d / rx->digits + 3;
+}
+
+// digits that are enough for any number of n words
+static size_t radixDigits(const radix* rx, size_t n) {
+    return 1 + n * (rx->digits + 1);
+}
+
+// big^(2^i). The shift is only set by normalizePowers
+typedef struct radixPower {
+    size_t len;
+    int shift;
+    size_t digits;
+    WordType* data;
+} radixPower;
+
+#define MAX_POWERS 64
+
+// fills `pows` with big^(2^i) for as long as they are no more than half of
+// `n` words. `data` holds 2 * n + MAX_POWERS words, `scratch` holds
+// mulScratchLen(n / 2) words. Returns the number of powers
+static int makePowers(const radix* rx, size_t n, radixPower* pows, WordType* data, WordType* scratch) {
+    int count = 1;
+    pows[0].len = 1;
+    pows[0].shift = 0;
+    pows[0].digits = rx->digits;
+    pows[0].data = data;
+    data[0] = rx->big;
+    while(count < MAX_POWERS) {
+        radixPower* prev = &pows[count - 1];
+        WordType* next = prev->data + prev->len;
+        size_t len = 2 * prev->len;
+        if(len > n / 2 + 1) {
+            break;
+        }
+        sqrUnsigned(prev->len, prev->data, next, scratch);
+        while(next[len - 1] == 0) {
+            len--;
+        }
+        if(len > n / 2) {
+            break;
+        }
+        pows[count].len = len;
+        pows[count].shift = 0;
+        pows[count].digits = 2 * prev->digits;
+        pows[count].data = next;
+        count++;
+    }
+    return count;
+}
+
+// shifts each power left until its top bit is set, for division
+static void normalizePowers(radixPower* pows, int count) {
+    for(int i = 0; i < count; i++) {
+        pows[i].shift = leadingZeros(pows[i].data[pows[i].len - 1]);
+        shiftLeftRow(pows[i].len, pows[i].data, pows[i].shift, pows[i].data);
+    }
+}
+
+// packs the nd base 2^bits digits at `str` into `buffer`, stopping once
+// `len` words are full. Returns the number of words written
+static size_t fromDigitsPow2(const char* str, size_t nd, int bits, size_t len, WordType* buffer) {
+    size_t n = 0;
+    // whole words at a time when no digit spans two of them
+    if(YABI_WORD_BIT_SIZE % bits == 0) {
+        const size_t per = YABI_WORD_BIT_SIZE / bits;
+        for(; nd >= per && n < len; nd -= per) {
+            const char* s = str + nd - per;
+            WordType w = 0;
+            for(size_t j = 0; j < per; j++) {
+                w |= (WordType)((WordType)digitValue(s[j]) << (bits * (per - 1 - j)));
+            }
+            buffer[n++] = w;
+        }
+    }
+    WordType acc = 0;
+    int accBits = 0;
+    for(size_t i = nd; i > 0 && n < len; i--) {
+        WordType d = (WordType)digitValue(str[i - 1]);
+        acc |= (WordType)(d << accBits);
+        accBits += bits;
+        if(accBits >= YABI_WORD_BIT_SIZE) {
+            buffer[n++] = acc;
+            accBits -= YABI_WORD_BIT_SIZE;
+            // the top bits of the digit that did not fit
+            acc = accBits ? (WordType)(d >> (bits - accBits)) : 0;
+        }
+    }
+    if(accBits && n < len) {
+        buffer[n++] = acc;
+    }
+    return n;
+}
+
+// parses the nd digits at `str` into `buffer` a chunk of rx->digits
+// digits at a time, with one multiply-accumulate pass over the buffer per
+// chunk. Returns the number of words, which is 0 if the digits are all
+// zeros
+static size_t fromDigitsBasecase(const radix* rx, const char* str, size_t nd, WordType* buffer) {
+    size_t n = 0;
+    // the first chunk takes the digits left over from whole chunks
+    size_t k = (nd - 1) % rx->digits + 1;
+    while(nd > 0) {
+        WordType carry = 0;
+        for(size_t i = 0; i < k; i++) {
+            carry = (WordType)(carry * rx->base + digitValue(str[i]));
+        }
+        //buffer = buffer * big + chunk
+        for(size_t i = 0; i < n; i++) {
+            WordType lo = carry;
+            carry = mulAndCarry(buffer[i], rx->big, &lo);
+            buffer[i] = lo;
+        }
+        if(carry) {
+            buffer[n++] = carry;
+        }
+        str += k;
+        nd -= k;
+        k = rx->digits;
+    }
+    return n;
+}
+
+// stack and scratch words fromDigits takes for n words
+static size_t fromDigitsStackLen(size_t n) {
+    return 4 * n + 8 * MAX_POWERS;
+}
+
+static size_t fromDigits(
+        const radix* rx, const char* str, size_t nd, WordType* buffer,
+        const radixPower* pows, int count,
+        WordType* stack, WordType* scratch);
+
+// the conversion of one part of a number, which may be left to a task
+typedef struct digitsJob {
+    const radix* rx;
+    const char* str;
+    size_t nd;
+    size_t n;
+    WordType* u;
+    char* end;
+    size_t pad;
+    const radixPower* pows;
+    int count;
+    WordType* stack;
+    WordType* scratch;
+    size_t len;
+    // the stack and scratch of a forked job
+    WordType* own;
+    parTask task;
+} digitsJob;
+
+static void runFromDigits(void* arg) {
+    digitsJob* j = arg;
+    j->len = fromDigits(j->rx, j->str, j->nd, j->u, j->pows, j->count, j->stack, j->scratch);
+}
+
+// same as fromDigitsBasecase, but splits long strings so that the low part
+// has the digits of the largest power in `pows` that is shorter than them.
+// Both parts are parsed recursively into `stack` and then combined as
+// high * power + low. `buffer` holds radixWords(nd) words, and `scratch`
+// holds mulScratchLen of the longest product. Large parts are parsed in
+// parallel, the low one with a stack and scratch of its own
+static size_t fromDigits(
+        const radix* rx, const char* str, size_t nd, WordType* buffer,
+        const radixPower* pows, int count,
+        WordType* stack, WordType* scratch) {
+    while(count > 0 && pows[count - 1].digits >= nd) {
+        count--;
+    }
+    if(nd < YABI_DC_STR_THRESHOLD * (size_t)rx->digits || count == 0) {
+        return fromDigitsBasecase(rx, str, nd, buffer);
+    }
+    const radixPower* pw = &pows[count - 1];
+    size_t hd = nd - pw->digits;
+    WordType* lo = stack;
+    WordType* hi = stack + radixWords(rx, pw->digits);
+    digitsJob low;
+    low.rx = rx;
+    low.str = str + hd;
+    low.nd = pw->digits;
+    low.u = lo;
+    low.pows = pows;
+    low.count = count;
+    low.stack = hi;
+    low.scratch = scratch;
+    low.own = NULL;
+    size_t lown = radixWords(rx, pw->digits);
+    if(PARALLEL_WORTH(pw->len)) {
+        low.own = YABI_MALLOC((fromDigitsStackLen(lown) + mulScratchLen(lown) + 1) * sizeof(WordType));
+    }
+    if(low.own) {
+        low.stack = low.own;
+        low.scratch = low.own + fromDigitsStackLen(lown);
+        forkTask(&low.task, runFromDigits, &low);
+    } else {
+        runFromDigits(&low);
+    }
+    size_t hilen = fromDigits(rx, str, hd, hi, pows, count, hi + radixWords(rx, hd), scratch);
+    if(low.own) {
+        joinTask(&low.task);
+        YABI_FREE(low.own);
+    }
+    size_t lolen = low.len;
+    if(hilen == 0) {
+        memcpy(buffer, lo, lolen * sizeof(WordType));
+        return lolen;
+    }
+    mulUnsigned(hilen, hi, pw->len, pw->data, buffer, scratch);
+    size_t n = hilen + pw->len;
+    if(lolen > 0) {
+        WordType carry = addRows(lolen, buffer, lo, buffer);
+        addWordRow(n - lolen, buffer + lolen, carry, buffer + lolen);
+    }
+    while(n > 0 && buffer[n - 1] == 0) {
+        n--;
+    }
+    return n;
+}
+
+// the scratch yabi_fromStrRadixToBufWs takes at most, when the number does
+// not fit the buffer
+size_t yabi_fromStr_scratch(size_t digits, int base) {
+    if(base < 2 || base > 36) {
+        return 0;
+    }
+    radix rx = makeRadix(base);
+    if(rx.bits) {
+        return 0;
+    }
+    size_t n = radixWords(&rx, digits);
+    if(digits < YABI_DC_STR_THRESHOLD * (size_t)rx.digits) {
+        return n;
+    }
+    return n + 2 * n + MAX_POWERS + fromDigitsStackLen(n) + mulScratchLen(n);
+}
+
+size_t yabi_fromStrRadixToBuf(const char* restrict str, int base, size_t len, WordType* data) {
+    return yabi_fromStrRadixToBufWs(str, base, len, data, NULL);
+}
+
+size_t yabi_fromStrRadixToBufWs(const char* restrict str, int base, size_t len, WordType* data, yabi_workspace_t* ws) {
+    if(base < 2 || base > 36) {
+        return 0;
+    }
+    radix rx = makeRadix(base);
     const char* c = str;
     //get the sign
     int negative = 0;
@@ -11,67 +313,293 @@ size_t yabi_fromStrToBuf(const char* restrict str, size_t len, WordType* data) {
         c++;
         negative = 1;
     }
-    size_t stop = len;
-    memset(data, 0, len * sizeof(WordType));
-    while(*c >= '0' && *c <= '9') {
-        //calculate 10*x + digit
-        //save the carry from the bits shifted out
-        unsigned carry = HI_3_BITS(data[0]) + HI_BIT(data[0]);
-        //10*x = 8*x + 2*x = (x << 3) + (x << 1)
-        carry += addAndCarry(data[0] << 3, data[0] << 1, (*c - '0'), &data[0]);
-        //calculate 10*x + carry for each higher word
-        for(size_t i = 1; i < stop; i++) {
-            unsigned newCarry = HI_3_BITS(data[i]) + HI_BIT(data[i]);
-            newCarry += addAndCarry(data[i] << 3, data[i] << 1, carry, &data[i]);
-            carry = newCarry;
+    size_t nd = 0;
+    //non-digits wrap around to a huge value
+    while((unsigned)digitValue(c[nd]) < (unsigned)base) {
+        nd++;
+    }
+    size_t n;
+    if(rx.bits) {
+        //only the low len words are packed
+        n = fromDigitsPow2(c, nd, rx.bits, len, data);
+    } else {
+        //for an even base, base^k is a multiple of 2^k, so digits above the
+        //lowest len * w do not change the truncated result
+        if(base % 2 == 0 && nd > len * YABI_WORD_BIT_SIZE) {
+            c += nd - len * YABI_WORD_BIT_SIZE;
+            nd = len * YABI_WORD_BIT_SIZE;
         }
-        c++;
+        n = radixWords(&rx, nd);
+        int dc = nd >= YABI_DC_STR_THRESHOLD * (size_t)rx.digits;
+        size_t powLen = dc ? 2 * n + MAX_POWERS : 0;
+        size_t stackLen = dc ? fromDigitsStackLen(n) : 0;
+        size_t scratchLen = dc ? mulScratchLen(n) : 0;
+        //parse straight into the buffer when the whole number fits
+        size_t outLen = n <= len ? 0 : n;
+        size_t wordLen = outLen + powLen + stackLen + scratchLen;
+        WordType* scratch = takeScratch(ws, wordLen);
+        WordType* out = outLen ? scratch : data;
+        if(dc) {
+            radixPower pows[MAX_POWERS];
+            WordType* mulScratch = scratch + outLen + powLen + stackLen;
+            int count = makePowers(&rx, n, pows, scratch + outLen, mulScratch);
+            n = fromDigits(&rx, c, nd, out, pows, count, scratch + outLen + powLen, mulScratch);
+        } else {
+            n = fromDigitsBasecase(&rx, c, nd, out);
+        }
+        if(outLen) {
+            n = min(n, len);
+            memcpy(data, out, n * sizeof(WordType));
+        }
+        dropScratch(ws, scratch);
     }
+    memset(data + n, 0, (len - n) * sizeof(WordType));
     //if negative, flip the bits and add one
     if(negative) {
-        unsigned carry = 1;
-        for(size_t i = 0; i < stop; i++) {
+        for(size_t i = 0; i < len; i++) {
             data[i] = ~data[i];
-            carry = addAndCarry(data[i], carry, 0, &data[i]);
         }
-        //throw away last carry
+        addWordRow(len, data, 1, data);
     }
     //calculate true number of words. i.e. get rid of the extra sign extension.
-    while(stop > 1 && data[stop - 1] == (WordType)-negative) {
+    size_t stop = len;
+    WordType ext = (WordType)-HI_BIT(data[len - 1]);
+    while(stop > 1 && data[stop - 1] == ext && HI_BIT(data[stop - 2]) == HI_BIT(ext)) {
         stop--;
     }
-    //if the sign bit is not the same as `negative`, we need to add it back
-    if(stop < len && HI_BIT(data[stop - 1]) != negative) {
-        stop++;
-    }
     return stop;
 }
 
-BigInt* yabi_fromStr(const char* str) {
-    //overestimates required space
-    //space = 1 + (log2(num) / log2(WordBase))
-    #define TO_LOGB2(a) ((a) * 7 / 2)
-    size_t cap = 1 + TO_LOGB2(strlen(str)) / YABI_WORD_BIT_SIZE;
-    #undef TO_LOGB2
+BigInt* yabi_fromStrRadix(const char* str, int base) {
+    if(base < 2 || base > 36) {
+        return NULL;
+    }
+    //overestimates required space, leaving room for the sign bit
+    radix rx = makeRadix(base);
+    size_t cap = radixWords(&rx, strlen(str));
     BigInt* res = YABI_NEW_BIGINT(cap);
     res->refCount = 0;
     res->len = cap;
-    cap = yabi_fromStrToBuf(str, cap, res->data);
+    res->cap = res->len;
+    cap = yabi_fromStrRadixToBuf(str, base, cap, res->data);
     if(cap != res->len) {
-        YABI_RESIZE_BIGINT(res, cap);
+        RESIZE_BIGINT(res, cap);
     }
     return res;
 }
 
-size_t yabi_toBuf(const BigInt* a, size_t len, char* restrict _buffer) {
+size_t yabi_fromStrToBuf(const char* restrict str, size_t len, WordType* data) {
+    return yabi_fromStrRadixToBuf(str, 10, len, data);
+}
+
+BigInt* yabi_fromStr(const char* str) {
+    return yabi_fromStrRadix(str, 10);
+}
+
+// writes the n-word unsigned `u` in base 2^bits backwards from `end`.
+// Returns where the digits start
+static char* toDigitsPow2(size_t n, const WordType* u, int bits, char* end) {
+    char* p = end;
+    const WordType mask = (WordType)((1u << bits) - 1);
+    while(n > 0 && u[n - 1] == 0) {
+        n--;
+    }
+    // the low bits of a digit that spans two words
+    WordType acc = 0;
+    int accBits = 0;
+    if(bits == 4) {
+        // two digits a byte from a table of all the byte values
+        for(size_t i = 0; i < n; i++) {
+            WordType w = u[i];
+            for(int j = 0; j < YABI_WORD_BIT_SIZE / 8; j++) {
+                p -= 2;
+                memcpy(p, &hexPairs[2 * (w & 0xff)], 2);
+                w >>= 8;
+            }
+        }
+        n = 0;
+    } else if(YABI_WORD_BIT_SIZE % bits == 0) {
+        for(size_t i = 0; i < n; i++) {
+            WordType w = u[i];
+            for(int j = 0; j < YABI_WORD_BIT_SIZE / bits; j++) {
+                *--p = digitChars[w & mask];
+                w >>= bits;
+            }
+        }
+        n = 0;
+    }
+    for(size_t i = 0; i < n; i++) {
+        WordType w = u[i];
+        int pos = 0;
+        if(accBits) {
+            *--p = digitChars[(acc | (WordType)(w << accBits)) & mask];
+            pos = bits - accBits;
+        }
+        for(; pos + bits <= YABI_WORD_BIT_SIZE; pos += bits) {
+            *--p = digitChars[(w >> pos) & mask];
+        }
+        accBits = YABI_WORD_BIT_SIZE - pos;
+        acc = accBits ? (WordType)(w >> pos) : 0;
+    }
+    if(accBits) {
+        *--p = digitChars[acc];
+    }
+    // the top word can leave leading zeros
+    while(p < end && *p == '0') {
+        p++;
+    }
+    if(p == end) {
+        *--p = '0';
+    }
+    return p;
+}
+
+// writes the n-word unsigned `u` backwards from `end`, by repeated
+// division by rx->big. Writes exactly `pad` digits if it is nonzero,
+// otherwise as few as possible. Destroys `u` and returns where the digits
+// start
+static char* toDigitsBasecase(const radix* rx, size_t n, WordType* u, char* end, size_t pad) {
+    char* p = end;
+    while(n > 0 && u[n - 1] == 0) {
+        n--;
+    }
+    while(n > 0) {
+        WordType r = divremWord(n, u, rx->big, u);
+        while(n > 0 && u[n - 1] == 0) {
+            n--;
+        }
+        // every chunk but the top one has all rx->digits digits. Decimal
+        // gets its own loop so that it divides by a constant
+        int k = rx->digits;
+        if(rx->base == 10) {
+            for(; k > 0 && (n > 0 || r != 0); k--) {
+                *--p = (char)('0' + r % 10);
+                r /= 10;
+            }
+        } else {
+            for(; k > 0 && (n > 0 || r != 0); k--) {
+                *--p = digitChars[r % rx->base];
+                r /= rx->base;
+            }
+        }
+    }
+    if(p == end && !pad) {
+        *--p = '0';
+    }
+    while((size_t)(end - p) < pad) {
+        *--p = '0';
+    }
+    return p;
+}
+
+// stack and scratch words toDigits takes for n words. Every split leaves
+// a quotient of at most three quarters of its dividend, and they are all
+// on the stack at once at the deepest level
+static size_t toDigitsStackLen(size_t n) {
+    return 4 * n + 4 * MAX_POWERS;
+}
+
+static size_t toDigitsScratchLen(size_t n) {
+    size_t half = (n + 1) / 2;
+    return max(divremScratchLen(2 * half, half), mulScratchLen(half));
+}
+
+static char* toDigits(
+        const radix* rx, size_t n, WordType* u, char* end, size_t pad,
+        const radixPower* pows, int count,
+        WordType* stack, WordType* scratch);
+
+static void runToDigits(void* arg) {
+    digitsJob* j = arg;
+    toDigits(j->rx, j->n, j->u, j->end, j->pad, j->pows, j->count, j->stack, j->scratch);
+}
+
+// same as toDigitsBasecase, but splits large numbers at the largest power
+// in `pows` that is at most half their size, and converts both parts
+// recursively. `u` has room for n + 1 words. Each level takes the quotient
+// from `stack`, and `scratch` holds the scratch space for the divisions.
+// The remainder always has exactly the digits of the power, so large
+// remainders are converted in parallel with a stack and scratch of their
+// own
+static char* toDigits(
+        const radix* rx, size_t n, WordType* u, char* end, size_t pad,
+        const radixPower* pows, int count,
+        WordType* stack, WordType* scratch) {
+    while(n > 0 && u[n - 1] == 0) {
+        n--;
+    }
+    while(count > 0 && pows[count - 1].len > (n + 1) / 2) {
+        count--;
+    }
+    // the divisions need at least two word divisors
+    if(n < YABI_DC_STR_THRESHOLD || count == 0 || pows[count - 1].len < 2) {
+        return toDigitsBasecase(rx, n, u, end, pad);
+    }
+    const radixPower* pw = &pows[count - 1];
+    size_t qn = n + 1 - pw->len;
+    WordType* q = stack;
+    u[n] = shiftLeftRow(n, u, pw->shift, u);
+    WordType qh = divremNormalized(n + 1, u, pw->len, pw->data, q, scratch);
+    assert(qh == 0);
+    (void)qh;
+    shiftRightRow(pw->len, u, pw->shift, u);
+    // the remainder makes up the low digits, zeros included
+    digitsJob low;
+    low.rx = rx;
+    low.n = pw->len;
+    low.u = u;
+    low.end = end;
+    low.pad = pw->digits;
+    low.pows = pows;
+    low.count = count;
+    low.stack = q + qn + 1;
+    low.scratch = scratch;
+    low.own = NULL;
+    if(PARALLEL_WORTH(pw->len)) {
+        low.own = YABI_MALLOC((toDigitsStackLen(pw->len) + toDigitsScratchLen(pw->len) + 1) * sizeof(WordType));
+    }
+    if(low.own) {
+        low.stack = low.own;
+        low.scratch = low.own + toDigitsStackLen(pw->len);
+        forkTask(&low.task, runToDigits, &low);
+    } else {
+        runToDigits(&low);
+    }
+    char* start = toDigits(rx, qn, q, end - pw->digits, pad ? pad - pw->digits : 0, pows, count, q + qn + 1, scratch);
+    if(low.own) {
+        joinTask(&low.task);
+        YABI_FREE(low.own);
+    }
+    return start;
+}
+
+// the scratch yabi_toBufRadixWs takes at most, for a negative number whose
+// digits do not fit the buffer
+size_t yabi_toStr_scratch(size_t alen, int base) {
+    if(base < 2 || base > 36) {
+        return 0;
+    }
+    radix rx = makeRadix(base);
+    size_t n = alen;
+    size_t charWords = (radixDigits(&rx, n) + sizeof(WordType) - 1) / sizeof(WordType);
+    if(rx.bits || n < YABI_DC_STR_THRESHOLD) {
+        return n + 1 + charWords;
+    }
+    return n + 1 + 2 * n + MAX_POWERS + toDigitsStackLen(n) + toDigitsScratchLen(n) + charWords;
+}
+
+size_t yabi_toBufRadix(const BigInt* a, int base, size_t len, char* restrict buffer) {
+    return yabi_toBufRadixWs(a, base, len, buffer, NULL);
+}
+
+size_t yabi_toBufRadixWs(const BigInt* a, int base, size_t len, char* restrict buffer, yabi_workspace_t* ws) {
     //nil buffer case
-    if(len == 1) {
-        *_buffer = '\0';
+    if(len == 1 || base < 2 || base > 36) {
+        *buffer = '\0';
         return 0;
     }
-    #define NTH_BIT(a, n) (((a) & ((WordType)1 << (n))) >> (n))
+    radix rx = makeRadix(base);
     const int negative = HI_BIT(a->data[a->len - 1]);
-    unsigned char* buffer = (unsigned char*) _buffer; //unsigned for definedness :)
     //check for string length 1 with negative number
     if(negative) {
         buffer[0] = '-';
@@ -79,87 +607,73 @@ size_t yabi_toBuf(const BigInt* a, size_t len, char* restrict _buffer) {
         if(len == 2) {
             return 1;
         }
-    } else {
-        buffer[0] = 0;
-    }
-    size_t bufferLen = 1 + negative;
-    //"double dabble" to convert binary to binary coded decimal
-    //this takes time proportional to the number of bits in a->data
-    for(size_t aWordIdx = a->len; aWordIdx > 0; aWordIdx--) {
-        WordType word = a->data[aWordIdx - 1];
-        if(negative) {
-            word = ~word;
-        }
-        for(size_t aBitIdx = (sizeof(WordType) << 3); aBitIdx > 0; aBitIdx--) {
-            //dabble
-            for(size_t i = negative; i < bufferLen; i++) {
-                unsigned char tmp = buffer[i];
-                if(tmp >= 5) {
-                    tmp += 3;
-                }
-                //overflow of nibble is not possible in double-dabble
-                assert(tmp < 16);
-                buffer[i] = tmp;
-            }
-            //double
-            int carry = NTH_BIT(word, aBitIdx - 1);
-            for(size_t i = negative; i < bufferLen; i++) {
-                unsigned char tmp = buffer[i];
-                assert(carry == 0 || carry == 1);
-                tmp = (tmp << 1) | carry;
-                carry = (tmp & 0x10) >> 4; //overflow bit (0b1_xxxx)
-                tmp &= 0xf;
-                buffer[i] = tmp;
-            }
-            if(carry && bufferLen < len - 1) {
-                buffer[bufferLen++] = carry;
-                buffer[bufferLen] = 0;
-            }
-        }
     }
+    //work on the magnitude
+    size_t n = a->len;
+    size_t maxDigits = radixDigits(&rx, n);
+    size_t room = len - 1 - negative;
+    int dc = !rx.bits && n >= YABI_DC_STR_THRESHOLD;
+    size_t powLen = dc ? 2 * n + MAX_POWERS : 0;
+    size_t stackLen = dc ? toDigitsStackLen(n) : 0;
+    size_t scratchLen = dc ? toDigitsScratchLen(n) : 0;
+    //packing bits leaves a nonnegative number as it is
+    size_t uLen = (rx.bits && !negative) ? 0 : n + 1;
+    size_t wordLen = uLen + powLen + stackLen + scratchLen;
+    //the digits go straight into the buffer when they are sure to fit
+    size_t charLen = room >= maxDigits ? 0 : maxDigits;
+    WordType* u = takeScratch(ws, wordLen + (charLen + sizeof(WordType) - 1) / sizeof(WordType));
     if(negative) {
-        //add one (in base 10)
-        int carry = 1;
-        for(size_t i = 1; i < bufferLen; i++) {
-            unsigned char tmp = buffer[i];
-            tmp += carry;
-            if(tmp > 9) {
-                tmp -= 10;
-                carry = 1;
-            } else {
-                carry = 0;
-            }
-            buffer[i] = tmp;
-        }
-        if(carry && bufferLen < len - 1) {
-            buffer[bufferLen++] = carry;
+        for(size_t i = 0; i < n; i++) {
+            u[i] = ~a->data[i];
         }
+        addWordRow(n, u, 1, u);
+    } else if(uLen) {
+        memcpy(u, a->data, n * sizeof(WordType));
     }
-    buffer[bufferLen] = '\0'; //NUL-terminate
-    //put into ASCII digit range and in correct endian order
-    for(size_t i = 0; i < (bufferLen - negative) / 2; i++) {
-        unsigned char tmp = buffer[bufferLen - 1 - i];
-        buffer[bufferLen - 1 - i] = buffer[negative + i] + '0';
-        buffer[negative + i] = tmp + '0';
+    char* end = charLen ? (char*)(u + wordLen) + charLen : buffer + negative + maxDigits;
+    char* start;
+    if(rx.bits) {
+        start = toDigitsPow2(n, uLen ? u : a->data, rx.bits, end);
+    } else if(dc) {
+        radixPower pows[MAX_POWERS];
+        WordType* scratch = u + n + 1 + powLen + stackLen;
+        int count = makePowers(&rx, n, pows, u + n + 1, scratch);
+        normalizePowers(pows, count);
+        start = toDigits(&rx, n, u, end, 0, pows, count, u + n + 1 + powLen, scratch);
+    } else {
+        start = toDigitsBasecase(&rx, n, u, end, 0);
     }
-    if((bufferLen - negative) & 1) {
-        buffer[bufferLen / 2] += '0';
+    //keep the lowest digits if there is not enough room
+    size_t digits = end - start;
+    if(digits > room) {
+        start += digits - room;
+        digits = room;
     }
-    return bufferLen;
-    #undef NTH_BIT
+    memmove(buffer + negative, start, digits);
+    dropScratch(ws, u);
+    buffer[negative + digits] = '\0'; //NUL-terminate
+    return negative + digits;
 }
 
-char* yabi_toStr(const BigInt* a) {
-    //len = 1 + log10(a) = 1 + logWT(a) / logWT(10)
-    //logWT(a) = a->len
-    //logWT(10) ~= 3.32 / WORD_BIT_SIZE
-    //len = 1 + a->len * (WORD_BIT_SIZE / 3.32)
-    size_t len = 1 + a->len * ((YABI_WORD_BIT_SIZE + 1) / 3)
+char* yabi_toStrRadix(const BigInt* a, int base) {
+    if(base < 2 || base > 36) {
+        return NULL;
+    }
+    radix rx = makeRadix(base);
+    size_t len = radixDigits(&rx, a->len)
         + HI_BIT(a->data[a->len - 1]); //minus sign takes up one extra
     char* res = YABI_MALLOC(len + 1);
-    size_t newLen = yabi_toBuf(a, len + 1, res);
+    size_t newLen = yabi_toBufRadix(a, base, len + 1, res);
     if(newLen != len) {
         res = YABI_REALLOC(res, newLen + 1);
     }
     return res;
 }
+
+size_t yabi_toBuf(const BigInt* a, size_t len, char* restrict buffer) {
+    return yabi_toBufRadix(a, 10, len, buffer);
+}
+
+char* yabi_toStr(const BigInt* a) {
+    return yabi_toStrRadix(a, 10);
+}
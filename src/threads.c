@@ -0,0 +1,411 @@
+#include "bigint_internal.h"
+#include <stdlib.h>
+
+/*
+ * Fork and join for the recursive algorithms. A forked task goes onto the
+ * queue of the thread that forked it, and joining it takes it back off and
+ * runs it right there, unless another thread has stolen it in the
+ * meantime. Every worker runs the tasks of its own queue newest first and
+ * steals the oldest ones of the other queues, which are the largest, when
+ * its own is empty. Threads that are not workers share one queue. A thread
+ * whose task was stolen keeps running other tasks until it is done, so no
+ * thread waits while there is work, and nested forks spread themselves
+ * over the pool.
+ *
+ * With an executor instead, each task is handed to it in a claim that the
+ * executor and the joining thread race to take, and that whichever of them
+ * lets go last frees.
+ */
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+static inline long atomicLoad(long* p) {
+    return _InterlockedOr((volatile long*)p, 0);
+}
+static inline void atomicStore(long* p, long v) {
+    _InterlockedExchange((volatile long*)p, v);
+}
+static inline void atomicAdd(long* p, long v) {
+    _InterlockedExchangeAdd((volatile long*)p, v);
+}
+static inline long atomicSwap(long* p, long v) {
+    return _InterlockedExchange((volatile long*)p, v);
+}
+static inline int atomicCas(long* p, long old, long v) {
+    return _InterlockedCompareExchange((volatile long*)p, v, old) == old;
+}
+#else
+static inline long atomicLoad(long* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static inline void atomicStore(long* p, long v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+static inline void atomicAdd(long* p, long v) {
+    __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+}
+static inline long atomicSwap(long* p, long v) {
+    return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL);
+}
+static inline int atomicCas(long* p, long old, long v) {
+    return __atomic_compare_exchange_n(p, &old, v, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#endif
+
+#if defined(YABI_NO_THREADS)
+    typedef int taskMutex;
+    #define mutexInit(m) ((void)(m))
+    #define mutexFree(m) ((void)(m))
+    #define mutexLock(m) ((void)(m))
+    #define mutexUnlock(m) ((void)(m))
+#elif defined(_WIN32)
+    #include <windows.h>
+    typedef SRWLOCK taskMutex;
+    typedef CONDITION_VARIABLE taskCond;
+    typedef HANDLE taskThread;
+    #define mutexInit(m) InitializeSRWLock(m)
+    #define mutexFree(m) ((void)(m))
+    #define mutexLock(m) AcquireSRWLockExclusive(m)
+    #define mutexUnlock(m) ReleaseSRWLockExclusive(m)
+    #define condInit(c) InitializeConditionVariable(c)
+    #define condFree(c) ((void)(c))
+    #define condWait(c, m) SleepConditionVariableSRW(c, m, INFINITE, 0)
+    #define condSignal(c) WakeConditionVariable(c)
+    #define condBroadcast(c) WakeAllConditionVariable(c)
+#else
+    #include <pthread.h>
+    typedef pthread_mutex_t taskMutex;
+    typedef pthread_cond_t taskCond;
+    typedef pthread_t taskThread;
+    #define mutexInit(m) pthread_mutex_init(m, NULL)
+    #define mutexFree(m) pthread_mutex_destroy(m)
+    #define mutexLock(m) pthread_mutex_lock(m)
+    #define mutexUnlock(m) pthread_mutex_unlock(m)
+    #define condInit(c) pthread_cond_init(c, NULL)
+    #define condFree(c) pthread_cond_destroy(c)
+    #define condWait(c, m) pthread_cond_wait(c, m)
+    #define condSignal(c) pthread_cond_signal(c)
+    #define condBroadcast(c) pthread_cond_broadcast(c)
+#endif
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #define yieldThread() ((void)SwitchToThread())
+#else
+    #include <sched.h>
+    #define yieldThread() ((void)sched_yield())
+#endif
+
+#define TASK_QUEUED 0
+#define TASK_RUNNING 1
+#define TASK_DONE 2
+
+// tasks a queue holds. A fork that finds its queue full runs at once
+#define QUEUE_CAP 64
+
+typedef struct taskQueue {
+    taskMutex lock;
+    // the queue holds tasks[head % QUEUE_CAP .. tail % QUEUE_CAP)
+    size_t head;
+    size_t tail;
+    parTask* tasks[QUEUE_CAP];
+} taskQueue;
+
+typedef struct taskClaim {
+    void (*run)(void* arg);
+    void* arg;
+    long state;
+    // the executor and the joining thread
+    long owners;
+} taskClaim;
+
+static struct {
+    // 1 when tasks go anywhere but straight to being run
+    long on;
+    yabi_executor_fn submit;
+    void* ctx;
+#if !defined(YABI_NO_THREADS)
+    int workers;
+    // one per worker, then the one the other threads share
+    taskQueue* queues;
+    taskThread* threads;
+    // sleeping workers wait for `queued` to become nonzero
+    taskMutex idleLock;
+    taskCond idle;
+    int sleeping;
+    int stop;
+    long queued;
+#endif
+} pool;
+
+int parallelOn(void) {
+    return (int)atomicLoad(&pool.on);
+}
+
+static void runClaim(void* arg) {
+    taskClaim* c = arg;
+    if(atomicCas(&c->state, TASK_QUEUED, TASK_RUNNING)) {
+        c->run(c->arg);
+        atomicStore(&c->state, TASK_DONE);
+    }
+    if(atomicSwap(&c->owners, 1) == 1) {
+        YABI_FREE(c);
+    }
+}
+
+static void joinClaim(taskClaim* c) {
+    if(atomicCas(&c->state, TASK_QUEUED, TASK_RUNNING)) {
+        c->run(c->arg);
+    } else {
+        while(atomicLoad(&c->state) != TASK_DONE) {
+            yieldThread();
+        }
+    }
+    if(atomicSwap(&c->owners, 1) == 1) {
+        YABI_FREE(c);
+    }
+}
+
+#if !defined(YABI_NO_THREADS)
+
+static YABI_THREAD_LOCAL taskQueue* ownQueue;
+
+static void runTask(parTask* t) {
+    t->run(t->arg);
+    // the forking thread may return as soon as it sees this, so `t` is
+    // not touched after it
+    atomicStore(&t->state, TASK_DONE);
+}
+
+// takes the newest task of the calling thread's own queue, or else the
+// oldest of any other, starting from the one after it
+static parTask* takeTask(void) {
+    int count = pool.workers + 1;
+    int start = ownQueue ? (int)(ownQueue - pool.queues) : pool.workers;
+    for(int i = 0; i < count; i++) {
+        taskQueue* q = &pool.queues[(start + i) % count];
+        parTask* t = NULL;
+        mutexLock(&q->lock);
+        if(q->head != q->tail) {
+            if(i == 0) {
+                t = q->tasks[--q->tail % QUEUE_CAP];
+            } else {
+                t = q->tasks[q->head++ % QUEUE_CAP];
+            }
+            t->queued = 0;
+        }
+        mutexUnlock(&q->lock);
+        if(t) {
+            atomicAdd(&pool.queued, -1);
+            return t;
+        }
+    }
+    return NULL;
+}
+
+// takes `t` back off its queue if it is still there. It is almost always
+// the newest task, as the tasks forked after it have been joined already
+static int unqueueTask(parTask* t) {
+    taskQueue* q = t->home;
+    int found = 0;
+    mutexLock(&q->lock);
+    if(t->queued) {
+        size_t i = q->tail;
+        while(q->tasks[--i % QUEUE_CAP] != t) {
+        }
+        for(; i + 1 < q->tail; i++) {
+            q->tasks[i % QUEUE_CAP] = q->tasks[(i + 1) % QUEUE_CAP];
+        }
+        q->tail--;
+        t->queued = 0;
+        found = 1;
+    }
+    mutexUnlock(&q->lock);
+    if(found) {
+        atomicAdd(&pool.queued, -1);
+    }
+    return found;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI workerMain(void* arg) {
+#else
+static void* workerMain(void* arg) {
+#endif
+    ownQueue = arg;
+    for(;;) {
+        parTask* t = takeTask();
+        if(t) {
+            runTask(t);
+            continue;
+        }
+        mutexLock(&pool.idleLock);
+        while(!pool.stop && atomicLoad(&pool.queued) == 0) {
+            pool.sleeping++;
+            condWait(&pool.idle, &pool.idleLock);
+            pool.sleeping--;
+        }
+        int stop = pool.stop;
+        mutexUnlock(&pool.idleLock);
+        if(stop) {
+            break;
+        }
+    }
+    return 0;
+}
+
+// stops the first `started` workers and frees the pool
+static void stopWorkers(int started) {
+    mutexLock(&pool.idleLock);
+    pool.stop = 1;
+    condBroadcast(&pool.idle);
+    mutexUnlock(&pool.idleLock);
+    for(int i = 0; i < started; i++) {
+#if defined(_WIN32)
+        WaitForSingleObject(pool.threads[i], INFINITE);
+        CloseHandle(pool.threads[i]);
+#else
+        pthread_join(pool.threads[i], NULL);
+#endif
+    }
+    for(int i = 0; i <= pool.workers; i++) {
+        mutexFree(&pool.queues[i].lock);
+    }
+    mutexFree(&pool.idleLock);
+    condFree(&pool.idle);
+    YABI_FREE(pool.queues);
+    YABI_FREE(pool.threads);
+    pool.queues = NULL;
+    pool.threads = NULL;
+    pool.workers = 0;
+    pool.stop = 0;
+}
+
+static int startWorkers(int workers) {
+    pool.queues = YABI_CALLOC(workers + 1, sizeof(taskQueue));
+    pool.threads = YABI_CALLOC(workers, sizeof(taskThread));
+    if(!pool.queues || !pool.threads) {
+        YABI_FREE(pool.queues);
+        YABI_FREE(pool.threads);
+        pool.queues = NULL;
+        pool.threads = NULL;
+        return -1;
+    }
+    pool.workers = workers;
+    pool.sleeping = 0;
+    pool.queued = 0;
+    for(int i = 0; i <= workers; i++) {
+        mutexInit(&pool.queues[i].lock);
+    }
+    mutexInit(&pool.idleLock);
+    condInit(&pool.idle);
+    for(int i = 0; i < workers; i++) {
+#if defined(_WIN32)
+        pool.threads[i] = CreateThread(NULL, 0, workerMain, &pool.queues[i], 0, NULL);
+        int failed = pool.threads[i] == NULL;
+#else
+        int failed = pthread_create(&pool.threads[i], NULL, workerMain, &pool.queues[i]) != 0;
+#endif
+        if(failed) {
+            stopWorkers(i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#endif
+
+int yabi_set_threads(int n) {
+    atomicStore(&pool.on, 0);
+    pool.submit = NULL;
+    pool.ctx = NULL;
+#if defined(YABI_NO_THREADS)
+    return n > 1 ? -1 : 0;
+#else
+    if(pool.workers) {
+        stopWorkers(pool.workers);
+    }
+    if(n <= 1) {
+        return 0;
+    }
+    if(startWorkers(n - 1) != 0) {
+        return -1;
+    }
+    atomicStore(&pool.on, 1);
+    return 0;
+#endif
+}
+
+void yabi_set_executor(yabi_executor_fn submit, void* ctx) {
+    yabi_set_threads(0);
+    pool.submit = submit;
+    pool.ctx = ctx;
+    atomicStore(&pool.on, submit != NULL);
+}
+
+void forkTask(parTask* t, void (*run)(void* arg), void* arg) {
+    t->run = run;
+    t->arg = arg;
+    t->state = TASK_QUEUED;
+    t->claim = NULL;
+    t->home = NULL;
+    t->queued = 0;
+    if(pool.submit) {
+        taskClaim* c = YABI_MALLOC(sizeof(taskClaim));
+        if(c) {
+            c->run = run;
+            c->arg = arg;
+            c->state = TASK_QUEUED;
+            c->owners = 0;
+            t->claim = c;
+            pool.submit(runClaim, c, pool.ctx);
+            return;
+        }
+    }
+#if !defined(YABI_NO_THREADS)
+    if(pool.workers) {
+        taskQueue* q = ownQueue ? ownQueue : &pool.queues[pool.workers];
+        mutexLock(&q->lock);
+        if(q->tail - q->head < QUEUE_CAP) {
+            q->tasks[q->tail++ % QUEUE_CAP] = t;
+            t->home = q;
+            t->queued = 1;
+        }
+        mutexUnlock(&q->lock);
+        if(t->home) {
+            atomicAdd(&pool.queued, 1);
+            mutexLock(&pool.idleLock);
+            if(pool.sleeping) {
+                condSignal(&pool.idle);
+            }
+            mutexUnlock(&pool.idleLock);
+            return;
+        }
+    }
+#endif
+    // nowhere to put it, so it is done now
+    run(arg);
+    t->state = TASK_DONE;
+}
+
+void joinTask(parTask* t) {
+    if(t->claim) {
+        joinClaim(t->claim);
+        return;
+    }
+#if !defined(YABI_NO_THREADS)
+    if(t->home && unqueueTask(t)) {
+        runTask(t);
+        return;
+    }
+    while(atomicLoad(&t->state) != TASK_DONE) {
+        parTask* other = takeTask();
+        if(other) {
+            runTask(other);
+        } else {
+            yieldThread();
+        }
+    }
+#endif
+}
@@ -0,0 +1,191 @@
+#include "common.h"
+
+// Every batch operation against its ToBuf function, value by value, with
+// the batches as arrays of values, as columns and strided with gaps, and
+// results shorter than, as long as and longer than the operands. Counts
+// run past multiples of the widest vector, and the words between strided
+// values have to be left alone. Build from the top of the tree with, for
+// any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/batch.c -pthread
+
+#define GAP ((WordType)0xa5a5a5a5a5a5a5a5ull)
+
+enum { OP_ADD, OP_SUB, OP_MUL, OP_AND, OP_OR, OP_XOR, OP_COMPL, OP_CMP, OPS };
+
+static const char* opNames[OPS] = { "add", "sub", "mul", "and", "or", "xor", "compl", "cmp" };
+static const char* layoutNames[3] = { "values", "columns", "strided" };
+
+typedef struct {
+    size_t lane;
+    size_t word;
+    // words the batch spans
+    size_t size;
+} layout;
+
+static layout layoutOf(int kind, size_t count, size_t len) {
+    layout l;
+    if(kind == 0) {
+        l.lane = len;
+        l.word = 1;
+    } else if(kind == 1) {
+        l.lane = 1;
+        l.word = count;
+    } else {
+        l.lane = 2 * len + 1;
+        l.word = 2;
+    }
+    l.size = (count - 1) * l.lane + (len - 1) * l.word + 1;
+    return l;
+}
+
+// value i of a batch as a minimal BigInt
+static BigInt* valueOf(const WordType* data, layout l, size_t i, size_t len) {
+    WordType* w = malloc(len * sizeof(WordType));
+    for(size_t j = 0; j < len; j++) {
+        w[j] = data[i * l.lane + j * l.word];
+    }
+    BigInt* t = fromWords(len, w);
+    BigInt* v = yabi_add_si(t, 0);
+    yabi_release(t);
+    free(w);
+    return v;
+}
+
+static void runOp(int op, size_t count, size_t len, const yabi_batch_t* a, const yabi_batch_t* b,
+        size_t rlen, const yabi_batch_t* r, int8_t* c) {
+    switch(op) {
+    case OP_ADD: yabi_batch_add(count, len, a, b, rlen, r); break;
+    case OP_SUB: yabi_batch_sub(count, len, a, b, rlen, r); break;
+    case OP_MUL: yabi_batch_mul(count, len, a, b, rlen, r); break;
+    case OP_AND: yabi_batch_and(count, len, a, b, rlen, r); break;
+    case OP_OR: yabi_batch_or(count, len, a, b, rlen, r); break;
+    case OP_XOR: yabi_batch_xor(count, len, a, b, rlen, r); break;
+    case OP_COMPL: yabi_batch_compl(count, len, a, rlen, r); break;
+    default: yabi_batch_cmp(count, len, a, b, c); break;
+    }
+}
+
+static void refOp(int op, const BigInt* x, const BigInt* y, size_t rlen, WordType* buf) {
+    switch(op) {
+    case OP_ADD: yabi_addToBuf(x, y, rlen, buf); break;
+    case OP_SUB: yabi_subToBuf(x, y, rlen, buf); break;
+    case OP_MUL: yabi_mulToBuf(x, y, rlen, buf); break;
+    case OP_AND: yabi_andToBuf(x, y, rlen, buf); break;
+    case OP_OR: yabi_orToBuf(x, y, rlen, buf); break;
+    case OP_XOR: yabi_xorToBuf(x, y, rlen, buf); break;
+    default: yabi_complToBuf(x, rlen, buf); break;
+    }
+}
+
+static WordType* rndBatch(layout l) {
+    WordType* w = malloc(l.size * sizeof(WordType));
+    for(size_t i = 0; i < l.size; i++) {
+        w[i] = rndWord();
+    }
+    return w;
+}
+
+// whether word k of a batch belongs to one of its values
+static int inBatch(layout l, size_t count, size_t len, size_t k) {
+    if(l.word == 1 || l.lane == 1) {
+        return 1;
+    }
+    return k % l.lane < len * l.word && k % l.lane % l.word == 0 && k / l.lane < count;
+}
+
+static void testOp(int op, size_t count, size_t len, size_t rlen, int ka, int kb, int kr) {
+    layout la = layoutOf(ka, count, len);
+    layout lb = layoutOf(kb, count, len);
+    layout lr = layoutOf(kr, count, rlen);
+    WordType* a = rndBatch(la);
+    WordType* b = rndBatch(lb);
+    // some values equal, for the comparisons
+    for(size_t i = 0; i < count; i += 3) {
+        for(size_t j = 0; j < len; j++) {
+            b[i * lb.lane + j * lb.word] = a[i * la.lane + j * la.word];
+        }
+    }
+    WordType* r = malloc(lr.size * sizeof(WordType));
+    for(size_t k = 0; k < lr.size; k++) {
+        r[k] = GAP;
+    }
+    int8_t* c = malloc(count);
+    yabi_batch_t ba = { a, la.lane, la.word };
+    yabi_batch_t bb = { b, lb.lane, lb.word };
+    yabi_batch_t br = { r, lr.lane, lr.word };
+    runOp(op, count, len, &ba, &bb, rlen, &br, c);
+    WordType* buf = malloc(rlen * sizeof(WordType));
+    size_t bad = 0;
+    for(size_t i = 0; i < count && !bad; i++) {
+        BigInt* x = valueOf(a, la, i, len);
+        BigInt* y = valueOf(b, lb, i, len);
+        if(op == OP_CMP) {
+            int cmp = yabi_cmp(x, y);
+            bad = c[i] != (cmp > 0) - (cmp < 0) ? i + 1 : 0;
+        } else {
+            refOp(op, x, y, rlen, buf);
+            for(size_t j = 0; j < rlen; j++) {
+                if(r[i * lr.lane + j * lr.word] != buf[j]) {
+                    bad = i + 1;
+                }
+            }
+        }
+        yabi_release(x);
+        yabi_release(y);
+    }
+    CHECK(!bad, "batch %s of %zu values of %zu words into %zu, %s, %s into %s: value %zu differs", opNames[op],
+        count, len, rlen, layoutNames[ka], layoutNames[kb], layoutNames[kr], bad - 1);
+    if(op != OP_CMP) {
+        size_t k = 0;
+        while(k < lr.size && (inBatch(lr, count, rlen, k) || r[k] == GAP)) {
+            k++;
+        }
+        CHECK(k == lr.size, "batch %s of %zu values of %zu words into %zu, %s: wrote between values", opNames[op],
+            count, len, rlen, layoutNames[kr]);
+        // and into the first operand itself
+        if(rlen == len && ka == kr) {
+            memcpy(r, a, la.size * sizeof(WordType));
+            yabi_batch_t bi = { r, la.lane, la.word };
+            runOp(op, count, len, &bi, &bb, len, &bi, c);
+            int same = 1;
+            for(size_t i = 0; i < count && same; i++) {
+                BigInt* x = valueOf(a, la, i, len);
+                BigInt* y = valueOf(b, lb, i, len);
+                refOp(op, x, y, len, buf);
+                for(size_t j = 0; j < len; j++) {
+                    same = same && r[i * la.lane + j * la.word] == buf[j];
+                }
+                yabi_release(x);
+                yabi_release(y);
+            }
+            CHECK(same, "batch %s of %zu values of %zu words in place, %s", opNames[op], count, len, layoutNames[ka]);
+        }
+    }
+    free(buf);
+    free(c);
+    free(r);
+    free(b);
+    free(a);
+}
+
+int main(void) {
+    size_t vector = 64 / sizeof(WordType);
+    size_t counts[] = { 1, 3, vector - 1, vector, vector + 1, 2 * vector + 5, 37 };
+    size_t lens[] = { 1, 2, 3, 7, YABI_KARATSUBA_THRESHOLD + 1 };
+    int layouts[][3] = { { 0, 0, 0 }, { 1, 1, 1 }, { 2, 2, 2 }, { 0, 1, 2 }, { 2, 0, 1 }, { 1, 2, 0 } };
+    for(size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        for(size_t j = 0; j < sizeof(lens) / sizeof(lens[0]); j++) {
+            size_t len = lens[j];
+            size_t rlens[] = { len > 1 ? len - 1 : 1, len, len + 2, 2 * len };
+            for(size_t k = 0; k < sizeof(rlens) / sizeof(rlens[0]); k++) {
+                for(size_t m = 0; m < sizeof(layouts) / sizeof(layouts[0]); m++) {
+                    for(int op = 0; op < OPS; op++) {
+                        testOp(op, counts[i], len, rlens[k], layouts[m][0], layouts[m][1], layouts[m][2]);
+                    }
+                }
+            }
+        }
+    }
+    return finish("batch");
+}
@@ -0,0 +1,104 @@
+#ifndef YET_ANOTHER_BIGINT_TESTS_COMMON_H
+#define YET_ANOTHER_BIGINT_TESTS_COMMON_H
+
+#include "bigint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// shared helpers for the test drivers in this directory, in C or C++. Each
+// driver is a program of its own, built against the library sources at
+// whatever word size is being tested, and returns nonzero if any check
+// failed
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if(!(cond)) { \
+        failures++; \
+        printf("%s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while(0)
+
+static uint64_t rngState = 0x9e3779b97f4a7c15ull;
+
+static inline uint64_t rnd(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+// a random word, biased toward the patterns carries and normalization
+// trip over
+static inline WordType rndWord(void) {
+    uint64_t r = rnd();
+    switch(r % 8) {
+        case 0: return 0;
+        case 1: return (WordType)~(WordType)0;
+        case 2: return (WordType)1 << (YABI_WORD_BIT_SIZE - 1);
+        default: return (WordType)(r >> 8);
+    }
+}
+
+static inline BigInt* fromWords(size_t n, const WordType* words) {
+    BigInt* a = (BigInt*)YABI_NEW_BIGINT(n);
+    a->refCount = 0;
+    a->len = n;
+    a->cap = n;
+    memcpy(a->data, words, n * sizeof(WordType));
+    return a;
+}
+
+// a random n-word number. Its top word is nonzero and has a clear top bit,
+// so that it is really n words long, and it is negative if asked
+static inline BigInt* rndBigInt(size_t n, int negative) {
+    WordType* w = (WordType*)malloc(n * sizeof(WordType));
+    for(size_t i = 0; i < n; i++) {
+        w[i] = rndWord();
+    }
+    w[n - 1] &= (WordType)~((WordType)1 << (YABI_WORD_BIT_SIZE - 1));
+    if(w[n - 1] == 0) {
+        w[n - 1] = 1;
+    }
+    BigInt* a = fromWords(n, w);
+    free(w);
+    if(negative) {
+        BigInt* b = yabi_negate(a);
+        yabi_release(a);
+        a = b;
+    }
+    return a;
+}
+
+static inline int isNegative(const BigInt* a) {
+    return yabi_cmp_si(a, 0) < 0;
+}
+
+static inline BigInt* absOf(const BigInt* a) {
+    return isNegative(a) ? yabi_negate(a) : yabi_retain((BigInt*)a);
+}
+
+// a mod |m|, in [0, |m|)
+static inline BigInt* modOf(const BigInt* a, const BigInt* m) {
+    ydiv_t qr = yabi_div(a, m);
+    BigInt* r = qr.rem;
+    yabi_release(qr.quo);
+    if(isNegative(r)) {
+        BigInt* am = absOf(m);
+        BigInt* s = yabi_add(r, am);
+        yabi_release(am);
+        yabi_release(r);
+        r = s;
+    }
+    return r;
+}
+
+static inline int finish(const char* name) {
+    printf("%s, %d bit words: %s\n", name, YABI_WORD_BIT_SIZE, failures ? "FAILED" : "ok");
+    return failures != 0;
+}
+
+#endif
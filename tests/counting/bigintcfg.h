@@ -0,0 +1,20 @@
+#ifndef YET_ANOTHER_BIGINT_TESTS_COUNTING_CFG_H
+#define YET_ANOTHER_BIGINT_TESTS_COUNTING_CFG_H
+
+#include <stddef.h>
+
+// configuration for tests/workspace.c, which counts every allocation the
+// library makes. Put this directory before the top of the tree on the
+// include path so that it is found instead of the blank bigintcfg.h there
+
+#define YABI_COUNTED_ALLOCATIONS
+
+void* countedMalloc(size_t siz);
+void* countedCalloc(size_t n, size_t siz);
+void* countedRealloc(void* p, size_t siz);
+
+#define YABI_MALLOC(siz) (countedMalloc(siz))
+#define YABI_CALLOC(n, siz) (countedCalloc(n, siz))
+#define YABI_REALLOC(p, siz) (countedRealloc(p, siz))
+
+#endif
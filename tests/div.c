@@ -0,0 +1,205 @@
+#include "common.h"
+
+// Division on both sides of YABI_DC_DIV_THRESHOLD, where both the divisor
+// and the quotient have to be that long for the recursive division to take
+// over. Every quotient and remainder is checked against a = q * b + r with
+// |r| < |b| and r taking the sign of a, and division by a prepared divisor,
+// of one word or more, against yabi_div. Build from the top of the tree
+// with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/div.c -pthread
+
+// every form of division by a prepared divisor against qr, yabi_div of a
+static void checkPre(const BigInt* a, yabi_divisor_t* d, ydiv_t qr, const char* what) {
+    size_t blen = d->n;
+    ydiv_t pre = yabi_divPre(a, d);
+    CHECK(yabi_equal(pre.quo, qr.quo) && yabi_equal(pre.rem, qr.rem), "%s: divPre %zu / %zu words", what, a->len, blen);
+    BigInt* m = yabi_modPre(a, d);
+    CHECK(yabi_equal(m, qr.rem), "%s: modPre %zu / %zu words", what, a->len, blen);
+    size_t qlen = qr.quo->len;
+    size_t rlen = qr.rem->len;
+    WordType* q = malloc(qlen * sizeof(WordType));
+    WordType* r = malloc((rlen + 1) * sizeof(WordType));
+    ydiv_t lens = yabi_divPreToBuf(a, d, qlen, q, rlen, r);
+    CHECK(lens.qlen == qlen && memcmp(q, qr.quo->data, qlen * sizeof(WordType)) == 0, "%s: divPreToBuf quotient", what);
+    CHECK(lens.rlen == rlen && memcmp(r, qr.rem->data, rlen * sizeof(WordType)) == 0, "%s: divPreToBuf remainder", what);
+    // sign-extended, and truncated to a word
+    size_t len = yabi_modPreToBuf(a, d, rlen + 1, r);
+    WordType sign = isNegative(qr.rem) ? (WordType)~(WordType)0 : 0;
+    CHECK(len == rlen && memcmp(r, qr.rem->data, rlen * sizeof(WordType)) == 0 && r[rlen] == sign,
+        "%s: modPreToBuf %zu / %zu words", what, a->len, blen);
+    yabi_modPreToBuf(a, d, 1, r);
+    CHECK(r[0] == qr.rem->data[0], "%s: modPreToBuf into one word", what);
+    free(q);
+    free(r);
+    yabi_release(m);
+    yabi_release(pre.quo);
+    yabi_release(pre.rem);
+}
+
+static void checkDiv(const BigInt* a, const BigInt* b, const char* what) {
+    ydiv_t qr = yabi_div(a, b);
+    BigInt* p = yabi_mul(qr.quo, b);
+    BigInt* s = yabi_add(p, qr.rem);
+    CHECK(yabi_equal(s, a), "%s: %zu / %zu words, q * b + r != a", what, a->len, b->len);
+    BigInt* ar = absOf(qr.rem);
+    BigInt* ab = absOf(b);
+    CHECK(yabi_cmp(ar, ab) < 0, "%s: %zu / %zu words, |r| >= |b|", what, a->len, b->len);
+    int rzero = yabi_cmp_si(qr.rem, 0) == 0;
+    CHECK(rzero || isNegative(qr.rem) == isNegative(a), "%s: %zu / %zu words, sign of r", what, a->len, b->len);
+    // the ToBuf form with buffers just long enough, and a prepared divisor
+    size_t qlen = qr.quo->len;
+    size_t rlen = qr.rem->len;
+    WordType* q = malloc(qlen * sizeof(WordType));
+    WordType* r = malloc(rlen * sizeof(WordType));
+    ydiv_t lens = yabi_divToBuf(a, b, qlen, q, rlen, r);
+    CHECK(lens.qlen == qlen && memcmp(q, qr.quo->data, qlen * sizeof(WordType)) == 0, "%s: divToBuf quotient", what);
+    CHECK(lens.rlen == rlen && memcmp(r, qr.rem->data, rlen * sizeof(WordType)) == 0, "%s: divToBuf remainder", what);
+    yabi_divisor_t* d = yabi_divisor_init(b);
+    checkPre(a, d, qr, what);
+    yabi_divisor_free(d);
+    free(q);
+    free(r);
+    yabi_release(ar);
+    yabi_release(ab);
+    yabi_release(s);
+    yabi_release(p);
+    yabi_release(qr.quo);
+    yabi_release(qr.rem);
+}
+
+static void testDiv(size_t alen, size_t blen) {
+    for(int signs = 0; signs < 4; signs++) {
+        BigInt* a = rndBigInt(alen, signs & 1);
+        BigInt* b = rndBigInt(blen, signs >> 1 & 1);
+        checkDiv(a, b, "random");
+        yabi_release(a);
+        yabi_release(b);
+    }
+}
+
+// a = q * b + r for a chosen remainder, with a divisor whose top word is
+// all ones or just its top bit, so that every quotient word estimate is at
+// its limit or the remainder sits right below the divisor
+static void testEdges(size_t qlen, size_t blen) {
+    WordType* w = malloc(blen * sizeof(WordType));
+    for(int kind = 0; kind < 3; kind++) {
+        for(size_t i = 0; i < blen; i++) {
+            w[i] = kind == 0 ? (WordType)~(WordType)0 : kind == 1 ? 0 : rndWord();
+        }
+        w[blen - 1] = (WordType)((WordType)~(WordType)0 >> 1);
+        BigInt* b = fromWords(blen, w);
+        BigInt* q = rndBigInt(qlen, 0);
+        BigInt* p = yabi_mul(q, b);
+        // r = b - 1, the largest remainder
+        BigInt* r = yabi_sub_si(b, 1);
+        BigInt* a = yabi_add(p, r);
+        checkDiv(a, b, "edge");
+        BigInt* na = yabi_negate(a);
+        checkDiv(na, b, "edge");
+        yabi_release(na);
+        // exactly divisible
+        checkDiv(p, b, "exact");
+        yabi_release(a);
+        yabi_release(r);
+        yabi_release(p);
+        yabi_release(q);
+        yabi_release(b);
+    }
+    free(w);
+}
+
+// one prepared divisor used for dividends of every length, shorter than it
+// too, in no particular order
+static void testPrepared(size_t blen) {
+    for(int negative = 0; negative < 2; negative++) {
+        BigInt* b = rndBigInt(blen, negative);
+        yabi_divisor_t* d = yabi_divisor_init(b);
+        size_t alens[] = { blen + 40, 1, blen, 3 * blen + 2, blen > 1 ? blen - 1 : 2, blen + 1, 2 };
+        for(size_t i = 0; i < sizeof(alens) / sizeof(alens[0]); i++) {
+            BigInt* a = rndBigInt(alens[i], i & 1);
+            ydiv_t qr = yabi_div(a, b);
+            checkPre(a, d, qr, "prepared");
+            yabi_release(qr.quo);
+            yabi_release(qr.rem);
+            yabi_release(a);
+        }
+        yabi_divisor_free(d);
+        yabi_release(b);
+    }
+}
+
+// divisors of one word of magnitude at the edges of its range, which the
+// prepared divisor divides by a reciprocal of
+static void testOneWord(size_t alen) {
+    WordType top = (WordType)1 << (YABI_WORD_BIT_SIZE - 1);
+    WordType ws[] = { 1, 3, (WordType)(top - 1), top, (WordType)(top | 1), (WordType)~(WordType)0, rndWord() | 1 };
+    BigInt* t = rndBigInt(1, 0);
+    BigInt* zero = yabi_sub(t, t);
+    for(size_t i = 0; i < sizeof(ws) / sizeof(ws[0]); i++) {
+        for(int signs = 0; signs < 4; signs++) {
+            BigInt* b = signs >> 1 ? yabi_sub_ui(zero, ws[i]) : yabi_add_ui(zero, ws[i]);
+            BigInt* a = rndBigInt(alen, signs & 1);
+            checkDiv(a, b, "one word");
+            yabi_release(a);
+            yabi_release(b);
+        }
+    }
+    CHECK(yabi_divisor_init(zero) == NULL, "a prepared divisor of 0");
+    yabi_release(zero);
+    yabi_release(t);
+}
+
+// floored division by a native divisor, checked against a = q * d + r with
+// 0 <= r < d, which yabi_mod_ui has to agree with
+static void testDivmodUi(size_t alen) {
+    uint64_t ds[] = { 1, 3, 255, 1009, 65537, 4294967291u, 4294967311ull, 0xfffffffffffffffbull, rnd() | 1 };
+    for(size_t i = 0; i < sizeof(ds) / sizeof(ds[0]); i++) {
+        for(int negative = 0; negative < 2; negative++) {
+            BigInt* a = rndBigInt(alen, negative);
+            uint64_t r = 0;
+            BigInt* q = yabi_divmod_ui(a, ds[i], &r);
+            BigInt* p = yabi_mul_ui(q, ds[i]);
+            BigInt* s = yabi_add_ui(p, r);
+            CHECK(yabi_equal(s, a) && r < ds[i], "divmod_ui %zu words by %llu", alen, (unsigned long long)ds[i]);
+            CHECK(yabi_mod_ui(a, ds[i]) == r, "mod_ui %zu words by %llu", alen, (unsigned long long)ds[i]);
+            // a truncated quotient, and none at all
+            WordType w[2];
+            uint64_t r2 = r + 1;
+            size_t len = yabi_divmod_uiToBuf(a, ds[i], &r2, 1, w);
+            CHECK(len == 1 && w[0] == q->data[0] && r2 == r, "divmod_uiToBuf into one word");
+            r2 = r + 1;
+            CHECK(yabi_divmod_uiToBuf(a, ds[i], &r2, 0, w) == 0 && r2 == r, "divmod_uiToBuf into no words");
+            yabi_release(s);
+            yabi_release(p);
+            yabi_release(q);
+            yabi_release(a);
+        }
+    }
+}
+
+int main(void) {
+    size_t t = YABI_DC_DIV_THRESHOLD;
+    // below, at and above the threshold in each of divisor and quotient
+    size_t blens[] = { t - 1, t, t + 1, 2 * t + 3, 5 * t };
+    size_t qlens[] = { 1, t - 1, t, t + 1, 3 * t + 7 };
+    for(size_t i = 0; i < sizeof(blens) / sizeof(blens[0]); i++) {
+        for(size_t j = 0; j < sizeof(qlens) / sizeof(qlens[0]); j++) {
+            testDiv(blens[i] + qlens[j], blens[i]);
+        }
+        testEdges(2 * t + 1, blens[i]);
+    }
+    // a long quotient taken a block at a time
+    testDiv(12 * t + 5, 2 * t);
+    testDivmodUi(1);
+    testDivmodUi(9);
+    testDivmodUi(t + 3);
+    testOneWord(1);
+    testOneWord(5);
+    testOneWord(2 * t + 3);
+    size_t prepared[] = { 1, 2, t - 1, t, 3 * t };
+    for(size_t i = 0; i < sizeof(prepared) / sizeof(prepared[0]); i++) {
+        testPrepared(prepared[i]);
+    }
+    return finish("div");
+}
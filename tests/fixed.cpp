@@ -0,0 +1,133 @@
+#include "common.h"
+#include "bigint_fixed.hpp"
+
+// yabi::fixed at 128, 256 and 512 bits, signed and unsigned, against the
+// ToBuf functions with as many words, which a fixed has to match word for
+// word. The static_asserts keep division and shifts usable in constant
+// expressions. Build from the top of the tree with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. -c src/*.c
+//     c++ -std=c++17 -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. tests/fixed.cpp *.o -pthread
+
+using yabi::int128;
+using yabi::uint128;
+using yabi::int256;
+using yabi::uint512;
+
+constexpr int256 twoTo200 = int256(1) << 200;
+static_assert(twoTo200 / 12345 * 12345 + twoTo200 % 12345 == twoTo200, "constexpr division of int256");
+static_assert(int128(-7) / 2 == -3 && int128(-7) % 2 == -1, "constexpr division rounds toward zero");
+static_assert(int128(5) / 0 == 0, "constexpr division by 0");
+static_assert((int128(-7) >> 1) == -4 && (int128(-1) >> 300) == -1, "constexpr arithmetic right shift");
+static_assert((uint128(-1) >> 127) == 1 && (uint128(1) << 128) == 0, "constexpr logical shifts");
+static_assert((uint512(1) << 511) / (uint512(1) << 255) == uint512(1) << 256, "constexpr division of uint512");
+static_assert(int256(twoTo200 >> 190) == 1024, "constexpr shift right");
+
+// random words, or one of the values at the edges of the type
+template<class F>
+static F rndFixed() {
+    F x;
+    switch(rnd() % 8) {
+    case 0:
+        return F(0);
+    case 1:
+        return F(1);
+    case 2:
+        return ~F(0);
+    case 3:
+        return F(1) << (F::bits - 1);
+    case 4:
+        return ~(F(1) << (F::bits - 1));
+    case 5:
+        // short, so that divisions have long quotients
+        return F(rnd() >> (rnd() % 64));
+    default:
+        for(size_t i = 0; i < F::words; i++) {
+            x.data[i] = rndWord();
+        }
+        return x;
+    }
+}
+
+template<class F>
+static bool sameWords(const F& x, const WordType* buffer) {
+    return memcmp(x.data, buffer, sizeof(x.data)) == 0;
+}
+
+// the low 64 bits of a's two's complement
+static uint64_t lowBits(const BigInt* a) {
+    uint64_t x = 0;
+    WordType fill = isNegative(a) ? (WordType)~(WordType)0 : 0;
+    for(size_t i = 0; i * YABI_WORD_BIT_SIZE < 64; i++) {
+        x |= (uint64_t)(i < a->len ? a->data[i] : fill) << (i * YABI_WORD_BIT_SIZE % 64);
+    }
+    return x;
+}
+
+template<size_t Bits, bool Signed>
+static void testWidth(int rounds) {
+    typedef yabi::fixed<Bits, Signed> F;
+    const size_t n = F::words;
+    const char* kind = Signed ? "signed" : "unsigned";
+    WordType buf[F::words];
+    WordType rest[F::words];
+    for(int round = 0; round < rounds; round++) {
+        F a = rndFixed<F>();
+        F b = rndFixed<F>();
+        BigInt* x = a.to_big();
+        BigInt* y = b.to_big();
+        // the value goes to a BigInt and back unchanged
+        F back(x);
+        CHECK(back == a && x->len == a.min_len(), "%zu bit %s: to_big and back", Bits, kind);
+        CHECK(a.negative() == isNegative(x), "%zu bit %s: sign", Bits, kind);
+        CHECK(a.to_buf(n, buf) == (x->len < n ? x->len : n) && sameWords(a, buf), "%zu bit %s: to_buf", Bits, kind);
+        yabi_addToBuf(x, y, n, buf);
+        CHECK(sameWords(a + b, buf), "%zu bit %s: +", Bits, kind);
+        yabi_subToBuf(x, y, n, buf);
+        CHECK(sameWords(a - b, buf), "%zu bit %s: -", Bits, kind);
+        yabi_mulToBuf(x, y, n, buf);
+        CHECK(sameWords(a * b, buf), "%zu bit %s: *", Bits, kind);
+        yabi_negateToBuf(x, n, buf);
+        CHECK(sameWords(-a, buf), "%zu bit %s: unary -", Bits, kind);
+        yabi_andToBuf(x, y, n, buf);
+        CHECK(sameWords(a & b, buf), "%zu bit %s: &", Bits, kind);
+        yabi_orToBuf(x, y, n, buf);
+        CHECK(sameWords(a | b, buf), "%zu bit %s: |", Bits, kind);
+        yabi_xorToBuf(x, y, n, buf);
+        CHECK(sameWords(a ^ b, buf), "%zu bit %s: ^", Bits, kind);
+        yabi_complToBuf(x, n, buf);
+        CHECK(sameWords(~a, buf), "%zu bit %s: ~", Bits, kind);
+        if(b) {
+            yabi_divToBuf(x, y, n, buf, n, rest);
+            CHECK(sameWords(a / b, buf), "%zu bit %s: /", Bits, kind);
+            CHECK(sameWords(a % b, rest), "%zu bit %s: %%", Bits, kind);
+        } else {
+            CHECK(!(a / b) && !(a % b), "%zu bit %s: division by 0", Bits, kind);
+        }
+        size_t amts[] = { 0, 1, YABI_WORD_BIT_SIZE - 1, YABI_WORD_BIT_SIZE, YABI_WORD_BIT_SIZE + 1,
+            Bits / 2 + 3, Bits - 1, Bits, Bits + 5 };
+        for(size_t i = 0; i < sizeof(amts) / sizeof(amts[0]); i++) {
+            yabi_lshiftToBuf(x, amts[i], n, buf);
+            CHECK(sameWords(a << amts[i], buf), "%zu bit %s: << %zu", Bits, kind, amts[i]);
+            yabi_rshiftToBuf(x, amts[i], n, buf);
+            CHECK(sameWords(a >> amts[i], buf), "%zu bit %s: >> %zu", Bits, kind, amts[i]);
+        }
+        int c = yabi_cmp(x, y);
+        CHECK((a < b) == (c < 0) && (a == b) == (c == 0) && (a > b) == (c > 0), "%zu bit %s: comparison", Bits, kind);
+        CHECK((a <= b) == (c <= 0) && (a >= b) == (c >= 0) && (a != b) == (c != 0), "%zu bit %s: comparison", Bits, kind);
+        // the low 64 bits, as a native conversion takes them
+        CHECK((uint64_t)a == lowBits(x), "%zu bit %s: conversion to uint64_t", Bits, kind);
+        yabi_release(x);
+        yabi_release(y);
+    }
+}
+
+int main() {
+    testWidth<128, true>(2000);
+    testWidth<128, false>(2000);
+    testWidth<256, true>(1000);
+    testWidth<256, false>(1000);
+    testWidth<512, true>(500);
+    testWidth<512, false>(500);
+    return finish("fixed");
+}
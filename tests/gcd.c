@@ -0,0 +1,153 @@
+#include "common.h"
+
+// gcd, gcdext and invert on operands long enough for Lehmer steps, on
+// unbalanced ones whose first quotient is too large for a Lehmer step and
+// falls back to a Euclid step, and on every combination of signs. Build
+// from the top of the tree with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/gcd.c -pthread
+
+static int divides(const BigInt* d, const BigInt* a) {
+    if(yabi_cmp_si(d, 0) == 0) {
+        return yabi_cmp_si(a, 0) == 0;
+    }
+    ydiv_t qr = yabi_div(a, d);
+    int ok = yabi_cmp_si(qr.rem, 0) == 0;
+    yabi_release(qr.quo);
+    yabi_release(qr.rem);
+    return ok;
+}
+
+static void checkGcd(const BigInt* a, const BigInt* b, const char* what) {
+    BigInt* g = yabi_gcd(a, b);
+    CHECK(!isNegative(g), "%s: %zu, %zu words, negative gcd", what, a->len, b->len);
+    CHECK(divides(g, a) && divides(g, b), "%s: %zu, %zu words, gcd does not divide", what, a->len, b->len);
+    // the gcd of the cofactors is 1 only if g is the greatest divisor
+    if(yabi_cmp_si(g, 0) != 0) {
+        ydiv_t x = yabi_div(a, g);
+        ydiv_t y = yabi_div(b, g);
+        BigInt* h = yabi_gcd(x.quo, y.quo);
+        CHECK(yabi_cmp_si(h, 1) == 0, "%s: %zu, %zu words, gcd is not the greatest", what, a->len, b->len);
+        yabi_release(h);
+        yabi_release(x.quo);
+        yabi_release(x.rem);
+        yabi_release(y.quo);
+        yabi_release(y.rem);
+    }
+    // the ToBuf form
+    size_t len = g->len;
+    WordType* buf = malloc(len * sizeof(WordType));
+    CHECK(yabi_gcdToBuf(a, b, len, buf) == len && memcmp(buf, g->data, len * sizeof(WordType)) == 0, "%s: gcdToBuf", what);
+    free(buf);
+    // gcd = a * s + b * t, with a cofactor no larger than the other operand
+    BigInt* s;
+    BigInt* t;
+    BigInt* e = yabi_gcdext(a, b, &s, &t);
+    CHECK(yabi_equal(e, g), "%s: %zu, %zu words, gcdext gives another gcd", what, a->len, b->len);
+    BigInt* as = yabi_mul(a, s);
+    BigInt* bt = yabi_mul(b, t);
+    BigInt* sum = yabi_add(as, bt);
+    CHECK(yabi_equal(sum, g), "%s: %zu, %zu words, a * s + b * t != gcd", what, a->len, b->len);
+    BigInt* sabs = absOf(s);
+    BigInt* babs = absOf(b);
+    CHECK(yabi_cmp_si(b, 0) == 0 || yabi_cmp(sabs, babs) <= 0, "%s: %zu, %zu words, |s| > |b|", what, a->len, b->len);
+    yabi_release(sabs);
+    yabi_release(babs);
+    yabi_release(sum);
+    yabi_release(as);
+    yabi_release(bt);
+    yabi_release(s);
+    yabi_release(t);
+    yabi_release(e);
+    yabi_release(g);
+}
+
+static void checkInvert(const BigInt* a, const BigInt* m, const char* what) {
+    BigInt* g = yabi_gcd(a, m);
+    BigInt* inv = yabi_invert(a, m);
+    BigInt* mabs = absOf(m);
+    if(yabi_cmp_si(g, 1) != 0) {
+        CHECK(inv == NULL, "%s: %zu, %zu words, inverse without one", what, a->len, m->len);
+    } else if(!inv) {
+        CHECK(0, "%s: %zu, %zu words, no inverse", what, a->len, m->len);
+    } else {
+        CHECK(!isNegative(inv) && yabi_cmp(inv, mabs) < 0, "%s: %zu, %zu words, inverse out of range", what, a->len, m->len);
+        BigInt* p = yabi_mul(a, inv);
+        BigInt* r = modOf(p, m);
+        int one = yabi_cmp_si(mabs, 1) == 0 ? yabi_cmp_si(r, 0) == 0 : yabi_cmp_si(r, 1) == 0;
+        CHECK(one, "%s: %zu, %zu words, a * inverse != 1", what, a->len, m->len);
+        yabi_release(r);
+        yabi_release(p);
+    }
+    yabi_release(mabs);
+    yabi_release(inv);
+    yabi_release(g);
+}
+
+static void testPair(size_t alen, size_t blen) {
+    for(int signs = 0; signs < 4; signs++) {
+        BigInt* a = rndBigInt(alen, signs & 1);
+        BigInt* b = rndBigInt(blen, signs >> 1 & 1);
+        checkGcd(a, b, "random");
+        checkGcd(b, a, "random");
+        checkInvert(a, b, "random");
+        checkInvert(b, a, "random");
+        // a common factor, so the gcd is more than a word
+        BigInt* c = rndBigInt(alen / 2 + 1, 0);
+        BigInt* ac = yabi_mul(a, c);
+        BigInt* bc = yabi_mul(b, c);
+        checkGcd(ac, bc, "common factor");
+        checkInvert(ac, bc, "common factor");
+        yabi_release(ac);
+        yabi_release(bc);
+        yabi_release(c);
+        yabi_release(a);
+        yabi_release(b);
+    }
+}
+
+int main(void) {
+    // balanced, which Lehmer steps take through the whole way
+    testPair(3, 3);
+    testPair(40, 40);
+    testPair(150, 149);
+    // unbalanced, where the first quotient needs a Euclid step
+    testPair(120, 5);
+    testPair(90, 30);
+    // consecutive Fibonacci numbers, every quotient 1
+    BigInt* f0 = rndBigInt(1, 0);
+    BigInt* f1 = rndBigInt(1, 0);
+    for(int i = 0; i < 2000; i++) {
+        BigInt* f2 = yabi_add(f0, f1);
+        yabi_release(f0);
+        f0 = f1;
+        f1 = f2;
+    }
+    checkGcd(f1, f0, "fibonacci");
+    checkInvert(f0, f1, "fibonacci");
+    yabi_release(f0);
+    yabi_release(f1);
+    // zero, one and a negative modulus
+    BigInt* a = rndBigInt(20, 1);
+    BigInt* zero = yabi_sub(a, a);
+    BigInt* one = yabi_add_si(zero, 1);
+    BigInt* minusOne = yabi_sub_si(zero, 1);
+    checkGcd(a, zero, "zero");
+    checkGcd(zero, a, "zero");
+    checkGcd(zero, zero, "zero");
+    checkGcd(a, minusOne, "minus one");
+    CHECK(yabi_invert(a, zero) == NULL, "inverse modulo 0");
+    checkInvert(a, one, "modulo 1");
+    checkInvert(a, minusOne, "modulo -1");
+    BigInt* m = rndBigInt(25, 1);
+    checkInvert(a, m, "negative modulus");
+    BigInt* am = yabi_negate(a);
+    checkInvert(am, m, "negative modulus");
+    yabi_release(am);
+    yabi_release(m);
+    yabi_release(minusOne);
+    yabi_release(one);
+    yabi_release(zero);
+    yabi_release(a);
+    return finish("gcd");
+}
@@ -0,0 +1,254 @@
+#include "common.h"
+#include "bigint.hpp"
+
+// yabi::Integer against the C functions: the fused a * b + c * d - e on
+// both sides of YABI_KARATSUBA_THRESHOLD, expressions that read the Integer
+// they are assigned to, a value shared by to_big that has to stay as it
+// was, and values growing past YABI_INTEGER_INLINE_WORDS and shrinking back.
+// Build from the top of the tree with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. -c src/*.c
+//     c++ -std=c++17 -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. tests/integer.cpp *.o -pthread
+
+using yabi::Integer;
+
+// checks x against ref, which it releases
+static bool same(const Integer& x, BigInt* ref) {
+    bool ok = yabi_equal(x.get(), ref);
+    yabi_release(ref);
+    return ok;
+}
+
+static Integer rndInteger(size_t n, int negative) {
+    return Integer::from_big(rndBigInt(n, negative));
+}
+
+// a * b + c * d - e
+static BigInt* refFused(const BigInt* a, const BigInt* b, const BigInt* c, const BigInt* d, const BigInt* e) {
+    BigInt* ab = yabi_mul(a, b);
+    BigInt* cd = yabi_mul(c, d);
+    BigInt* s = yabi_add(ab, cd);
+    BigInt* res = yabi_sub(s, e);
+    yabi_release(s);
+    yabi_release(cd);
+    yabi_release(ab);
+    return res;
+}
+
+static void testFused(size_t n, size_t m) {
+    for(int signs = 0; signs < 8; signs++) {
+        Integer a = rndInteger(n, signs & 1);
+        Integer b = rndInteger(m, signs >> 1 & 1);
+        Integer c = rndInteger(m, signs >> 2 & 1);
+        Integer d = rndInteger(n + 1, signs & 1);
+        Integer e = rndInteger(n + m, signs >> 1 & 1);
+        Integer x = a * b + c * d - e;
+        CHECK(same(x, refFused(a.get(), b.get(), c.get(), d.get(), e.get())), "a * b + c * d - e, %zu and %zu words", n, m);
+        // into a destination that already holds something long
+        Integer y = rndInteger(3 * (n + m), 1);
+        y = a * b + c * d - e;
+        CHECK(y == x, "a * b + c * d - e over a longer value, %zu and %zu words", n, m);
+        // the product on the left, and subtracted
+        y = c * d + e;
+        BigInt* cd = yabi_mul(c.get(), d.get());
+        CHECK(same(y, yabi_add(cd, e.get())), "c * d + e, %zu and %zu words", n, m);
+        y = e - c * d;
+        CHECK(same(y, yabi_sub(e.get(), cd)), "e - c * d, %zu and %zu words", n, m);
+        yabi_release(cd);
+        // squares, which go through yabi_sqrToBuf
+        y = a * a + b;
+        BigInt* aa = yabi_sqr(a.get());
+        CHECK(same(y, yabi_add(aa, b.get())), "a * a + b, %zu words", n);
+        yabi_release(aa);
+    }
+}
+
+// expressions that read the Integer they are assigned to
+static void testAliasing(size_t n) {
+    Integer a = rndInteger(n, 0);
+    Integer d = rndInteger(n + 2, 1);
+    Integer y = rndInteger(n / 2 + 1, 1);
+    Integer x = rndInteger(n + 1, 0);
+    BigInt* ref = x.to_big();
+    x -= x * y;
+    BigInt* p = yabi_mul(ref, y.get());
+    BigInt* next = yabi_sub(ref, p);
+    CHECK(yabi_equal(x.get(), next), "x -= x * y, %zu words", n);
+    yabi_release(p);
+    yabi_release(ref);
+    ref = next;
+    x = a * d + x * d;
+    BigInt* ad = yabi_mul(a.get(), d.get());
+    BigInt* xd = yabi_mul(ref, d.get());
+    next = yabi_add(ad, xd);
+    CHECK(yabi_equal(x.get(), next), "x = a * d + x * d, %zu words", n);
+    yabi_release(xd);
+    yabi_release(ad);
+    yabi_release(ref);
+    ref = next;
+    x = x * x;
+    next = yabi_sqr(ref);
+    CHECK(yabi_equal(x.get(), next), "x = x * x, %zu words", n);
+    yabi_release(ref);
+    ref = next;
+    x = (x + a) * (x - a);
+    BigInt* s = yabi_add(ref, a.get());
+    BigInt* t = yabi_sub(ref, a.get());
+    next = yabi_mul(s, t);
+    CHECK(yabi_equal(x.get(), next), "x = (x + a) * (x - a), %zu words", n);
+    yabi_release(s);
+    yabi_release(t);
+    yabi_release(ref);
+    ref = next;
+    x += x;
+    next = yabi_add(ref, ref);
+    CHECK(yabi_equal(x.get(), next), "x += x, %zu words", n);
+    yabi_release(ref);
+    ref = next;
+    x = -x;
+    next = yabi_negate(ref);
+    CHECK(yabi_equal(x.get(), next), "x = -x, %zu words", n);
+    yabi_release(ref);
+    ref = next;
+    ydiv_t qr = yabi_div(ref, a.get());
+    x %= a;
+    CHECK(yabi_equal(x.get(), qr.rem), "x %%= a, %zu words", n);
+    yabi_release(qr.quo);
+    yabi_release(qr.rem);
+    yabi_release(ref);
+}
+
+// a value shared through to_big keeps its value whatever the Integer does
+// afterwards
+static void testShared(size_t n) {
+    Integer x = rndInteger(n, 1);
+    Integer a = rndInteger(n, 0);
+    Integer b = rndInteger(n / 2 + 1, 1);
+    BigInt* shared = x.to_big();
+    BigInt* copy = yabi_add_si(shared, 0);
+    x += 1;
+    CHECK(yabi_equal(shared, copy), "x += 1 changed a shared value of %zu words", n);
+    CHECK(same(x, yabi_add_si(copy, 1)), "x += 1 after to_big, %zu words", n);
+    yabi_release(shared);
+    shared = x.to_big();
+    yabi_release(copy);
+    copy = yabi_add_si(shared, 0);
+    x += a * b;
+    CHECK(yabi_equal(shared, copy), "x += a * b changed a shared value of %zu words", n);
+    BigInt* ab = yabi_mul(a.get(), b.get());
+    CHECK(same(x, yabi_add(copy, ab)), "x += a * b after to_big, %zu words", n);
+    yabi_release(ab);
+    yabi_release(shared);
+    shared = x.to_big();
+    yabi_release(copy);
+    copy = yabi_add_si(shared, 0);
+    x <<= 3 * YABI_WORD_BIT_SIZE + 1;
+    x = a;
+    x.reserve(4 * n);
+    CHECK(yabi_equal(shared, copy), "shifts, assignments and reserve changed a shared value of %zu words", n);
+    CHECK(x == a, "x = a after to_big, %zu words", n);
+    // and the copy constructor shares nothing either
+    Integer y = x;
+    y -= a;
+    CHECK(x == a && y.sign() == 0, "a copy changed the Integer it came from, %zu words", n);
+    yabi_release(shared);
+    yabi_release(copy);
+}
+
+// x = x * k + 1 until it is many times the inline storage, and back down
+// by division, in step with the C functions
+static void testGrowth(void) {
+    Integer x = 1;
+    BigInt* ref = yabi_add_si(x.get(), 0);
+    Integer k = rndInteger(1, 0) + 3;
+    size_t steps = 0;
+    while(ref->len <= 12 * Integer::inline_words) {
+        x = x * k + 1;
+        BigInt* p = yabi_mul(ref, k.get());
+        yabi_release(ref);
+        ref = yabi_add_si(p, 1);
+        yabi_release(p);
+        steps++;
+        if(!yabi_equal(x.get(), ref)) {
+            CHECK(0, "x * k + 1 at %zu words", ref->len);
+            break;
+        }
+    }
+    Integer big = x;
+    while(steps-- > 0) {
+        x /= k;
+        ydiv_t qr = yabi_div(ref, k.get());
+        yabi_release(qr.rem);
+        yabi_release(ref);
+        ref = qr.quo;
+        if(!yabi_equal(x.get(), ref)) {
+            CHECK(0, "x / k at %zu words", ref->len);
+            break;
+        }
+    }
+    CHECK(x == 1, "growing and shrinking back does not end at 1");
+    yabi_release(ref);
+    // strings and moves of values on both sides of the inline storage
+    char* str = yabi_toStr(big.get());
+    CHECK(big.to_string() == str, "to_string of %zu words", big.get()->len);
+    Integer back(str);
+    CHECK(back == big, "Integer from a string of %zu words", big.get()->len);
+    YABI_FREE(str);
+    Integer moved = std::move(back);
+    CHECK(moved == big && back.sign() == 0, "moving %zu words", big.get()->len);
+    Integer small = 12345;
+    moved = std::move(small);
+    CHECK(moved == 12345, "moving an inline value over a heap one");
+}
+
+// the other operators, and native integers at their limits
+static void testOperators(size_t n, size_t m) {
+    Integer a = rndInteger(n, 1);
+    Integer b = rndInteger(m, 0);
+    Integer x;
+    x = a / b;
+    ydiv_t qr = yabi_div(a.get(), b.get());
+    CHECK(yabi_equal(x.get(), qr.quo), "a / b, %zu / %zu words", n, m);
+    x = a % b;
+    CHECK(yabi_equal(x.get(), qr.rem), "a %% b, %zu / %zu words", n, m);
+    yabi_release(qr.quo);
+    yabi_release(qr.rem);
+    x = a & b;
+    CHECK(same(x, yabi_and(a.get(), b.get())), "a & b, %zu and %zu words", n, m);
+    x = a | b;
+    CHECK(same(x, yabi_or(a.get(), b.get())), "a | b, %zu and %zu words", n, m);
+    x = a ^ b;
+    CHECK(same(x, yabi_xor(a.get(), b.get())), "a ^ b, %zu and %zu words", n, m);
+    x = ~a;
+    CHECK(same(x, yabi_compl(a.get())), "~a, %zu words", n);
+    x = a << 37;
+    CHECK(same(x, yabi_lshift(a.get(), 37)), "a << 37, %zu words", n);
+    x = a >> 37;
+    CHECK(same(x, yabi_rshift(a.get(), 37)), "a >> 37, %zu words", n);
+    x = a / 0;
+    CHECK(x.sign() == 0, "a / 0 is not 0");
+    x = a * INT64_MIN + UINT64_MAX;
+    BigInt* p = yabi_mul_si(a.get(), INT64_MIN);
+    CHECK(same(x, yabi_add_ui(p, UINT64_MAX)), "a * INT64_MIN + UINT64_MAX, %zu words", n);
+    yabi_release(p);
+}
+
+int main() {
+    size_t inl = Integer::inline_words;
+    size_t t = YABI_KARATSUBA_THRESHOLD;
+    // inline, on the heap, and products past the fused range
+    testFused(1, 1);
+    testFused(inl / 2, inl / 2);
+    testFused(inl, 3);
+    testFused(t - 1, t - 1);
+    testFused(t, t);
+    testFused(2 * t + 3, t + 1);
+    size_t lens[] = { 1, inl - 1, inl + 1, t + 5, 3 * t };
+    for(size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        testAliasing(lens[i]);
+        testShared(lens[i]);
+        testOperators(lens[i] + 2, lens[i]);
+    }
+    testGrowth();
+    return finish("integer");
+}
@@ -0,0 +1,191 @@
+#include "common.h"
+
+// The _into functions and yabi_addmul/yabi_submul against the functions
+// that allocate their result: into a NULL *dst, into one with room to
+// spare, which has to stay where it is, into one that has to grow, and
+// with *dst as one or both of the operands. addmul and submul are checked
+// on both sides of YABI_KARATSUBA_THRESHOLD, where they stop fusing the
+// product into the sum. Build from the top of the tree with, for any word
+// size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/into.c -pthread
+
+enum { OP_ADD, OP_SUB, OP_MUL, OP_AND, OP_XOR, OP_ADDMUL, OP_SUBMUL, OPS };
+
+static const char* opNames[OPS] = { "add_into", "sub_into", "mul_into", "and_into", "xor_into", "addmul", "submul" };
+
+// what *dst should hold after op, computed without it being reused
+static BigInt* refOp(int op, const BigInt* d, const BigInt* a, const BigInt* b) {
+    BigInt* p;
+    BigInt* res;
+    switch(op) {
+    case OP_ADD: return yabi_add(a, b);
+    case OP_SUB: return yabi_sub(a, b);
+    case OP_MUL: return yabi_mul(a, b);
+    case OP_AND: return yabi_and(a, b);
+    case OP_XOR: return yabi_xor(a, b);
+    default:
+        p = yabi_mul(a, b);
+        res = op == OP_ADDMUL ? yabi_add(d, p) : yabi_sub(d, p);
+        yabi_release(p);
+        return res;
+    }
+}
+
+static BigInt* runOp(int op, BigInt** dst, const BigInt* a, const BigInt* b) {
+    switch(op) {
+    case OP_ADD: return yabi_add_into(dst, a, b);
+    case OP_SUB: return yabi_sub_into(dst, a, b);
+    case OP_MUL: return yabi_mul_into(dst, a, b);
+    case OP_AND: return yabi_and_into(dst, a, b);
+    case OP_XOR: return yabi_xor_into(dst, a, b);
+    case OP_ADDMUL: return yabi_addmul(dst, a, b);
+    default: return yabi_submul(dst, a, b);
+    }
+}
+
+static BigInt* copyOf(const BigInt* a) {
+    return yabi_add_si(a, 0);
+}
+
+// *dst of dlen words, or NULL for 0, with extra words of room
+static BigInt* withRoom(size_t dlen, size_t extra) {
+    if(dlen == 0) {
+        return NULL;
+    }
+    BigInt* d = rndBigInt(dlen, rnd() & 1);
+    if(extra) {
+        BigInt* big = NULL;
+        BigInt* wide = rndBigInt(dlen + extra, 0);
+        yabi_add_into(&big, wide, wide);
+        yabi_release(wide);
+        yabi_add_into(&big, d, d);
+        yabi_rshift_into(&big, big, 1);
+        yabi_release(d);
+        d = big;
+    }
+    return d;
+}
+
+static void testOp(int op, size_t dlen, size_t extra, size_t alen, size_t blen) {
+    for(int signs = 0; signs < 4; signs++) {
+        BigInt* a = rndBigInt(alen, signs & 1);
+        BigInt* b = rndBigInt(blen, signs >> 1 & 1);
+        BigInt* d = withRoom(dlen, extra);
+        // a NULL *dst counts as 0
+        BigInt* base = d ? copyOf(d) : yabi_sub(a, a);
+        BigInt* ref = refOp(op, base, a, b);
+        yabi_release(base);
+        BigInt* old = d;
+        size_t cap = d ? d->cap : 0;
+        BigInt* res = runOp(op, &d, a, b);
+        CHECK(res == d && yabi_equal(d, ref), "%s into %zu words, %zu and %zu words", opNames[op], dlen, alen, blen);
+        // a *dst with room is written where it is, and never shrinks
+        size_t need = op == OP_MUL ? alen + blen : op >= OP_ADDMUL ? (dlen > alen + blen ? dlen : alen + blen) + 1
+            : (alen > blen ? alen : blen) + 1;
+        if(old && cap >= need) {
+            CHECK(d == old && d->cap == cap, "%s into %zu words of room moved or shrank it", opNames[op], cap);
+        }
+        CHECK(d->cap >= d->len && d->cap >= cap, "%s into %zu words: capacity %zu", opNames[op], dlen, d->cap);
+        yabi_release(ref);
+        yabi_release(d);
+        yabi_release(a);
+        yabi_release(b);
+    }
+}
+
+// *dst as the first, the second and both operands, with and without room
+static void testAliased(int op, size_t alen, size_t blen, size_t extra) {
+    BigInt* a = rndBigInt(alen, 1);
+    BigInt* b = rndBigInt(blen, 0);
+    BigInt* d = withRoom(alen, extra);
+    BigInt* saved = copyOf(d);
+    BigInt* ref = refOp(op, saved, saved, b);
+    runOp(op, &d, d, b);
+    CHECK(yabi_equal(d, ref), "%s with *dst as a, %zu and %zu words, %zu spare", opNames[op], alen, blen, extra);
+    yabi_release(ref);
+    yabi_release(saved);
+    saved = copyOf(d);
+    ref = refOp(op, saved, a, saved);
+    runOp(op, &d, a, d);
+    CHECK(yabi_equal(d, ref), "%s with *dst as b, %zu and %zu words, %zu spare", opNames[op], alen, blen, extra);
+    yabi_release(ref);
+    yabi_release(saved);
+    saved = copyOf(d);
+    ref = refOp(op, saved, saved, saved);
+    runOp(op, &d, d, d);
+    CHECK(yabi_equal(d, ref), "%s with *dst as both, %zu words, %zu spare", opNames[op], d->len, extra);
+    yabi_release(ref);
+    yabi_release(saved);
+    yabi_release(d);
+    yabi_release(a);
+    yabi_release(b);
+}
+
+// a value growing a word at a time is only reallocated every so often
+static void testGrowth(void) {
+    BigInt* d = NULL;
+    BigInt* one = rndBigInt(1, 0);
+    yabi_add_into(&d, one, one);
+    size_t moves = 0;
+    for(int i = 0; i < 1000; i++) {
+        size_t cap = d->cap;
+        yabi_lshift_into(&d, d, YABI_WORD_BIT_SIZE);
+        moves += d->cap != cap;
+    }
+    CHECK(moves < 40, "growing a word at a time reallocated %zu times in 1000", moves);
+    BigInt* ref = yabi_lshift(one, 1000 * YABI_WORD_BIT_SIZE);
+    BigInt* twice = yabi_add(ref, ref);
+    CHECK(yabi_equal(d, twice), "growing a word at a time");
+    yabi_release(twice);
+    yabi_release(ref);
+    yabi_release(one);
+    yabi_release(d);
+}
+
+// 805745a: a BigInt shrunk by YABI_RESIZE_BIGINT, which only has to set
+// len, kept the capacity it had before, so that the next _into call wrote
+// past its end. The default macro is such a resize, and the writes are
+// caught by -fsanitize=address
+static void testShrunkCapacity(void) {
+    for(size_t n = 2; n < 80; n += 7) {
+        BigInt* a = rndBigInt(n, 0);
+        BigInt* na = yabi_negate(a);
+        BigInt* r = yabi_add_si(na, 1);
+        // a + (1 - a) shrinks from n + 1 words to 1
+        BigInt* s = yabi_add(a, r);
+        CHECK(yabi_cmp_si(s, 1) == 0, "a + (1 - a) of %zu words", n);
+#ifndef YABI_POOL
+        CHECK(s->cap == s->len, "a BigInt shrunk to %zu words claims %zu words of room", s->len, s->cap);
+#endif
+        BigInt* ref = yabi_add(a, a);
+        yabi_add_into(&s, a, a);
+        CHECK(yabi_equal(s, ref), "add_into a shrunk BigInt, %zu words", n);
+        yabi_addmul(&s, a, a);
+        yabi_release(ref);
+        yabi_release(s);
+        yabi_release(r);
+        yabi_release(na);
+        yabi_release(a);
+    }
+}
+
+int main(void) {
+    size_t t = YABI_KARATSUBA_THRESHOLD;
+    // operand lengths on both sides of the threshold for addmul and submul
+    size_t lens[][2] = { { 1, 1 }, { 5, 3 }, { t - 1, t - 1 }, { t - 1, 3 * t }, { t, t }, { t + 1, 2 * t + 3 } };
+    size_t dlens[] = { 0, 1, 4, t, 6 * t };
+    for(int op = 0; op < OPS; op++) {
+        for(size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+            for(size_t j = 0; j < sizeof(dlens) / sizeof(dlens[0]); j++) {
+                testOp(op, dlens[j], 0, lens[i][0], lens[i][1]);
+                testOp(op, dlens[j], 8 * t, lens[i][0], lens[i][1]);
+            }
+            testAliased(op, lens[i][0], lens[i][1], 0);
+            testAliased(op, lens[i][0], lens[i][1], 8 * t);
+        }
+    }
+    testGrowth();
+    testShrunkCapacity();
+    return finish("into");
+}
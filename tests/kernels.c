@@ -0,0 +1,168 @@
+#include "common.h"
+#include "bigint_internal.h"
+
+// The bitwise operations, shifts, comparisons and batch additions and
+// comparisons at each kernel level the processor supports, against the
+// portable loops. Every level is fed the same inputs, and all it produces
+// is logged and compared with what level 0 logged. Rows run from shorter
+// than ROW_KERNEL_BYTES to many vectors with a ragged tail. Build from the
+// top of the tree with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/kernels.c -pthread
+
+typedef struct {
+    uint64_t* data;
+    size_t len;
+    size_t cap;
+} resultLog;
+
+static void logValue(resultLog* l, uint64_t v) {
+    if(l->len == l->cap) {
+        l->cap = l->cap ? 2 * l->cap : 1024;
+        l->data = realloc(l->data, l->cap * sizeof(uint64_t));
+    }
+    l->data[l->len++] = v;
+}
+
+static void logWords(resultLog* l, size_t n, const WordType* w) {
+    logValue(l, n);
+    for(size_t i = 0; i < n; i++) {
+        logValue(l, w[i]);
+    }
+}
+
+// a number of n words, which only differs from `like` above word k when
+// it is given
+static BigInt* rndLike(size_t n, const BigInt* like, size_t k) {
+    BigInt* a = rndBigInt(n, rnd() & 1);
+    if(like) {
+        for(size_t i = k; i < n && i < like->len; i++) {
+            a->data[i] = like->data[i];
+        }
+    }
+    return a;
+}
+
+static void runBinary(resultLog* l, const BigInt* a, const BigInt* b) {
+    size_t n = (a->len > b->len ? a->len : b->len) + 1;
+    WordType* buf = malloc(n * sizeof(WordType));
+    size_t len = yabi_andToBuf(a, b, n, buf);
+    logWords(l, len, buf);
+    len = yabi_orToBuf(a, b, n, buf);
+    logWords(l, len, buf);
+    len = yabi_xorToBuf(a, b, n, buf);
+    logWords(l, len, buf);
+    // truncated
+    len = yabi_xorToBuf(a, b, n / 2 + 1, buf);
+    logWords(l, len, buf);
+    logValue(l, (uint64_t)yabi_cmp(a, b));
+    logValue(l, (uint64_t)yabi_equal(a, b));
+    free(buf);
+}
+
+static void runUnary(resultLog* l, const BigInt* a) {
+    size_t n = a->len + 4;
+    WordType* buf = malloc(n * sizeof(WordType));
+    size_t len = yabi_complToBuf(a, n, buf);
+    logWords(l, len, buf);
+    size_t amts[] = { 0, 1, YABI_WORD_BIT_SIZE - 1, YABI_WORD_BIT_SIZE, YABI_WORD_BIT_SIZE + 3, 2 * YABI_WORD_BIT_SIZE + 5 };
+    for(size_t i = 0; i < sizeof(amts) / sizeof(amts[0]); i++) {
+        len = yabi_lshiftToBuf(a, amts[i], n, buf);
+        logWords(l, len, buf);
+        len = yabi_rshiftToBuf(a, amts[i], n, buf);
+        logWords(l, len, buf);
+    }
+    // in place
+    BigInt* c = yabi_compl(a);
+    len = yabi_rshiftToBuf(c, 3, c->len, c->data);
+    logWords(l, len, c->data);
+    yabi_release(c);
+    free(buf);
+}
+
+static void runBatch(resultLog* l, size_t count, size_t len) {
+    WordType* a = malloc(count * len * sizeof(WordType));
+    WordType* b = malloc(count * len * sizeof(WordType));
+    WordType* r = malloc(count * (len + 1) * sizeof(WordType));
+    int8_t* c = malloc(count);
+    for(size_t i = 0; i < count * len; i++) {
+        a[i] = rndWord();
+        b[i] = rnd() % 4 == 0 ? a[i] : rndWord();
+    }
+    // columns, which the vector kernels take
+    yabi_batch_t ba = { a, 1, count };
+    yabi_batch_t bb = { b, 1, count };
+    yabi_batch_t br = { r, 1, count };
+    yabi_batch_add(count, len, &ba, &bb, len + 1, &br);
+    logWords(l, count * (len + 1), r);
+    yabi_batch_sub(count, len, &ba, &bb, len, &br);
+    logWords(l, count * len, r);
+    yabi_batch_cmp(count, len, &ba, &bb, c);
+    for(size_t i = 0; i < count; i++) {
+        logValue(l, (uint64_t)c[i]);
+    }
+    free(c);
+    free(r);
+    free(b);
+    free(a);
+}
+
+// everything logged for the inputs that come from `seed`
+static void runAll(resultLog* l, uint64_t seed) {
+    rngState = seed;
+    size_t vector = 64 / sizeof(WordType);
+    size_t lens[] = { 1, 2, 3, vector / 2 - 1, vector / 2, vector - 1, vector, vector + 1,
+        2 * vector - 1, 3 * vector + 5, 16 * vector + 7 };
+    size_t count = sizeof(lens) / sizeof(lens[0]);
+    for(size_t i = 0; i < count; i++) {
+        for(size_t j = 0; j < count; j++) {
+            BigInt* a = rndLike(lens[i], NULL, 0);
+            BigInt* b = rndLike(lens[j], NULL, 0);
+            runBinary(l, a, b);
+            yabi_release(b);
+            // equal up to a random word, for the scans of comparisons
+            b = rndLike(lens[i], a, (size_t)(rnd() % lens[i]));
+            runBinary(l, a, b);
+            yabi_release(b);
+            yabi_release(a);
+        }
+        BigInt* a = rndLike(lens[i], NULL, 0);
+        runUnary(l, a);
+        runBinary(l, a, a);
+        yabi_release(a);
+        // a long run of sign words
+        a = rndLike(lens[i], NULL, 0);
+        WordType fill = (WordType)-(WordType)(rnd() & 1);
+        for(size_t k = 1; k < lens[i]; k++) {
+            a->data[k] = fill;
+        }
+        runUnary(l, a);
+        yabi_release(a);
+        runBatch(l, lens[i], 1 + rnd() % 3);
+    }
+}
+
+int main(void) {
+    resultLog ref = { NULL, 0, 0 };
+    useKernelLevel(0);
+    runAll(&ref, 1);
+    for(int level = 1; level <= 3; level++) {
+        int got = useKernelLevel(level);
+        if(got != level) {
+            printf("kernel level %d is not available here, skipped\n", level);
+            continue;
+        }
+        resultLog l = { NULL, 0, 0 };
+        runAll(&l, 1);
+        CHECK(l.len == ref.len, "kernel level %d logged %zu values, not %zu", level, l.len, ref.len);
+        size_t n = l.len < ref.len ? l.len : ref.len;
+        size_t i = 0;
+        while(i < n && l.data[i] == ref.data[i]) {
+            i++;
+        }
+        CHECK(i == n, "kernel level %d differs from the portable loops at value %zu", level, i);
+        free(l.data);
+    }
+    free(ref.data);
+    return finish("kernels");
+}
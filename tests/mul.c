@@ -0,0 +1,145 @@
+#include "common.h"
+
+// Products on both sides of YABI_NTT_THRESHOLD, checked against a
+// schoolbook product of 32 bit limbs done here, and squares on both sides
+// of every squaring threshold against the product of two copies of the
+// number, which takes the multiplication path. Build from the top of the
+// tree with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/mul.c -pthread
+
+// the magnitude of a as 32 bit limbs, low limb first. Returns their count
+static size_t toLimbs(const BigInt* a, uint32_t** limbs) {
+    BigInt* m = absOf(a);
+    size_t n = (m->len * YABI_WORD_BIT_SIZE + 31) / 32;
+    uint32_t* out = calloc(n, sizeof(uint32_t));
+    for(size_t i = 0; i < m->len; i++) {
+        uint64_t w = m->data[i];
+        size_t bit = i * YABI_WORD_BIT_SIZE;
+        for(int k = 0; k < YABI_WORD_BIT_SIZE; k += 32 < YABI_WORD_BIT_SIZE ? 32 : YABI_WORD_BIT_SIZE) {
+            out[(bit + k) / 32] |= (uint32_t)((w >> k) << ((bit + k) % 32));
+        }
+    }
+    yabi_release(m);
+    while(n > 0 && out[n - 1] == 0) {
+        n--;
+    }
+    *limbs = out;
+    return n;
+}
+
+static int checkProduct(const BigInt* a, const BigInt* b, const BigInt* p) {
+    uint32_t* x;
+    uint32_t* y;
+    uint32_t* z;
+    size_t xn = toLimbs(a, &x);
+    size_t yn = toLimbs(b, &y);
+    size_t zn = toLimbs(p, &z);
+    uint32_t* ref = calloc(xn + yn + 1, sizeof(uint32_t));
+    for(size_t i = 0; i < xn; i++) {
+        uint64_t carry = 0;
+        for(size_t j = 0; j < yn; j++) {
+            uint64_t t = (uint64_t)x[i] * y[j] + ref[i + j] + carry;
+            ref[i + j] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        ref[i + yn] = (uint32_t)carry;
+    }
+    size_t rn = xn + yn;
+    while(rn > 0 && ref[rn - 1] == 0) {
+        rn--;
+    }
+    int ok = rn == zn && memcmp(ref, z, rn * sizeof(uint32_t)) == 0;
+    int zero = rn == 0;
+    ok = ok && (zero || isNegative(p) == (isNegative(a) ^ isNegative(b)));
+    free(x);
+    free(y);
+    free(z);
+    free(ref);
+    return ok;
+}
+
+static void testMul(size_t alen, size_t blen, int signs) {
+    BigInt* a = rndBigInt(alen, signs & 1);
+    BigInt* b = rndBigInt(blen, signs >> 1 & 1);
+    BigInt* p = yabi_mul(a, b);
+    CHECK(checkProduct(a, b, p), "mul %zu x %zu words, signs %d", alen, blen, signs);
+    yabi_release(p);
+    // the ToBuf form, truncated to the low words
+    size_t len = (alen + blen) / 2;
+    WordType* buf = malloc(len * sizeof(WordType));
+    p = yabi_mul(a, b);
+    yabi_mulToBuf(a, b, len, buf);
+    size_t n = len < p->len ? len : p->len;
+    CHECK(memcmp(buf, p->data, n * sizeof(WordType)) == 0, "mulToBuf %zu x %zu words", alen, blen);
+    free(buf);
+    yabi_release(p);
+    yabi_release(a);
+    yabi_release(b);
+}
+
+static void testSqr(size_t n, int negative) {
+    BigInt* a = rndBigInt(n, negative);
+    BigInt* p = yabi_sqr(a);
+    CHECK(checkProduct(a, a, p), "sqr %zu words", n);
+    yabi_release(p);
+    yabi_release(a);
+}
+
+// a separate copy of a, so that multiplying by it is not squaring
+static void testSqrAsMul(size_t n, int negative) {
+    BigInt* a = rndBigInt(n, negative);
+    BigInt* copy = fromWords(a->len, a->data);
+    BigInt* s = yabi_sqr(a);
+    BigInt* p = yabi_mul(a, copy);
+    CHECK(yabi_equal(s, p), "sqr %zu words against mul by a copy", n);
+    // and truncated
+    size_t len = n + 1;
+    WordType* sbuf = malloc(len * sizeof(WordType));
+    WordType* pbuf = malloc(len * sizeof(WordType));
+    size_t slen = yabi_sqrToBuf(a, len, sbuf);
+    size_t plen = yabi_mulToBuf(a, copy, len, pbuf);
+    CHECK(slen == plen && memcmp(sbuf, pbuf, len * sizeof(WordType)) == 0, "sqrToBuf %zu words into %zu", n, len);
+    free(pbuf);
+    free(sbuf);
+    yabi_release(p);
+    yabi_release(s);
+    yabi_release(copy);
+    yabi_release(a);
+}
+
+int main(void) {
+    size_t t = YABI_NTT_THRESHOLD;
+    // balanced around the threshold
+    size_t sizes[] = { t - 1, t, t + 1, t + t / 2 + 7 };
+    for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        testMul(sizes[i], sizes[i], (int)i & 3);
+        testSqr(sizes[i], (int)i & 1);
+    }
+    // basecase, Karatsuba, Toom-3 and NTT squaring
+    size_t ks = YABI_SQR_KARATSUBA_THRESHOLD;
+    size_t ts = YABI_TOOM3_THRESHOLD;
+    size_t sqrSizes[] = { 1, 2, ks - 1, ks, ks + 1, (ks + ts) / 2, ts - 1, ts, ts + 1, 3 * ts + 2, t - 1, t, t + 5 };
+    for(size_t i = 0; i < sizeof(sqrSizes) / sizeof(sqrSizes[0]); i++) {
+        testSqrAsMul(sqrSizes[i], 0);
+        testSqrAsMul(sqrSizes[i], 1);
+    }
+    // unbalanced, where only the shorter operand decides
+    testMul(2 * t + 5, t, 1);
+    testMul(3 * t, t - 1, 2);
+    testMul(t + 3, t, 3);
+    // every word all ones, the largest each limb of the transform gets
+    WordType* ones = malloc((t + 1) * sizeof(WordType));
+    memset(ones, 0xff, t * sizeof(WordType));
+    ones[t] = 0;
+    BigInt* a = fromWords(t + 1, ones);
+    BigInt* p = yabi_mul(a, a);
+    CHECK(checkProduct(a, a, p), "mul of all ones");
+    yabi_release(p);
+    p = yabi_sqr(a);
+    CHECK(checkProduct(a, a, p), "sqr of all ones");
+    yabi_release(p);
+    yabi_release(a);
+    free(ones);
+    return finish("mul");
+}
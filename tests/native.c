@@ -0,0 +1,151 @@
+#include "common.h"
+
+// yabi_add, _sub, _mul and _cmp with an int64_t or uint64_t operand against
+// the same functions on a BigInt of that value, in their allocating, ToBuf
+// and _into forms, at 0, the int64_t and uint64_t limits and the word
+// edges, with BigInts that cancel them out, their negations and random
+// values a little shorter and longer than 64 bits. Build from the top of
+// the tree with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/native.c -pthread
+
+#define NATIVE_WORDS (64 / YABI_WORD_BIT_SIZE)
+#define OPERANDS 48
+
+enum { OP_ADD, OP_SUB, OP_MUL, OPS };
+
+static const char* opNames[OPS] = { "add", "sub", "mul" };
+
+// v as a BigInt, read as unsigned or as an int64_t, built from its words so
+// that none of the functions under test take part
+static BigInt* bigOf(uint64_t v, int isSigned) {
+    WordType w[NATIVE_WORDS + 1];
+    for(int i = 0; i < NATIVE_WORDS; i++) {
+        w[i] = (WordType)(v >> (i * YABI_WORD_BIT_SIZE));
+    }
+    w[NATIVE_WORDS] = isSigned && (int64_t)v < 0 ? (WordType)~(WordType)0 : 0;
+    BigInt* t = fromWords(NATIVE_WORDS + 1, w);
+    BigInt* zero = yabi_sub(t, t);
+    BigInt* res = yabi_add(t, zero);
+    yabi_release(zero);
+    yabi_release(t);
+    return res;
+}
+
+static BigInt* bigOp(int op, const BigInt* a, const BigInt* b) {
+    switch(op) {
+    case OP_ADD: return yabi_add(a, b);
+    case OP_SUB: return yabi_sub(a, b);
+    default: return yabi_mul(a, b);
+    }
+}
+
+static size_t bigOpToBuf(int op, const BigInt* a, const BigInt* b, size_t len, WordType* buf) {
+    switch(op) {
+    case OP_ADD: return yabi_addToBuf(a, b, len, buf);
+    case OP_SUB: return yabi_subToBuf(a, b, len, buf);
+    default: return yabi_mulToBuf(a, b, len, buf);
+    }
+}
+
+static BigInt* nativeOp(int op, int isSigned, const BigInt* a, uint64_t v) {
+    switch(op) {
+    case OP_ADD: return isSigned ? yabi_add_si(a, (int64_t)v) : yabi_add_ui(a, v);
+    case OP_SUB: return isSigned ? yabi_sub_si(a, (int64_t)v) : yabi_sub_ui(a, v);
+    default: return isSigned ? yabi_mul_si(a, (int64_t)v) : yabi_mul_ui(a, v);
+    }
+}
+
+static size_t nativeOpToBuf(int op, int isSigned, const BigInt* a, uint64_t v, size_t len, WordType* buf) {
+    switch(op) {
+    case OP_ADD: return isSigned ? yabi_add_siToBuf(a, (int64_t)v, len, buf) : yabi_add_uiToBuf(a, v, len, buf);
+    case OP_SUB: return isSigned ? yabi_sub_siToBuf(a, (int64_t)v, len, buf) : yabi_sub_uiToBuf(a, v, len, buf);
+    default: return isSigned ? yabi_mul_siToBuf(a, (int64_t)v, len, buf) : yabi_mul_uiToBuf(a, v, len, buf);
+    }
+}
+
+static BigInt* nativeOpInto(int op, int isSigned, BigInt** dst, const BigInt* a, uint64_t v) {
+    switch(op) {
+    case OP_ADD: return isSigned ? yabi_add_si_into(dst, a, (int64_t)v) : yabi_add_ui_into(dst, a, v);
+    case OP_SUB: return isSigned ? yabi_sub_si_into(dst, a, (int64_t)v) : yabi_sub_ui_into(dst, a, v);
+    default: return isSigned ? yabi_mul_si_into(dst, a, (int64_t)v) : yabi_mul_ui_into(dst, a, v);
+    }
+}
+
+static void check(const BigInt* a, uint64_t v, int isSigned) {
+    const char* type = isSigned ? "si" : "ui";
+    BigInt* b = bigOf(v, isSigned);
+    int c = yabi_cmp(a, b);
+    int got = isSigned ? yabi_cmp_si(a, (int64_t)v) : yabi_cmp_ui(a, v);
+    CHECK((got > 0) - (got < 0) == (c > 0) - (c < 0), "cmp_%s of %zu words and %#llx", type, a->len,
+        (unsigned long long)v);
+    size_t most = a->len + NATIVE_WORDS + 2;
+    WordType* ref = malloc(most * sizeof(WordType));
+    WordType* buf = malloc(most * sizeof(WordType));
+    for(int op = 0; op < OPS; op++) {
+        BigInt* want = bigOp(op, a, b);
+        BigInt* res = nativeOp(op, isSigned, a, v);
+        CHECK(yabi_equal(res, want), "%s_%s of %zu words and %#llx", opNames[op], type, a->len, (unsigned long long)v);
+        yabi_release(res);
+        // truncated, exact and sign-extended
+        size_t lens[] = { 1, want->len, most };
+        for(size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+            size_t wlen = bigOpToBuf(op, a, b, lens[i], ref);
+            size_t glen = nativeOpToBuf(op, isSigned, a, v, lens[i], buf);
+            CHECK(glen == wlen && memcmp(buf, ref, lens[i] * sizeof(WordType)) == 0,
+                "%s_%sToBuf of %zu words and %#llx into %zu", opNames[op], type, a->len, (unsigned long long)v, lens[i]);
+        }
+        // into a NULL *dst, and into *dst as the operand
+        BigInt* d = NULL;
+        nativeOpInto(op, isSigned, &d, a, v);
+        CHECK(yabi_equal(d, want), "%s_%s_into a NULL *dst, %zu words and %#llx", opNames[op], type, a->len,
+            (unsigned long long)v);
+        yabi_release(d);
+        // a copy of a of its own
+        d = yabi_negate(a);
+        yabi_negate_into(&d, d);
+        nativeOpInto(op, isSigned, &d, d, v);
+        CHECK(yabi_equal(d, want), "%s_%s_into *dst as the operand, %zu words and %#llx", opNames[op], type, a->len,
+            (unsigned long long)v);
+        yabi_release(d);
+        yabi_release(want);
+    }
+    free(buf);
+    free(ref);
+    yabi_release(b);
+}
+
+int main(void) {
+    uint64_t half = (uint64_t)1 << (YABI_WORD_BIT_SIZE - 1);
+    int64_t sis[] = { 0, 1, -1, 2, -2, INT64_MIN, INT64_MIN + 1, INT64_MAX, INT64_MAX - 1, (int64_t)(half - 1),
+        -(int64_t)(half - 1) - 1, (int64_t)(2 * half - 1), (int64_t)rnd(), -(int64_t)(rnd() >> 1) };
+    uint64_t uis[] = { 0, 1, 2, UINT64_MAX, UINT64_MAX - 1, (uint64_t)INT64_MAX, (uint64_t)INT64_MAX + 1, half - 1,
+        half, 2 * half - 1, rnd(), rnd() >> 1 };
+    size_t nsi = sizeof(sis) / sizeof(sis[0]);
+    size_t nui = sizeof(uis) / sizeof(uis[0]);
+    // each value, its negation, so that sums cancel, and random values
+    BigInt* as[OPERANDS];
+    size_t n = 0;
+    for(size_t i = 0; i < 8; i++) {
+        as[n++] = bigOf((uint64_t)sis[i], 1);
+        as[n++] = bigOf(uis[i], 0);
+    }
+    for(size_t i = 0; i < 16; i++) {
+        as[n++] = yabi_negate(as[i]);
+    }
+    for(; n < OPERANDS; n++) {
+        as[n] = rndBigInt(1 + n % (NATIVE_WORDS + 3), n & 1);
+    }
+    for(size_t i = 0; i < OPERANDS; i++) {
+        for(size_t j = 0; j < nsi; j++) {
+            check(as[i], (uint64_t)sis[j], 1);
+        }
+        for(size_t j = 0; j < nui; j++) {
+            check(as[i], uis[j], 0);
+        }
+    }
+    for(size_t i = 0; i < OPERANDS; i++) {
+        yabi_release(as[i]);
+    }
+    return finish("native");
+}
@@ -0,0 +1,205 @@
+#include "common.h"
+#include <pthread.h>
+
+// The pool allocator across threads: BigInts taken on one thread and freed
+// on another go back to the thread that took them, the cache of a thread
+// that exits is adopted by the next one with everything it holds, resizing
+// within a size class keeps a BigInt where it is, and yabi_pool_reset gives
+// back all of a thread's memory, which LeakSanitizer checks when built with
+// -fsanitize=address. Build from the top of the tree with, for any word
+// size,
+//
+//     cc -DYABI_POOL -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/pool.c -pthread
+
+#ifndef YABI_POOL
+    #error tests/pool.c needs -DYABI_POOL
+#endif
+
+#define BLOCKS 64
+
+static BigInt* newFilled(size_t len, WordType seed) {
+    BigInt* a = yabi_pool_new(len);
+    a->refCount = 0;
+    a->len = len;
+    a->cap = len;
+    for(size_t i = 0; i < len; i++) {
+        a->data[i] = (WordType)(seed + i);
+    }
+    return a;
+}
+
+static int isFilled(const BigInt* a, size_t len, WordType seed) {
+    for(size_t i = 0; i < len; i++) {
+        if(a->data[i] != (WordType)(seed + i)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int contains(BigInt** set, size_t n, const BigInt* a) {
+    for(size_t i = 0; i < n; i++) {
+        if(set[i] == a) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void* freeBlocks(void* arg) {
+    BigInt** blocks = arg;
+    for(int i = 0; i < BLOCKS; i++) {
+        yabi_pool_free(blocks[i]);
+    }
+    // leaves an empty cache behind for the orphan test
+    yabi_pool_reset();
+    return NULL;
+}
+
+// products taken on the main thread, checked and released on another
+typedef struct {
+    BigInt* a[BLOCKS];
+    BigInt* b[BLOCKS];
+    BigInt* p[BLOCKS];
+} products;
+
+static void* checkProducts(void* arg) {
+    products* ps = arg;
+    for(int i = 0; i < BLOCKS; i++) {
+        ydiv_t qr = yabi_div(ps->p[i], ps->a[i]);
+        CHECK(yabi_equal(qr.quo, ps->b[i]) && yabi_cmp_si(qr.rem, 0) == 0, "product %d read on another thread", i);
+        yabi_release(qr.quo);
+        yabi_release(qr.rem);
+        yabi_release(ps->p[i]);
+        yabi_release(ps->a[i]);
+        yabi_release(ps->b[i]);
+    }
+    yabi_pool_reset();
+    return NULL;
+}
+
+static void runThread(void* (*fn)(void*), void* arg) {
+    pthread_t t;
+    pthread_create(&t, NULL, fn, arg);
+    pthread_join(t, NULL);
+}
+
+// blocks freed on another thread come back from the remote list once the
+// free list of their class runs dry
+static void testRemoteFree(void) {
+    BigInt* first[BLOCKS];
+    BigInt* again[BLOCKS];
+    for(int i = 0; i < BLOCKS; i++) {
+        first[i] = newFilled(4, (WordType)i);
+    }
+    runThread(freeBlocks, first);
+    for(int i = 0; i < BLOCKS; i++) {
+        again[i] = newFilled(4, (WordType)i);
+        CHECK(contains(first, BLOCKS, again[i]), "block %d freed on another thread was not reused", i);
+    }
+    for(int i = 0; i < BLOCKS; i++) {
+        yabi_pool_free(again[i]);
+    }
+    // the library's own BigInts, released on another thread, so that they
+    // wait on the remote list for the reset
+    products ps;
+    for(int i = 0; i < BLOCKS; i++) {
+        ps.a[i] = rndBigInt(1 + (size_t)i * 3, i & 1);
+        ps.b[i] = rndBigInt(1 + (size_t)i * 5, i >> 1 & 1);
+        ps.p[i] = yabi_mul(ps.a[i], ps.b[i]);
+    }
+    runThread(checkProducts, &ps);
+    // a big block, which only the reset frees
+    newFilled(70000 / sizeof(WordType), 3);
+    yabi_pool_reset();
+}
+
+// a thread that takes x and y, gives x back and exits, leaving y out
+typedef struct {
+    BigInt* x;
+    BigInt* y;
+    BigInt* big;
+} leftovers;
+
+static void* leaveCache(void* arg) {
+    leftovers* l = arg;
+    l->x = newFilled(2, 1);
+    l->y = newFilled(40, 2);
+    l->big = newFilled(100000 / sizeof(WordType), 3);
+    yabi_pool_free(l->x);
+    return NULL;
+}
+
+// the adopting thread gets x from the free list it inherited and y from
+// the remote list, then resets the cache with all it holds
+static void* adoptCache(void* arg) {
+    leftovers* l = arg;
+    BigInt* x = newFilled(2, 4);
+    CHECK(x == l->x, "the adopted cache's free list was not used");
+    BigInt* y = newFilled(40, 5);
+    CHECK(y == l->y, "a block freed into an orphaned cache was not reused");
+    CHECK(isFilled(l->big, 100000 / sizeof(WordType), 3), "a big block of an orphaned cache lost its value");
+    yabi_pool_reset();
+    return NULL;
+}
+
+static void testOrphans(void) {
+    leftovers l;
+    runThread(leaveCache, &l);
+    // still valid after the thread is gone, and freeable here
+    CHECK(isFilled(l.y, 40, 2), "a block of an exited thread lost its value");
+    yabi_pool_free(l.y);
+    runThread(adoptCache, &l);
+}
+
+static void testResize(void) {
+    BigInt* a = newFilled(3, 7);
+    // shrinking within the class keeps the block, and all of it usable
+    BigInt* r = yabi_pool_resize(a, 1);
+    CHECK(r == a && r->len == 1 && r->cap >= 3 && isFilled(r, 1, 7), "resize to one word moved the BigInt");
+    size_t cap = r->cap;
+    r = yabi_pool_resize(r, cap);
+    CHECK(r == a && r->len == cap && r->cap == cap && isFilled(r, 1, 7), "resize to the class capacity moved the BigInt");
+    // one more word needs the next class
+    r = yabi_pool_resize(r, cap + 1);
+    CHECK(r->len == cap + 1 && r->cap >= cap + 1 && isFilled(r, 1, 7), "resize past the class lost the value");
+    // into a big block and back
+    for(size_t i = 0; i < r->len; i++) {
+        r->data[i] = (WordType)(7 + i);
+    }
+    size_t len = r->len;
+    r = yabi_pool_resize(r, 200000 / sizeof(WordType));
+    CHECK(isFilled(r, len, 7), "resize into a big block lost the value");
+    r = yabi_pool_resize(r, 2);
+    CHECK(r->len == 2 && isFilled(r, 2, 7), "resize out of a big block lost the value");
+    yabi_pool_free(r);
+    // and the resizes the library does itself
+    BigInt* x = rndBigInt(10, 0);
+    BigInt* y = rndBigInt(10, 1);
+    BigInt* s = yabi_add(x, y);
+    BigInt* ref = yabi_sub(s, y);
+    CHECK(yabi_equal(ref, x), "add and sub from the pool");
+    yabi_release(ref);
+    yabi_release(s);
+    yabi_release(y);
+    yabi_release(x);
+}
+
+int main(void) {
+    testRemoteFree();
+    testOrphans();
+    testResize();
+    // everything taken here so far, and more, is freed at once
+    for(int i = 0; i < BLOCKS; i++) {
+        BigInt* a = rndBigInt(1 + (size_t)i * 7, i & 1);
+        (void)yabi_sqr(a);
+    }
+    yabi_pool_reset();
+    // and the pool still works after a reset
+    BigInt* a = rndBigInt(12, 1);
+    BigInt* p = yabi_mul(a, a);
+    BigInt* q = yabi_sqr(a);
+    CHECK(yabi_equal(p, q), "mul and sqr after a reset");
+    yabi_pool_reset();
+    return finish("pool");
+}
@@ -0,0 +1,81 @@
+#include "common.h"
+
+// yabi_powmod against square and multiply with yabi_mul and yabi_div, for
+// moduli of one word up to a few hundred, negative bases, bases longer than
+// the modulus, and exponents long enough for every window size. Build from
+// the top of the tree with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/powmod.c -pthread
+
+static BigInt* refPowmod(const BigInt* base, const BigInt* exp, const BigInt* m) {
+    BigInt* r = modOf(base, m);
+    BigInt* acc = yabi_sub(r, r);
+    BigInt* one = yabi_add_si(acc, 1);
+    yabi_release(acc);
+    acc = modOf(one, m);
+    yabi_release(one);
+    for(size_t i = exp->len; i > 0; i--) {
+        for(int k = YABI_WORD_BIT_SIZE; k > 0; k--) {
+            BigInt* t = yabi_sqr(acc);
+            yabi_release(acc);
+            acc = modOf(t, m);
+            yabi_release(t);
+            if(exp->data[i - 1] >> (k - 1) & 1) {
+                t = yabi_mul(acc, r);
+                yabi_release(acc);
+                acc = modOf(t, m);
+                yabi_release(t);
+            }
+        }
+    }
+    yabi_release(r);
+    return acc;
+}
+
+static void testPowmod(size_t mlen, size_t blen, size_t elen) {
+    for(int negative = 0; negative < 2; negative++) {
+        BigInt* m = rndBigInt(mlen, 0);
+        // Montgomery form needs an odd modulus
+        m->data[0] |= 1;
+        BigInt* base = rndBigInt(blen, negative);
+        BigInt* exp = rndBigInt(elen, 0);
+        BigInt* res = yabi_powmod(base, exp, m);
+        BigInt* ref = refPowmod(base, exp, m);
+        CHECK(res && yabi_equal(res, ref), "powmod %zu word modulus, %zu word base, %zu word exponent", mlen, blen, elen);
+        yabi_release(ref);
+        yabi_release(res);
+        yabi_release(exp);
+        yabi_release(base);
+        yabi_release(m);
+    }
+}
+
+int main(void) {
+    size_t words = 64 / YABI_WORD_BIT_SIZE;
+    testPowmod(1, 1, 1);
+    testPowmod(1, 3, 2);
+    testPowmod(words, words, words);
+    testPowmod(words + 1, 4 * words, 3);
+    testPowmod(8 * words, 8 * words, 8 * words);
+    // exponents past the largest window limit
+    testPowmod(4 * words, 2, 1400 / YABI_WORD_BIT_SIZE + 1);
+    testPowmod(64, 200, 2);
+    // exponent 0, and a negative one, which gives NULL
+    BigInt* m = rndBigInt(3, 0);
+    m->data[0] |= 1;
+    BigInt* base = rndBigInt(5, 1);
+    BigInt* zero = yabi_sub(base, base);
+    BigInt* res = yabi_powmod(base, zero, m);
+    CHECK(res && yabi_cmp_si(res, 1) == 0, "powmod with exponent 0");
+    yabi_release(res);
+    BigInt* minusOne = yabi_sub_si(zero, 1);
+    CHECK(yabi_powmod(base, minusOne, m) == NULL, "powmod with a negative exponent");
+    // an even modulus has no Montgomery form
+    m->data[0] &= (WordType)~(WordType)1;
+    CHECK(yabi_powmod(base, zero, m) == NULL, "powmod with an even modulus");
+    yabi_release(minusOne);
+    yabi_release(zero);
+    yabi_release(base);
+    yabi_release(m);
+    return finish("powmod");
+}
@@ -0,0 +1,151 @@
+#include "common.h"
+#include <pthread.h>
+
+// A *dst that yabi_retain has given another owner keeps its value through
+// the _into functions, yabi_addmul and yabi_submul, also when it is one or
+// both of their operands, and only the caller's reference to it is
+// dropped. With YABI_ATOMIC_REFCOUNT the same holds for threads writing
+// into their own references to one BigInt at once. Build from the top of
+// the tree with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/shared.c -pthread
+//
+// and once more with -DYABI_ATOMIC_REFCOUNT
+
+enum { OP_ADD, OP_SUB, OP_MUL, OP_SQR, OP_NEGATE, OP_LSHIFT, OP_ADD_SI, OP_ADDMUL, OP_SUBMUL, OPS };
+
+static const char* opNames[OPS] = { "add_into", "sub_into", "mul_into", "sqr_into", "negate_into", "lshift_into",
+    "add_si_into", "addmul", "submul" };
+
+static BigInt* refOp(int op, const BigInt* d, const BigInt* a, const BigInt* b) {
+    BigInt* p;
+    BigInt* res;
+    switch(op) {
+    case OP_ADD: return yabi_add(a, b);
+    case OP_SUB: return yabi_sub(a, b);
+    case OP_MUL: return yabi_mul(a, b);
+    case OP_SQR: return yabi_sqr(a);
+    case OP_NEGATE: return yabi_negate(a);
+    case OP_LSHIFT: return yabi_lshift(a, 5);
+    case OP_ADD_SI: return yabi_add_si(a, -7);
+    default:
+        p = yabi_mul(a, b);
+        res = op == OP_ADDMUL ? yabi_add(d, p) : yabi_sub(d, p);
+        yabi_release(p);
+        return res;
+    }
+}
+
+static BigInt* runOp(int op, BigInt** dst, const BigInt* a, const BigInt* b) {
+    switch(op) {
+    case OP_ADD: return yabi_add_into(dst, a, b);
+    case OP_SUB: return yabi_sub_into(dst, a, b);
+    case OP_MUL: return yabi_mul_into(dst, a, b);
+    case OP_SQR: return yabi_sqr_into(dst, a);
+    case OP_NEGATE: return yabi_negate_into(dst, a);
+    case OP_LSHIFT: return yabi_lshift_into(dst, a, 5);
+    case OP_ADD_SI: return yabi_add_si_into(dst, a, -7);
+    case OP_ADDMUL: return yabi_addmul(dst, a, b);
+    default: return yabi_submul(dst, a, b);
+    }
+}
+
+// which operands *dst stands in for
+enum { AS_NEITHER, AS_A, AS_B, AS_BOTH };
+
+static const char* roleNames[4] = { "neither operand", "a", "b", "both operands" };
+
+static void testOp(int op, int role, size_t dlen, size_t alen, size_t blen) {
+    BigInt* shared = rndBigInt(dlen, rnd() & 1);
+    BigInt* a = rndBigInt(alen, rnd() & 1);
+    BigInt* b = rndBigInt(blen, rnd() & 1);
+    BigInt* copy = yabi_add_si(shared, 0);
+    const BigInt* x = role == AS_A || role == AS_BOTH ? shared : a;
+    const BigInt* y = role == AS_B || role == AS_BOTH ? shared : b;
+    BigInt* ref = refOp(op, copy, role == AS_A || role == AS_BOTH ? copy : a, role == AS_B || role == AS_BOTH ? copy : b);
+    BigInt* dst = yabi_retain(shared);
+    runOp(op, &dst, x, y);
+    CHECK(dst != shared, "%s wrote into a shared *dst as %s", opNames[op], roleNames[role]);
+    CHECK(yabi_equal(shared, copy), "%s changed a shared *dst as %s, %zu words", opNames[op], roleNames[role], dlen);
+    CHECK(yabi_equal(dst, ref), "%s into a shared *dst as %s, %zu words", opNames[op], roleNames[role], dlen);
+    // the reference *dst held is gone, so one release frees it
+    CHECK(shared->refCount == 0, "%s kept its reference to a shared *dst", opNames[op]);
+    // and the new *dst is its own, written in place from now on
+    BigInt* fresh = dst;
+    if(fresh->cap >= fresh->len + 1) {
+        yabi_negate_into(&dst, dst);
+        CHECK(dst == fresh, "%s left a *dst that is not its own", opNames[op]);
+    }
+    yabi_release(dst);
+    yabi_release(ref);
+    yabi_release(copy);
+    yabi_release(shared);
+    yabi_release(a);
+    yabi_release(b);
+}
+
+#ifdef YABI_ATOMIC_REFCOUNT
+
+#define WRITERS 4
+
+typedef struct {
+    BigInt* dst;
+    const BigInt* a;
+    int op;
+} writer;
+
+static void* writeInto(void* arg) {
+    writer* w = arg;
+    for(int i = 0; i < 200; i++) {
+        BigInt* own = yabi_retain(w->dst);
+        runOp(w->op, &own, own, w->a);
+        yabi_release(own);
+    }
+    runOp(w->op, &w->dst, w->dst, w->a);
+    return NULL;
+}
+
+// threads holding references to one BigInt each write into theirs
+static void testThreads(void) {
+    BigInt* shared = rndBigInt(40, 1);
+    BigInt* a = rndBigInt(30, 0);
+    BigInt* copy = yabi_add_si(shared, 0);
+    pthread_t threads[WRITERS];
+    writer ws[WRITERS];
+    for(int i = 0; i < WRITERS; i++) {
+        ws[i].dst = yabi_retain(shared);
+        ws[i].a = a;
+        ws[i].op = i % 2 ? OP_ADDMUL : OP_ADD;
+        pthread_create(&threads[i], NULL, writeInto, &ws[i]);
+    }
+    for(int i = 0; i < WRITERS; i++) {
+        pthread_join(threads[i], NULL);
+        BigInt* ref = refOp(ws[i].op, copy, copy, a);
+        CHECK(yabi_equal(ws[i].dst, ref), "thread %d wrote the wrong value", i);
+        yabi_release(ref);
+        yabi_release(ws[i].dst);
+    }
+    CHECK(yabi_equal(shared, copy) && shared->refCount == 0, "threads changed a shared value");
+    yabi_release(copy);
+    yabi_release(a);
+    yabi_release(shared);
+}
+
+#endif
+
+int main(void) {
+    size_t t = YABI_KARATSUBA_THRESHOLD;
+    // fused and unfused products for addmul and submul
+    size_t lens[][3] = { { 1, 1, 1 }, { 3, 2, 5 }, { 10, 2 * t, 2 }, { t + 2, t, t + 1 }, { 4 * t, t + 1, 2 * t } };
+    for(int op = 0; op < OPS; op++) {
+        for(int role = AS_NEITHER; role <= AS_BOTH; role++) {
+            for(size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+                testOp(op, role, lens[i][0], lens[i][1], lens[i][2]);
+            }
+        }
+    }
+#ifdef YABI_ATOMIC_REFCOUNT
+    testThreads();
+#endif
+    return finish("shared");
+}
@@ -0,0 +1,112 @@
+#include "common.h"
+
+// yabi_int_add, _sub, _mul, _negate and _cmp against the BigInt functions,
+// for every pair of a set of values around the edges of the inline range,
+// around the square root of those edges, at the int64_t limits and well
+// past them on the heap. Every result has to be inline exactly when it
+// fits, so results promote on overflow and demote when they come back into
+// range. Build from the top of the tree with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/smallint.c -pthread
+
+// the inline range, one bit short of a pointer
+#define SMALL_MAX ((int64_t)(INTPTR_MAX / 2))
+#define SMALL_MIN (-SMALL_MAX - 1)
+
+#define VALUES 40
+
+static BigInt* bigOfSi(int64_t v) {
+    BigInt* t = rndBigInt(1, 0);
+    BigInt* zero = yabi_sub(t, t);
+    BigInt* res = yabi_add_si(zero, v);
+    yabi_release(zero);
+    yabi_release(t);
+    return res;
+}
+
+static int fitsInline(const BigInt* a) {
+    return yabi_cmp_si(a, SMALL_MAX) <= 0 && yabi_cmp_si(a, SMALL_MIN) >= 0;
+}
+
+// checks x against ref, which it releases, for its value and for being
+// inline exactly when the value fits
+static int same(yabi_int_t x, BigInt* ref) {
+    BigInt* v = yabi_int_to_big(x);
+    int ok = yabi_equal(v, ref) && yabi_int_is_small(x) == fitsInline(ref);
+    int64_t si;
+    int fits = yabi_cmp_si(ref, INT64_MAX) <= 0 && yabi_cmp_si(ref, INT64_MIN) >= 0;
+    ok = ok && yabi_int_get_si(x, &si) == fits && (!fits || yabi_cmp_si(ref, si) == 0);
+    yabi_release(v);
+    yabi_release(ref);
+    return ok;
+}
+
+static void fill(yabi_int_t* xs, BigInt** refs) {
+    int64_t root = (int64_t)1 << (sizeof(intptr_t) * 4 - 1);
+    int64_t natives[] = { 0, 1, -1, 2, -2, SMALL_MAX, SMALL_MAX - 1, SMALL_MIN, SMALL_MIN + 1,
+        SMALL_MAX / 2, SMALL_MIN / 2, root - 1, root, root + 1, -root, -root - 1, 3 * root,
+        INT64_MAX, INT64_MIN, INT64_MAX - 1, INT64_MIN + 1 };
+    size_t n = 0;
+    for(size_t i = 0; i < sizeof(natives) / sizeof(natives[0]); i++) {
+        refs[n] = bigOfSi(natives[i]);
+        xs[n++] = yabi_int_from_si(natives[i]);
+    }
+    // just outside the inline range, on the heap
+    BigInt* edge = bigOfSi(SMALL_MAX);
+    refs[n] = yabi_add_si(edge, 1);
+    xs[n++] = yabi_int_from_big(yabi_add_si(edge, 1));
+    yabi_release(edge);
+    edge = bigOfSi(SMALL_MIN);
+    refs[n] = yabi_sub_si(edge, 1);
+    xs[n++] = yabi_int_from_big(yabi_sub_si(edge, 1));
+    yabi_release(edge);
+    // a BigInt with a small value is held inline
+    refs[n] = bigOfSi(-12345);
+    xs[n++] = yabi_int_from_big(bigOfSi(-12345));
+    while(n < VALUES) {
+        size_t words = n % 3 ? 1 + rnd() % (64 / YABI_WORD_BIT_SIZE) : 1 + rnd() % 40;
+        BigInt* a = rndBigInt(words, rnd() & 1);
+        refs[n] = yabi_retain(a);
+        xs[n++] = yabi_int_from_big(a);
+    }
+}
+
+int main(void) {
+    yabi_int_t xs[VALUES];
+    BigInt* refs[VALUES];
+    fill(xs, refs);
+    for(int i = 0; i < VALUES; i++) {
+        CHECK(same(yabi_int_retain(xs[i]), yabi_retain(refs[i])), "value %d", i);
+        yabi_int_release(xs[i]);
+        yabi_int_t r = yabi_int_negate(xs[i]);
+        CHECK(same(r, yabi_negate(refs[i])), "negate of value %d", i);
+        yabi_int_release(r);
+        for(int j = 0; j < VALUES; j++) {
+            r = yabi_int_add(xs[i], xs[j]);
+            CHECK(same(r, yabi_add(refs[i], refs[j])), "add of values %d and %d", i, j);
+            yabi_int_release(r);
+            r = yabi_int_sub(xs[i], xs[j]);
+            CHECK(same(r, yabi_sub(refs[i], refs[j])), "sub of values %d and %d", i, j);
+            yabi_int_release(r);
+            r = yabi_int_mul(xs[i], xs[j]);
+            CHECK(same(r, yabi_mul(refs[i], refs[j])), "mul of values %d and %d", i, j);
+            yabi_int_release(r);
+            int c = yabi_cmp(refs[i], refs[j]);
+            int got = yabi_int_cmp(xs[i], xs[j]);
+            CHECK((got > 0) - (got < 0) == (c > 0) - (c < 0), "cmp of values %d and %d", i, j);
+        }
+    }
+    // a heap value brought back into range by a chain of operations
+    yabi_int_t big = yabi_int_from_si(INT64_MAX);
+    yabi_int_t sq = yabi_int_mul(big, big);
+    yabi_int_t q = yabi_int_sub(sq, sq);
+    CHECK(yabi_int_is_small(q) && yabi_int_cmp(q, xs[0]) == 0, "x - x of a heap value is not an inline 0");
+    yabi_int_release(q);
+    yabi_int_release(sq);
+    yabi_int_release(big);
+    for(int i = 0; i < VALUES; i++) {
+        yabi_int_release(xs[i]);
+        yabi_release(refs[i]);
+    }
+    return finish("smallint");
+}
@@ -0,0 +1,131 @@
+#include "common.h"
+#include <ctype.h>
+
+// String conversion in every base from 2 to 36 on both sides of
+// YABI_DC_STR_THRESHOLD. Digits are checked against repeated division by
+// the base, and parsing them back, in either case, has to give the same
+// number. yabi_toBufRadix into short buffers has to keep the sign and the
+// lowest digits, and yabi_fromStrRadixToBuf into short buffers has to wrap
+// the way the other ToBuf functions do. Build from the top of the tree
+// with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/strings.c -pthread
+
+static const char digitChars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+// a in base `base` by dividing its magnitude by the base over and over
+static char* refDigits(const BigInt* a, int base) {
+    BigInt* m = absOf(a);
+    size_t cap = m->len * YABI_WORD_BIT_SIZE + 3;
+    char* rev = malloc(cap);
+    size_t n = 0;
+    do {
+        uint64_t r;
+        BigInt* q = yabi_divmod_ui(m, (uint64_t)base, &r);
+        rev[n++] = digitChars[r];
+        yabi_release(m);
+        m = q;
+    } while(yabi_cmp_si(m, 0) != 0);
+    yabi_release(m);
+    char* str = malloc(n + 2);
+    size_t k = 0;
+    if(isNegative(a)) {
+        str[k++] = '-';
+    }
+    while(n > 0) {
+        str[k++] = rev[--n];
+    }
+    str[k] = '\0';
+    free(rev);
+    return str;
+}
+
+static void checkTruncated(const BigInt* a, int base, const char* full) {
+    size_t flen = strlen(full);
+    int negative = full[0] == '-';
+    size_t digits = flen - negative;
+    size_t lens[] = { 1, 2, 3, flen / 2 + 1, flen, flen + 1, flen + 6 };
+    char* buf = malloc(flen + 7);
+    for(size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        size_t len = lens[i];
+        // the sign, and as many of the lowest digits as fit before the NUL
+        size_t keep = 0;
+        size_t sign = 0;
+        if(len > 1) {
+            sign = (size_t)negative;
+            keep = len - 1 - sign < digits ? len - 1 - sign : digits;
+        }
+        memset(buf, '#', flen + 7);
+        size_t got = yabi_toBufRadix(a, base, len, buf);
+        int ok = got == sign + keep && buf[got] == '\0';
+        ok = ok && (!sign || buf[0] == '-') && memcmp(buf + sign, full + flen - keep, keep) == 0;
+        CHECK(ok, "toBufRadix base %d of %zu words into %zu chars", base, a->len, len);
+    }
+    free(buf);
+}
+
+static void checkWrapped(const BigInt* a, int base, const char* str) {
+    size_t lens[] = { 1, 2, a->len / 2 + 1, a->len > 1 ? a->len - 1 : 1, a->len, a->len + 2 };
+    WordType* buf = malloc((a->len + 2) * sizeof(WordType));
+    WordType* ref = malloc((a->len + 2) * sizeof(WordType));
+    for(size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        size_t len = lens[i];
+        size_t want = yabi_add_siToBuf(a, 0, len, ref);
+        size_t got = yabi_fromStrRadixToBuf(str, base, len, buf);
+        CHECK(got == want && memcmp(buf, ref, len * sizeof(WordType)) == 0,
+            "fromStrRadixToBuf base %d of %zu words into %zu words", base, a->len, len);
+    }
+    free(ref);
+    free(buf);
+}
+
+static void testBase(int base, size_t n, int negative) {
+    BigInt* a = rndBigInt(n, negative);
+    char* str = yabi_toStrRadix(a, base);
+    char* ref = refDigits(a, base);
+    CHECK(str && strcmp(str, ref) == 0, "toStrRadix base %d of %zu words", base, n);
+    BigInt* back = yabi_fromStrRadix(str, base);
+    CHECK(back && yabi_equal(back, a), "fromStrRadix base %d of %zu words", base, n);
+    yabi_release(back);
+    for(char* c = str; *c; c++) {
+        *c = (char)toupper((unsigned char)*c);
+    }
+    back = yabi_fromStrRadix(str, base);
+    CHECK(back && yabi_equal(back, a), "fromStrRadix base %d of %zu words in upper case", base, n);
+    yabi_release(back);
+    checkTruncated(a, base, ref);
+    checkWrapped(a, base, ref);
+    if(base == 10) {
+        char* dec = yabi_toStr(a);
+        CHECK(strcmp(dec, ref) == 0, "toStr of %zu words", n);
+        back = yabi_fromStr(dec);
+        CHECK(yabi_equal(back, a), "fromStr of %zu words", n);
+        yabi_release(back);
+        free(dec);
+    }
+    free(ref);
+    free(str);
+    yabi_release(a);
+}
+
+int main(void) {
+    size_t t = YABI_DC_STR_THRESHOLD;
+    size_t lens[] = { 1, 3, t - 1, t, t + 1, 3 * t + 5 };
+    for(int base = 2; base <= 36; base++) {
+        for(size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+            testBase(base, lens[i], 0);
+            testBase(base, lens[i], 1);
+        }
+    }
+    // zero, and bases out of range
+    BigInt* a = rndBigInt(2, 1);
+    BigInt* zero = yabi_sub(a, a);
+    char* str = yabi_toStrRadix(zero, 7);
+    CHECK(strcmp(str, "0") == 0, "zero in base 7 is \"%s\"", str);
+    free(str);
+    CHECK(yabi_toStrRadix(a, 1) == NULL && yabi_toStrRadix(a, 37) == NULL, "toStrRadix with an invalid base");
+    CHECK(yabi_fromStrRadix("101", 37) == NULL, "fromStrRadix with an invalid base");
+    yabi_release(zero);
+    yabi_release(a);
+    return finish("strings");
+}
@@ -0,0 +1,186 @@
+#include "common.h"
+#include <pthread.h>
+
+// Multiplication, squaring, division and decimal conversion on operands
+// above YABI_PARALLEL_THRESHOLD, on the calling thread alone, on a pool
+// started with yabi_set_threads and on an executor of this file's own, all
+// of which have to give the same results. Build from the top of the tree
+// with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Iinclude -I. src/*.c tests/threads.c -pthread
+//
+// and add -fsanitize=thread -g to have ThreadSanitizer check the tasks for
+// data races as they spread over the threads
+
+#define OPERANDS 4
+#define EXECUTOR_THREADS 3
+
+typedef struct {
+    BigInt* a[OPERANDS];
+    BigInt* b[OPERANDS];
+} operands;
+
+typedef struct {
+    BigInt* prod[OPERANDS];
+    BigInt* sqr[OPERANDS];
+    BigInt* quo[OPERANDS];
+    BigInt* rem[OPERANDS];
+    char* str[OPERANDS];
+} results;
+
+static void runAll(const operands* in, results* out) {
+    for(int i = 0; i < OPERANDS; i++) {
+        out->prod[i] = yabi_mul(in->a[i], in->b[i]);
+        out->sqr[i] = yabi_sqr(in->a[i]);
+        ydiv_t qr = yabi_div(out->prod[i], in->a[i]);
+        out->quo[i] = qr.quo;
+        out->rem[i] = qr.rem;
+        out->str[i] = yabi_toStr(out->prod[i]);
+    }
+}
+
+static void freeAll(results* r) {
+    for(int i = 0; i < OPERANDS; i++) {
+        yabi_release(r->prod[i]);
+        yabi_release(r->sqr[i]);
+        yabi_release(r->quo[i]);
+        yabi_release(r->rem[i]);
+        free(r->str[i]);
+    }
+}
+
+static void compareAll(const operands* in, const results* ref, const char* mode) {
+    results r;
+    runAll(in, &r);
+    for(int i = 0; i < OPERANDS; i++) {
+        size_t alen = in->a[i]->len;
+        size_t blen = in->b[i]->len;
+        CHECK(yabi_equal(r.prod[i], ref->prod[i]), "%s: mul %zu x %zu words", mode, alen, blen);
+        CHECK(yabi_equal(r.sqr[i], ref->sqr[i]), "%s: sqr %zu words", mode, alen);
+        CHECK(yabi_equal(r.quo[i], ref->quo[i]) && yabi_equal(r.rem[i], ref->rem[i]), "%s: div %zu by %zu words", mode, r.prod[i]->len, alen);
+        CHECK(strcmp(r.str[i], ref->str[i]) == 0, "%s: toStr of %zu words", mode, r.prod[i]->len);
+        BigInt* back = yabi_fromStr(r.str[i]);
+        CHECK(back && yabi_equal(back, ref->prod[i]), "%s: fromStr of %zu digits", mode, strlen(r.str[i]));
+        yabi_release(back);
+    }
+    freeAll(&r);
+}
+
+// an executor of a few threads taking tasks off one locked list, which has
+// to run everything it is handed before it stops
+typedef struct submittedTask {
+    yabi_task_fn task;
+    void* arg;
+    struct submittedTask* next;
+} submittedTask;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    submittedTask* head;
+    submittedTask* tail;
+    int stop;
+    long submitted;
+    pthread_t threads[EXECUTOR_THREADS];
+} testExecutor;
+
+static void submit(yabi_task_fn task, void* arg, void* ctx) {
+    testExecutor* e = ctx;
+    submittedTask* t = malloc(sizeof(submittedTask));
+    t->task = task;
+    t->arg = arg;
+    t->next = NULL;
+    pthread_mutex_lock(&e->lock);
+    if(e->tail) {
+        e->tail->next = t;
+    } else {
+        e->head = t;
+    }
+    e->tail = t;
+    e->submitted++;
+    pthread_cond_signal(&e->wake);
+    pthread_mutex_unlock(&e->lock);
+}
+
+static void* executorThread(void* arg) {
+    testExecutor* e = arg;
+    pthread_mutex_lock(&e->lock);
+    for(;;) {
+        while(!e->head && !e->stop) {
+            pthread_cond_wait(&e->wake, &e->lock);
+        }
+        submittedTask* t = e->head;
+        if(!t) {
+            break;
+        }
+        e->head = t->next;
+        if(!e->head) {
+            e->tail = NULL;
+        }
+        pthread_mutex_unlock(&e->lock);
+        t->task(t->arg);
+        free(t);
+        pthread_mutex_lock(&e->lock);
+    }
+    pthread_mutex_unlock(&e->lock);
+    return NULL;
+}
+
+int main(void) {
+    size_t t = YABI_PARALLEL_THRESHOLD;
+    // balanced, unbalanced and past YABI_NTT_THRESHOLD, with every sign
+    size_t alens[OPERANDS] = { t, t + t / 2 + 3, 2 * t + 1, YABI_NTT_THRESHOLD + 5 };
+    size_t blens[OPERANDS] = { t, 3 * t, t + 7, YABI_NTT_THRESHOLD + 1 };
+    operands in;
+    for(int i = 0; i < OPERANDS; i++) {
+        in.a[i] = rndBigInt(alens[i], i & 1);
+        in.b[i] = rndBigInt(blens[i], i >> 1 & 1);
+    }
+    results ref;
+    CHECK(yabi_set_threads(1) == 0, "yabi_set_threads(1)");
+    runAll(&in, &ref);
+    // the results of one thread hold up on their own
+    for(int i = 0; i < OPERANDS; i++) {
+        BigInt* p = yabi_mul(in.a[i], in.a[i]);
+        CHECK(yabi_equal(p, ref.sqr[i]), "one thread: sqr against mul of %zu words", alens[i]);
+        CHECK(yabi_equal(ref.quo[i], in.b[i]) && yabi_cmp_si(ref.rem[i], 0) == 0, "one thread: a * b / a != b");
+        yabi_release(p);
+    }
+    if(yabi_set_threads(4) == 0) {
+        compareAll(&in, &ref, "four threads");
+        // a second pool replaces the first
+        CHECK(yabi_set_threads(3) == 0, "yabi_set_threads(3)");
+        compareAll(&in, &ref, "three threads");
+        yabi_set_threads(1);
+    } else {
+        printf("no threads in this build, yabi_set_threads(4) skipped\n");
+    }
+    testExecutor e;
+    memset(&e, 0, sizeof(e));
+    pthread_mutex_init(&e.lock, NULL);
+    pthread_cond_init(&e.wake, NULL);
+    for(int i = 0; i < EXECUTOR_THREADS; i++) {
+        pthread_create(&e.threads[i], NULL, executorThread, &e);
+    }
+    yabi_set_executor(submit, &e);
+    compareAll(&in, &ref, "executor");
+    yabi_set_executor(NULL, NULL);
+    pthread_mutex_lock(&e.lock);
+    e.stop = 1;
+    pthread_cond_broadcast(&e.wake);
+    pthread_mutex_unlock(&e.lock);
+    for(int i = 0; i < EXECUTOR_THREADS; i++) {
+        pthread_join(e.threads[i], NULL);
+    }
+    CHECK(e.submitted > 0, "the executor was never handed a task");
+    pthread_cond_destroy(&e.wake);
+    pthread_mutex_destroy(&e.lock);
+    // and back on one thread
+    compareAll(&in, &ref, "one thread again");
+    freeAll(&ref);
+    for(int i = 0; i < OPERANDS; i++) {
+        yabi_release(in.a[i]);
+        yabi_release(in.b[i]);
+    }
+    return finish("threads");
+}
@@ -0,0 +1,190 @@
+#include "common.h"
+
+// The Ws functions given a workspace as long as the _scratch functions ask
+// for do not allocate at all, which a YABI_MALLOC that counts its calls
+// checks, and give what the functions without one give. Products and
+// squares run through every multiplication algorithm, into full and
+// truncated buffers, divisions on both sides of YABI_DC_DIV_THRESHOLD and
+// string conversions on both sides of YABI_DC_STR_THRESHOLD. The counting
+// macros are in tests/counting/bigintcfg.h, so build from the top of the
+// tree with, for any word size,
+//
+//     cc -DYABI_WORD_BIT_SIZE=8 -Itests/counting -Iinclude -I. src/*.c tests/workspace.c -pthread
+
+#ifndef YABI_COUNTED_ALLOCATIONS
+    #error tests/workspace.c needs -Itests/counting ahead of -I.
+#endif
+
+static size_t allocations = 0;
+
+void* countedMalloc(size_t siz) {
+    allocations++;
+    return malloc(siz);
+}
+
+void* countedCalloc(size_t n, size_t siz) {
+    allocations++;
+    return calloc(n, siz);
+}
+
+void* countedRealloc(void* p, size_t siz) {
+    allocations++;
+    return realloc(p, siz);
+}
+
+// a workspace of exactly n words of garbage, since it keeps nothing between
+// calls. Its memory is the test's, so taking it is not counted
+static yabi_workspace_t workspaceOf(size_t n) {
+    yabi_workspace_t ws;
+    ws.len = n;
+    ws.data = malloc((n ? n : 1) * sizeof(WordType));
+    for(size_t i = 0; i < n; i++) {
+        ws.data[i] = rndWord();
+    }
+    return ws;
+}
+
+static void testMul(size_t alen, size_t blen) {
+    BigInt* a = rndBigInt(alen, 1);
+    BigInt* b = rndBigInt(blen, 0);
+    size_t full = alen + blen;
+    size_t lens[] = { full, full / 2 + 1 };
+    WordType* ref = malloc(full * sizeof(WordType));
+    WordType* buf = malloc(full * sizeof(WordType));
+    yabi_workspace_t ws = workspaceOf(yabi_mul_scratch(alen, blen));
+    for(size_t i = 0; i < 2; i++) {
+        size_t want = yabi_mulToBuf(a, b, lens[i], ref);
+        size_t before = allocations;
+        size_t got = yabi_mulToBufWs(a, b, lens[i], buf, &ws);
+        CHECK(allocations == before, "mulToBufWs of %zu and %zu words into %zu allocated %zu times",
+            alen, blen, lens[i], allocations - before);
+        CHECK(got == want && memcmp(buf, ref, lens[i] * sizeof(WordType)) == 0,
+            "mulToBufWs of %zu and %zu words into %zu", alen, blen, lens[i]);
+    }
+    free(ws.data);
+    free(buf);
+    free(ref);
+    yabi_release(a);
+    yabi_release(b);
+}
+
+static void testSqr(size_t alen) {
+    BigInt* a = rndBigInt(alen, 1);
+    size_t lens[] = { 2 * alen, alen + 1 };
+    WordType* ref = malloc(2 * alen * sizeof(WordType));
+    WordType* buf = malloc(2 * alen * sizeof(WordType));
+    yabi_workspace_t ws = workspaceOf(yabi_sqr_scratch(alen));
+    for(size_t i = 0; i < 2; i++) {
+        size_t want = yabi_sqrToBuf(a, lens[i], ref);
+        size_t before = allocations;
+        size_t got = yabi_sqrToBufWs(a, lens[i], buf, &ws);
+        CHECK(allocations == before, "sqrToBufWs of %zu words into %zu allocated %zu times",
+            alen, lens[i], allocations - before);
+        CHECK(got == want && memcmp(buf, ref, lens[i] * sizeof(WordType)) == 0,
+            "sqrToBufWs of %zu words into %zu", alen, lens[i]);
+    }
+    free(ws.data);
+    free(buf);
+    free(ref);
+    yabi_release(a);
+}
+
+static void testDiv(size_t alen, size_t blen) {
+    for(int signs = 0; signs < 4; signs++) {
+        BigInt* a = rndBigInt(alen, signs & 1);
+        BigInt* b = rndBigInt(blen, signs >> 1 & 1);
+        size_t qlen = alen + 1;
+        size_t rlen = blen + 1;
+        WordType* qref = malloc(qlen * sizeof(WordType));
+        WordType* rref = malloc(rlen * sizeof(WordType));
+        WordType* q = malloc(qlen * sizeof(WordType));
+        WordType* r = malloc(rlen * sizeof(WordType));
+        yabi_workspace_t ws = workspaceOf(yabi_div_scratch(alen, blen));
+        ydiv_t want = yabi_divToBuf(a, b, qlen, qref, rlen, rref);
+        size_t before = allocations;
+        ydiv_t got = yabi_divToBufWs(a, b, qlen, q, rlen, r, &ws);
+        CHECK(allocations == before, "divToBufWs of %zu by %zu words allocated %zu times",
+            alen, blen, allocations - before);
+        CHECK(got.qlen == want.qlen && got.rlen == want.rlen && memcmp(q, qref, qlen * sizeof(WordType)) == 0
+            && memcmp(r, rref, rlen * sizeof(WordType)) == 0, "divToBufWs of %zu by %zu words", alen, blen);
+        free(ws.data);
+        free(r);
+        free(q);
+        free(rref);
+        free(qref);
+        yabi_release(a);
+        yabi_release(b);
+    }
+}
+
+static void testStr(size_t alen, int base) {
+    BigInt* a = rndBigInt(alen, 1);
+    char* str = yabi_toStrRadix(a, base);
+    size_t slen = strlen(str) + 1;
+    char* chars = malloc(slen);
+    yabi_workspace_t ws = workspaceOf(yabi_toStr_scratch(alen, base));
+    size_t before = allocations;
+    size_t got = yabi_toBufRadixWs(a, base, slen, chars, &ws);
+    CHECK(allocations == before, "toBufRadixWs base %d of %zu words allocated %zu times",
+        base, alen, allocations - before);
+    CHECK(got == slen - 1 && strcmp(chars, str) == 0, "toBufRadixWs base %d of %zu words", base, alen);
+    free(ws.data);
+    // and back, the digits not counting the sign
+    size_t len = alen + 1;
+    WordType* ref = malloc(len * sizeof(WordType));
+    WordType* buf = malloc(len * sizeof(WordType));
+    ws = workspaceOf(yabi_fromStr_scratch(slen - 2, base));
+    size_t want = yabi_fromStrRadixToBuf(str, base, len, ref);
+    before = allocations;
+    got = yabi_fromStrRadixToBufWs(str, base, len, buf, &ws);
+    CHECK(allocations == before, "fromStrRadixToBufWs base %d of %zu words allocated %zu times",
+        base, alen, allocations - before);
+    CHECK(got == want && memcmp(buf, ref, len * sizeof(WordType)) == 0,
+        "fromStrRadixToBufWs base %d of %zu words", base, alen);
+    free(ws.data);
+    free(buf);
+    free(ref);
+    free(chars);
+    free(str);
+    yabi_release(a);
+}
+
+int main(void) {
+    // the counting is in effect for the library, not just for this file
+    BigInt* a = rndBigInt(3, 0);
+    size_t before = allocations;
+    BigInt* p = yabi_mul(a, a);
+    CHECK(allocations > before, "yabi_mul did not go through the counting YABI_MALLOC");
+    yabi_release(p);
+    yabi_release(a);
+
+    size_t k = YABI_KARATSUBA_THRESHOLD;
+    size_t s = YABI_SQR_KARATSUBA_THRESHOLD;
+    size_t t = YABI_TOOM3_THRESHOLD;
+    size_t n = YABI_NTT_THRESHOLD;
+    // basecase, Karatsuba, unbalanced, Toom-3 and NTT
+    size_t mulLens[][2] = { { 1, 1 }, { 7, 3 }, { k - 1, 5 * k }, { k, k }, { k + 3, 2 * k + 1 }, { 4 * k, k },
+        { t, t }, { t + 5, 2 * t }, { n, n }, { n + 100, n + 7 } };
+    for(size_t i = 0; i < sizeof(mulLens) / sizeof(mulLens[0]); i++) {
+        testMul(mulLens[i][0], mulLens[i][1]);
+    }
+    size_t sqrLens[] = { 1, 9, s - 1, s, s + 1, t, t + 7, n, n + 9 };
+    for(size_t i = 0; i < sizeof(sqrLens) / sizeof(sqrLens[0]); i++) {
+        testSqr(sqrLens[i]);
+    }
+    size_t d = YABI_DC_DIV_THRESHOLD;
+    size_t divLens[][2] = { { 5, 1 }, { 1, 3 }, { 12, 4 }, { 3 * d, d - 1 }, { 3 * d, d }, { 4 * d + 5, 2 * d + 1 },
+        { 10 * d, 3 * d } };
+    for(size_t i = 0; i < sizeof(divLens) / sizeof(divLens[0]); i++) {
+        testDiv(divLens[i][0], divLens[i][1]);
+    }
+    size_t c = YABI_DC_STR_THRESHOLD;
+    size_t strLens[] = { 1, 3, c - 1, c, c + 1, 3 * c + 5, 40 * c };
+    int bases[] = { 2, 7, 10, 16, 36 };
+    for(size_t i = 0; i < sizeof(strLens) / sizeof(strLens[0]); i++) {
+        for(size_t j = 0; j < sizeof(bases) / sizeof(bases[0]); j++) {
+            testStr(strLens[i], bases[j]);
+        }
+    }
+    return finish("workspace");
+}